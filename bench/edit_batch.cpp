@@ -0,0 +1,87 @@
+/**
+ * @brief GridEditBatchによる一括適用と、insert_*, remove_*を逐次呼ぶ場合の比較
+ * @note g++ -std=c++17 -O2 bench/edit_batch.cpp -o edit_batch
+*/
+
+#include "../grid2d.h"
+#include "../grid3d.h"
+#include <chrono>
+#include <cstdio>
+
+using namespace Utility;
+
+template <typename Function>
+double measure_ms(Function const & func){
+    auto const start = std::chrono::steady_clock::now();
+    func();
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(){
+    size_t const size = 512;
+    size_t const depth = 64;
+
+    std::printf("# Grid2D<int> %zux%zu\n", size, size);
+    std::printf("%8s %12s %12s\n", "edits", "batch[ms]", "serial[ms]");
+    for(size_t n : {1, 4, 16, 64}){
+        Grid2D<int> batched(size, size, 1);
+        Grid2D<int> serial(size, size, 1);
+
+        // 列・行の挿入と削除を同数ずつ
+        GridEditBatch<int> batch;
+        for(size_t i=0; i<n; ++i){
+            switch(i % 4){
+                case 0: batch.insert_column(i, 0); break;
+                case 1: batch.insert_row(i, 0); break;
+                case 2: batch.remove_column(size - i); break;
+                case 3: batch.remove_row(size - i); break;
+            }
+        }
+
+        double const batch_ms = measure_ms([&]{ batched.apply_edits(batch); });
+        double const serial_ms = measure_ms([&]{
+            for(size_t i=0; i<n; ++i){
+                switch(i % 4){
+                    case 0: serial.insert_column(i, 0); break;
+                    case 1: serial.insert_row(i, 0); break;
+                    case 2: serial.remove_column(size - i); break;
+                    case 3: serial.remove_row(size - i); break;
+                }
+            }
+        });
+        std::printf("%8zu %12.3f %12.3f\n", n, batch_ms, serial_ms);
+    }
+
+    std::printf("# Grid3D<int> %zux%zux%zu\n", size / 2, size / 2, depth);
+    std::printf("%8s %12s %12s\n", "edits", "batch[ms]", "serial[ms]");
+    for(size_t n : {1, 4, 16, 64}){
+        Grid3D<int> batched(size / 2, size / 2, depth, 1);
+        Grid3D<int> serial(size / 2, size / 2, depth, 1);
+
+        // 行・奥の挿入と削除を同数ずつ
+        GridEditBatch<int> batch;
+        for(size_t i=0; i<n; ++i){
+            switch(i % 4){
+                case 0: batch.insert_row(i, 0); break;
+                case 1: batch.insert_depth(i / 4, 0); break;
+                case 2: batch.remove_row(size / 2 - i); break;
+                case 3: batch.remove_depth(depth - 1 - i / 4); break;
+            }
+        }
+        double const batch_ms = measure_ms([&]{ batched.apply_edits(batch); });
+        double const serial_ms = measure_ms([&]{
+            for(size_t i=0; i<n; ++i){
+                switch(i % 4){
+                    case 0: serial.insert_row(i, 0); break;
+                    case 1: serial.insert_depth(i / 4, 0); break;
+                    case 2: serial.remove_row(size / 2 - i); break;
+                    case 3: serial.remove_depth(depth - 1 - i / 4); break;
+                }
+            }
+        });
+        std::printf("%8zu %12.3f %12.3f\n", n, batch_ms, serial_ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,300 @@
+/**
+ * @brief Grid2D, Grid3Dの主要な操作の計測 結果はJSONで標準出力へ書き出す
+ * @note g++ -std=c++17 -O2 bench/grid_suite.cpp -o grid_suite
+ * @note ./grid_suite > result.json でリリース間の比較に使う --quickでLLCに収まる大きさまでに限る
+ * @note 大きさはL1に収まるものから、一般的なLLCより大きいものまで
+*/
+
+#include "../grid2d.h"
+#include "../grid3d.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace Utility;
+
+/**
+ * @brief 計測結果の一件
+*/
+struct BenchResult{
+    std::string name;       // 操作
+    std::string grid;       // 対象のグリッド
+    std::string shape;      // 幅x高さ(x奥行)
+    size_t bytes;           // 格納領域のバイト数
+    size_t elements;        // 一回の操作で扱う要素数
+    size_t repeats;         // 計測した回数
+    double best_ns;         // 一回あたりの最短時間
+    double median_ns;       // 一回あたりの中央値
+};
+
+/**
+ * @brief 最適化で計算を消されないように結果を書き込む先
+*/
+volatile long long g_sink = 0;
+
+/**
+ * @brief funcを一回の準備(計測しない)と本体の組で繰り返し、本体の時間を集計する
+ * @param[in] setup 計測前に毎回呼ぶ 挿入・削除した状態を戻すのに使う
+ * @note 合計がbudget_msを超えるまで繰り返す 一回目(計測しない)がbudget_ms以内なら少なくとも3回計測する
+*/
+template <typename Setup, typename Function>
+BenchResult measure(std::string name, std::string grid, std::string shape, size_t const bytes, size_t const elements,
+    Setup const & setup, Function const & func, double const budget_ms = 100.0){
+
+    std::vector<double> samples;
+    double total_ms = 0;
+    setup();
+    auto const warmup_start = std::chrono::steady_clock::now();
+    func();
+    double const warmup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - warmup_start).count();
+    size_t const min_repeats = (warmup_ms < budget_ms) ? 3 : 1;
+    while(samples.size() < min_repeats || (total_ms < budget_ms && samples.size() < 1000)){
+        setup();
+        auto const start = std::chrono::steady_clock::now();
+        func();
+        auto const end = std::chrono::steady_clock::now();
+        double const ns = std::chrono::duration<double, std::nano>(end - start).count();
+        samples.push_back(ns);
+        total_ms += ns * 1e-6;
+    }
+    std::sort(samples.begin(), samples.end());
+    return BenchResult{std::move(name), std::move(grid), std::move(shape), bytes, elements, samples.size(), samples.front(), samples[samples.size() / 2]};
+}
+
+template <typename Function>
+BenchResult measure(std::string name, std::string grid, std::string shape, size_t const bytes, size_t const elements,
+    Function const & func){
+
+    return measure(std::move(name), std::move(grid), std::move(shape), bytes, elements, []{}, func);
+}
+
+/**
+ * @brief print()の出力先を一時的に文字列へ差し替える
+*/
+class CoutCapture{
+    std::ostringstream m_stream;
+    std::streambuf * m_original;
+
+public:
+    CoutCapture()
+        : m_original(std::cout.rdbuf(m_stream.rdbuf())){}
+
+    ~CoutCapture(){
+        std::cout.rdbuf(m_original);
+    }
+
+    size_t size() const {
+        return m_stream.str().size();
+    }
+};
+
+void bench_grid2d(size_t const n, std::vector<BenchResult> & results){
+    using grid_type = Grid2D<int>;
+    std::string const name = "Grid2D<int>";
+    std::string const shape = std::to_string(n) + "x" + std::to_string(n);
+    size_t const bytes = n * n * sizeof(int);
+    size_t const elements = n * n;
+
+    grid_type grid(n, n);
+    for(size_t y=0; y<n; ++y){
+        for(size_t x=0; x<n; ++x){
+            grid[y][x] = static_cast<int>((x * 7 + y * 13) % 11);
+        }
+    }
+
+    results.push_back(measure("at", name, shape, bytes, elements, [&]{
+        long long total = 0;
+        for(size_t y=0; y<n; ++y){
+            for(size_t x=0; x<n; ++x){
+                total += grid.at(y, x);
+            }
+        }
+        g_sink = total;
+    }));
+    results.push_back(measure("operator[]", name, shape, bytes, elements, [&]{
+        long long total = 0;
+        for(size_t y=0; y<n; ++y){
+            for(size_t x=0; x<n; ++x){
+                total += grid[y][x];
+            }
+        }
+        g_sink = total;
+    }));
+    results.push_back(measure("foreach", name, shape, bytes, elements, [&]{
+        long long total = 0;
+        grid.foreach([&](size_t const y, size_t const x){
+            total += grid[y][x];
+        });
+        g_sink = total;
+    }));
+
+    // 挿入・削除は中央で行い、計測の前に元の大きさへ戻す
+    int const mid = static_cast<int>(n / 2);
+    bool inserted = false;
+    results.push_back(measure("insert_column", name, shape, bytes, elements, [&]{
+        if(inserted) grid.remove_column(mid);
+    }, [&]{
+        grid.insert_column(mid, 0);
+        inserted = true;
+    }));
+    if(inserted) grid.remove_column(mid);
+
+    bool removed = false;
+    results.push_back(measure("remove_row", name, shape, bytes, elements, [&]{
+        if(removed) grid.insert_row(mid, 0);
+    }, [&]{
+        grid.remove_row(mid);
+        removed = true;
+    }));
+    if(removed) grid.insert_row(mid, 0);
+
+    // 幅と高さを1ずつ増やして戻す
+    results.push_back(measure("resize", name, shape, bytes, elements, [&]{
+        grid.resize(n, n);
+    }, [&]{
+        grid.resize(n + 1, n + 1, 0);
+    }));
+    grid.resize(n, n);
+
+    results.push_back(measure("print", name, shape, bytes, elements, []{}, [&]{
+        CoutCapture capture;
+        grid.print();
+        g_sink = static_cast<long long>(capture.size());
+    }, 20.0));
+}
+
+/**
+ * @brief Grid3Dの挿入・削除を計測する最大の要素数
+*/
+constexpr size_t edit_limit_3d = size_t(1) << 22;
+
+void bench_grid3d(size_t const n, std::vector<BenchResult> & results){
+    using grid_type = Grid3D<int>;
+    std::string const name = "Grid3D<int>";
+    std::string const shape = std::to_string(n) + "x" + std::to_string(n) + "x" + std::to_string(n);
+    size_t const bytes = n * n * n * sizeof(int);
+    size_t const elements = n * n * n;
+
+    grid_type grid(n, n, n);
+    for(size_t z=0; z<n; ++z){
+        for(size_t y=0; y<n; ++y){
+            for(size_t x=0; x<n; ++x){
+                grid.at(z, y, x) = static_cast<int>((x * 7 + y * 13 + z * 17) % 11);
+            }
+        }
+    }
+
+    results.push_back(measure("at", name, shape, bytes, elements, [&]{
+        long long total = 0;
+        for(size_t z=0; z<n; ++z){
+            for(size_t y=0; y<n; ++y){
+                for(size_t x=0; x<n; ++x){
+                    total += grid.at(z, y, x);
+                }
+            }
+        }
+        g_sink = total;
+    }));
+    results.push_back(measure("Grid3DAccessController", name, shape, bytes, elements, [&]{
+        long long total = 0;
+        for(size_t z=0; z<n; ++z){
+            for(size_t y=0; y<n; ++y){
+                for(size_t x=0; x<n; ++x){
+                    total += grid[z][y][x];
+                }
+            }
+        }
+        g_sink = total;
+    }));
+    results.push_back(measure("foreach", name, shape, bytes, elements, [&]{
+        long long total = 0;
+        grid.foreach([&](size_t const z, size_t const y, size_t const x){
+            total += grid.at(z, y, x);
+        });
+        g_sink = total;
+    }));
+
+    // 行優先での列・行の挿入と削除は一要素ずつvectorへ挿入するため大きさの5乗に比例し、大きいものでは計測しない
+    if(elements <= edit_limit_3d){
+        int const mid = static_cast<int>(n / 2);
+        bool inserted = false;
+        results.push_back(measure("insert_column", name, shape, bytes, elements, [&]{
+            if(inserted) grid.remove_column(mid);
+        }, [&]{
+            grid.insert_column(mid, 0);
+            inserted = true;
+        }));
+        if(inserted) grid.remove_column(mid);
+
+        bool removed = false;
+        results.push_back(measure("remove_row", name, shape, bytes, elements, [&]{
+            if(removed) grid.insert_row(mid, 0);
+        }, [&]{
+            grid.remove_row(mid);
+            removed = true;
+        }));
+        if(removed) grid.insert_row(mid, 0);
+
+        removed = false;
+        results.push_back(measure("remove_depth", name, shape, bytes, elements, [&]{
+            if(removed) grid.insert_depth(mid, 0);
+        }, [&]{
+            grid.remove_depth(mid);
+            removed = true;
+        }));
+        if(removed) grid.insert_depth(mid, 0);
+    }
+
+    results.push_back(measure("resize", name, shape, bytes, elements, [&]{
+        grid.resize(n, n, n);
+    }, [&]{
+        grid.resize(n + 1, n + 1, n + 1, 0);
+    }));
+    grid.resize(n, n, n);
+
+    results.push_back(measure("print", name, shape, bytes, elements, []{}, [&]{
+        CoutCapture capture;
+        grid.print();
+        g_sink = static_cast<long long>(capture.size());
+    }, 20.0));
+}
+
+void write_json(std::vector<BenchResult> const & results){
+    std::printf("{\n");
+    std::printf("  \"suite\": \"grid\",\n");
+#if defined(__VERSION__)
+    std::printf("  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+    std::printf("  \"results\": [\n");
+    for(size_t i=0; i<results.size(); ++i){
+        auto const & r = results[i];
+        std::printf("    {\"name\": \"%s\", \"grid\": \"%s\", \"shape\": \"%s\", \"bytes\": %zu, \"elements\": %zu, "
+            "\"repeats\": %zu, \"best_ns\": %.1f, \"median_ns\": %.1f, \"ns_per_element\": %.4f}%s\n",
+            r.name.c_str(), r.grid.c_str(), r.shape.c_str(), r.bytes, r.elements, r.repeats, r.best_ns, r.median_ns,
+            r.best_ns / static_cast<double>(r.elements), (i + 1 == results.size()) ? "" : ",");
+    }
+    std::printf("  ]\n");
+    std::printf("}\n");
+}
+
+int main(int argc, char ** argv){
+    bool const quick = (argc > 1 && std::strcmp(argv[1], "--quick") == 0);
+
+    // intで16KB(L1), 1MB(L2), 16MB(LLC程度), 64MB(LLCより大きい)
+    std::vector<size_t> sizes2d{64, 512, 2048, 4096};
+    std::vector<size_t> sizes3d{16, 64, 160, 256};
+    if(quick){
+        sizes2d.resize(2);
+        sizes3d.resize(2);
+    }
+
+    std::vector<BenchResult> results;
+    for(size_t n : sizes2d) bench_grid2d(n, results);
+    for(size_t n : sizes3d) bench_grid3d(n, results);
+    write_json(results);
+    return 0;
+}
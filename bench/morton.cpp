@@ -0,0 +1,87 @@
+/**
+ * @brief Grid3Dの行優先レイアウトとモートン順レイアウトでの6近傍アクセスの比較
+ * @note g++ -std=c++17 -O2 -march=native bench/morton.cpp -o morton
+*/
+
+#include "../grid3d.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace Utility;
+
+/**
+ * @brief 内部の各要素について6近傍の和を求め、その総和を返す
+ * @note 走査はレイアウトの格納順(foreach)で行う
+*/
+template <typename grid_type>
+double neighbor_sum(grid_type & grid){
+    auto const & layout = grid.layout();
+    float const * data = grid.data();
+    size_t const w = grid.width(), h = grid.height(), d = grid.depth();
+    double total = 0;
+    grid.foreach([&](size_t const z, size_t const y, size_t const x){
+        if(z == 0 || y == 0 || x == 0 || z == d - 1 || y == h - 1 || x == w - 1) return;
+        total += data[layout.index(z - 1, y, x)] + data[layout.index(z + 1, y, x)]
+            + data[layout.index(z, y - 1, x)] + data[layout.index(z, y + 1, x)]
+            + data[layout.index(z, y, x - 1)] + data[layout.index(z, y, x + 1)];
+    });
+    return total;
+}
+
+/**
+ * @brief ランダムに選んだ要素について6近傍の和を求め、その総和を返す
+ * @note 近傍同士の局所性だけが効くアクセスパターン
+*/
+template <typename grid_type>
+double random_neighbor_sum(grid_type & grid){
+    auto const & layout = grid.layout();
+    float const * data = grid.data();
+    size_t const n = grid.width();
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<size_t> dist(1, n - 2);
+    double total = 0;
+    for(size_t i=0; i<(size_t(1) << 21); ++i){
+        size_t const z = dist(rng), y = dist(rng), x = dist(rng);
+        total += data[layout.index(z - 1, y, x)] + data[layout.index(z + 1, y, x)]
+            + data[layout.index(z, y - 1, x)] + data[layout.index(z, y + 1, x)]
+            + data[layout.index(z, y, x - 1)] + data[layout.index(z, y, x + 1)];
+    }
+    return total;
+}
+
+template <typename grid_type, typename Function>
+double measure_ms(size_t const n, Function const & kernel, double & result){
+    grid_type grid(n, n, n, 1.0f);
+    grid.foreach([&](size_t const z, size_t const y, size_t const x){
+        grid.at(z, y, x) = static_cast<float>((x * 7 + y * 13 + z * 17) % 11);
+    });
+    auto const start = std::chrono::steady_clock::now();
+    result = kernel(grid);
+    auto const end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename Function>
+int run(char const * name, Function const & kernel){
+    std::printf("# %s\n", name);
+    std::printf("%8s %14s %14s %14s\n", "size", "linear[ms]", "morton<2>[ms]", "morton<3>[ms]");
+    for(size_t n : {32, 64, 128, 256, 384}){
+        double r0, r1, r2;
+        double const linear_ms = measure_ms<Grid3D<float>>(n, kernel, r0);
+        double const morton2_ms = measure_ms<Grid3D<float, MortonLayout3D<2>>>(n, kernel, r1);
+        double const morton3_ms = measure_ms<Grid3D<float, MortonLayout3D<3>>>(n, kernel, r2);
+        if(r0 != r1 || r0 != r2){
+            std::printf("result mismatch\n");
+            return 1;
+        }
+        std::printf("%8zu %14.3f %14.3f %14.3f\n", n, linear_ms, morton2_ms, morton3_ms);
+    }
+    return 0;
+}
+
+int main(){
+    int result = run("sweep in storage order", [](auto & grid){ return neighbor_sum(grid); });
+    result |= run("random cells", [](auto & grid){ return random_neighbor_sum(grid); });
+    return result;
+}
@@ -0,0 +1,1057 @@
+/**
+ * @brief 一要素を1ビットで格納する二次元・三次元の真偽値配列
+ * @note 各行を64ビットの語の列として持ち、論理演算、シフト、数え上げを64要素ずつ行う
+ * @note 各行の末尾の語の余りのビットは常に0に保つ
+*/
+
+#ifndef UTILITY_BIT_GRID_H
+#define UTILITY_BIT_GRID_H
+
+#include <iostream>
+#include <vector>
+#include <utility>
+#include <tuple>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace Utility{
+
+namespace detail{
+
+inline int popcount64(uint64_t const x){
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    uint64_t v = x - ((x >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/**
+ * @brief 最下位の1のビットの位置 xは0でないこと
+*/
+inline int countr_zero64(uint64_t const x){
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    return popcount64((x & (~x + 1)) - 1);
+#endif
+}
+
+/**
+ * @brief n語の列をビット単位で上位方向(添字の大きい方)へshiftだけずらす 空いたビットは0
+*/
+inline void shift_words_up(uint64_t * const words, size_t const n, size_t const shift){
+    size_t const q = shift / 64, r = shift % 64;
+    for(size_t i=n; i-->0;){
+        uint64_t v = 0;
+        if(i >= q){
+            v = words[i - q] << r;
+            if(r != 0 && i > q) v |= words[i - q - 1] >> (64 - r);
+        }
+        words[i] = v;
+    }
+}
+
+/**
+ * @brief n語の列をビット単位で下位方向(添字の小さい方)へshiftだけずらす 空いたビットは0
+*/
+inline void shift_words_down(uint64_t * const words, size_t const n, size_t const shift){
+    size_t const q = shift / 64, r = shift % 64;
+    for(size_t i=0; i<n; ++i){
+        uint64_t v = 0;
+        if(i + q < n){
+            v = words[i + q] >> r;
+            if(r != 0 && i + q + 1 < n) v |= words[i + q + 1] << (64 - r);
+        }
+        words[i] = v;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief BitGrid2D, BitGrid3Dの一要素への参照
+*/
+class BitReference{
+private:
+    uint64_t * m_word;
+    uint64_t m_mask;
+
+public:
+    BitReference(uint64_t * word, int const bit)
+        : m_word(word),
+        m_mask(uint64_t(1) << bit){}
+
+    operator bool() const {
+        return (*m_word & m_mask) != 0;
+    }
+
+    BitReference & operator =(bool const value){
+        if(value) *m_word |= m_mask;
+        else *m_word &= ~m_mask;
+        return *this;
+    }
+
+    BitReference & operator =(BitReference const & other){
+        return *this = static_cast<bool>(other);
+    }
+
+    /**
+     * @brief 反転
+    */
+    void flip(){
+        *m_word ^= m_mask;
+    }
+};
+
+/**
+ * @brief [y][x]アクセスのうち、[x]の部分
+*/
+template <typename word_type>
+class BitRowAccessor{
+private:
+    word_type * m_words;
+
+public:
+    explicit BitRowAccessor(word_type * words)
+        : m_words(words){}
+
+    auto operator [] (int const x) const {
+        if constexpr(std::is_const<word_type>::value){
+            return ((m_words[x >> 6] >> (x & 63)) & 1) != 0;
+        }else{
+            return BitReference(m_words + (x >> 6), x & 63);
+        }
+    }
+};
+
+/**
+ * @brief ビット単位の二次元配列クラス at(y,x)でアクセス
+ * @note 各行はwords_per_row()語で、x番目の要素はrow(y)[x / 64]の(x % 64)ビット目
+*/
+class BitGrid2D{
+public:
+    using size_type = size_t;
+    using word_type = uint64_t;
+    using value_type = bool;
+
+    static constexpr size_type word_bits = 64;
+
+private:
+    std::vector<word_type> m_words; // [y * m_words_per_row + x / 64]
+    size_type m_width = 0;          // 横
+    size_type m_height = 0;         // 縦
+    size_type m_words_per_row = 0;  // 一行の語数
+
+public:
+    BitGrid2D(size_type const m_width = 0, size_type const m_height = 0, bool const init = false)
+        : m_words(words_for(m_width) * m_height, init ? ~word_type(0) : 0),
+        m_width(m_width),
+        m_height(m_height),
+        m_words_per_row(words_for(m_width)){
+        clear_padding();
+    }
+
+    /**
+     * @brief width, heightのペアから構築
+    */
+    BitGrid2D(std::pair<size_type, size_type> const & size, bool const init = false)
+        : BitGrid2D(size.first, size.second, init){}
+
+    /**
+     * @brief グリッドの各要素にpredを適用して構築
+     * @param[in] pred 要素の値を引数として受け取り、boolを返す関数
+    */
+    template <typename grid_type, typename Predicate>
+    static BitGrid2D from_grid(grid_type const & grid, Predicate const & pred){
+        BitGrid2D bits(grid.width(), grid.height());
+        for(size_type i=0; i<bits.m_height; ++i){
+            word_type * const row = bits.row(i);
+            for(size_type j=0; j<bits.m_width; ++j){
+                if(pred(grid.at(i, j))) row[j >> 6] |= word_type(1) << (j & 63);
+            }
+        }
+        return bits;
+    }
+
+    /**
+     * @brief 要素アクセス 範囲外ではstd::out_of_rangeを投げる
+    */
+    BitReference at(int const y, int const x){
+        check_range(y, x);
+        return BitReference(row(y) + (x >> 6), x & 63);
+    }
+    bool at(int const y, int const x) const {
+        check_range(y, x);
+        return get(y, x);
+    }
+
+    /**
+     * @brief (x,y)のペアにより要素アクセス
+     * @param[in] pos (x,y)のペア
+    */
+    BitReference at(std::pair<int, int> const pos){
+        return at(pos.second, pos.first);
+    }
+    bool at(std::pair<int, int> const pos) const {
+        return at(pos.second, pos.first);
+    }
+
+    /**
+     * @brief 値の読み出し 範囲チェックは行わない
+    */
+    bool get(int const y, int const x) const {
+        return ((row(y)[x >> 6] >> (x & 63)) & 1) != 0;
+    }
+
+    /**
+     * @brief 値の書き込み 範囲チェックは行わない
+    */
+    void set(int const y, int const x, bool const value = true){
+        word_type & word = row(y)[x >> 6];
+        word_type const mask = word_type(1) << (x & 63);
+        if(value) word |= mask;
+        else word &= ~mask;
+    }
+
+    /**
+     * @brief [y][x]で要素アクセス
+    */
+    BitRowAccessor<word_type> operator [] (int const y){
+        return BitRowAccessor<word_type>(row(y));
+    }
+    BitRowAccessor<word_type const> operator [] (int const y) const {
+        return BitRowAccessor<word_type const>(row(y));
+    }
+
+    /**
+     * @brief y行目の先頭の語へのポインタ
+    */
+    word_type * row(size_type const y){
+        return m_words.data() + y * m_words_per_row;
+    }
+    word_type const * row(size_type const y) const {
+        return m_words.data() + y * m_words_per_row;
+    }
+
+    /**
+     * @brief 範囲内に収まるかを調べる
+     * @return 収まっていたらtrue
+    */
+    bool in(int const y, int const x) const {
+        return y >= 0 && size_type(y) < m_height && x >= 0 && size_type(x) < m_width;
+    }
+
+    /**
+     * @brief (x, y)のペアが範囲内に収まるかを調べる
+    */
+    bool in(std::pair<int, int> const & pos) const {
+        return in(pos.second, pos.first);
+    }
+
+    size_t width() const {
+        return m_width;
+    }
+
+    size_t height() const {
+        return m_height;
+    }
+
+    /**
+     * @brief pairでサイズを返す
+     * @return width, heightのペア
+    */
+    std::pair<size_t, size_t> size() const {
+        return std::make_pair(m_width, m_height);
+    }
+
+    /**
+     * @brief 一行の語数
+    */
+    size_type words_per_row() const {
+        return m_words_per_row;
+    }
+
+    /**
+     * @brief 先頭の語へのポインタ 行はwords_per_row()語ごとに並ぶ
+    */
+    word_type * data(){
+        return m_words.data();
+    }
+    word_type const * data() const {
+        return m_words.data();
+    }
+
+    /**
+     * @brief 配列のクリア
+    */
+    void clear(){
+        m_words.clear();
+        m_width = 0;
+        m_height = 0;
+        m_words_per_row = 0;
+    }
+
+    /**
+     * @brief リサイズ 範囲内に残る要素は保持し、増えた要素はinitにする
+    */
+    void resize(size_type const w, size_type const h, bool const init = false){
+        BitGrid2D resized(w, h, init);
+        size_type const copy_h = std::min(h, m_height);
+        size_type const copy_w = std::min(w, m_width);
+        size_type const copy_words = words_for(copy_w);
+        for(size_type i=0; i<copy_h; ++i){
+            word_type * const dst = resized.row(i);
+            word_type const * const src = row(i);
+            for(size_type k=0; k<copy_words; ++k){
+                word_type const mask = tail_mask(copy_w, k);
+                dst[k] = (dst[k] & ~mask) | (src[k] & mask);
+            }
+        }
+        *this = std::move(resized);
+    }
+
+    /**
+     * @brief 全要素をvalueにする
+    */
+    void fill(bool const value){
+        std::fill(m_words.begin(), m_words.end(), value ? ~word_type(0) : 0);
+        clear_padding();
+    }
+
+    /**
+     * @brief 全要素の反転
+    */
+    void flip(){
+        for(auto & word : m_words) word = ~word;
+        clear_padding();
+    }
+
+    BitGrid2D & operator &=(BitGrid2D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] &= other.m_words[i];
+        return *this;
+    }
+
+    BitGrid2D & operator |=(BitGrid2D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] |= other.m_words[i];
+        return *this;
+    }
+
+    BitGrid2D & operator ^=(BitGrid2D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] ^= other.m_words[i];
+        return *this;
+    }
+
+    /**
+     * @brief otherが立っている要素を0にする (*this & ~other)
+    */
+    BitGrid2D & subtract(BitGrid2D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] &= ~other.m_words[i];
+        return *this;
+    }
+
+    /**
+     * @brief 各要素をx方向にnだけずらす 正ならxの大きい方へ はみ出した要素は捨て、空いた要素は0
+    */
+    void shift_columns(int const n){
+        if(n == 0) return;
+        for(size_type i=0; i<m_height; ++i){
+            if(n > 0) detail::shift_words_up(row(i), m_words_per_row, size_type(n));
+            else detail::shift_words_down(row(i), m_words_per_row, size_type(-n));
+        }
+        clear_padding();
+    }
+
+    /**
+     * @brief 各行をy方向にnだけずらす 正ならyの大きい方へ はみ出した行は捨て、空いた行は0
+    */
+    void shift_rows(int const n){
+        size_type const k = size_type(n < 0 ? -n : n);
+        if(k >= m_height){
+            std::fill(m_words.begin(), m_words.end(), 0);
+            return;
+        }
+        size_type const offset = k * m_words_per_row;
+        if(n > 0){
+            std::copy_backward(m_words.begin(), m_words.end() - offset, m_words.end());
+            std::fill(m_words.begin(), m_words.begin() + offset, 0);
+        }else if(n < 0){
+            std::copy(m_words.begin() + offset, m_words.end(), m_words.begin());
+            std::fill(m_words.end() - offset, m_words.end(), 0);
+        }
+    }
+
+    /**
+     * @brief trueの要素の数
+    */
+    size_type count() const {
+        size_type n = 0;
+        for(auto const word : m_words) n += detail::popcount64(word);
+        return n;
+    }
+
+    /**
+     * @brief y行目のtrueの要素の数
+    */
+    size_type count_row(size_type const y) const {
+        word_type const * const r = row(y);
+        size_type n = 0;
+        for(size_type k=0; k<m_words_per_row; ++k) n += detail::popcount64(r[k]);
+        return n;
+    }
+
+    /**
+     * @brief trueの要素があるか
+    */
+    bool any() const {
+        return std::any_of(m_words.begin(), m_words.end(), [](word_type const word){ return word != 0; });
+    }
+
+    bool none() const {
+        return !any();
+    }
+
+    /**
+     * @brief y行目のx_first列目以降で最初のtrueの要素の列
+     * @return 見つからなければ-1
+    */
+    int find_first(size_type const y, size_type const x_first = 0) const {
+        if(x_first >= m_width) return -1;
+        word_type const * const r = row(y);
+        size_type k = x_first >> 6;
+        word_type word = r[k] & (~word_type(0) << (x_first & 63));
+        for(;;){
+            if(word != 0) return static_cast<int>(k * word_bits + detail::countr_zero64(word));
+            if(++k == m_words_per_row) return -1;
+            word = r[k];
+        }
+    }
+
+    /**
+     * @brief trueの要素だけへの操作 行ごとに、語単位で0を読み飛ばす
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach_set(Function const & func) const {
+        for(size_type i=0; i<m_height; ++i){
+            word_type const * const r = row(i);
+            for(size_type k=0; k<m_words_per_row; ++k){
+                word_type word = r[k];
+                while(word != 0){
+                    func(i, k * word_bits + detail::countr_zero64(word));
+                    word &= word - 1;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(Function const & func) const {
+        for(size_type i=0; i<m_height; ++i){
+            for(size_type j=0; j<m_width; ++j){
+                func(i, j);
+            }
+        }
+    }
+
+    /**
+     * @brief 出力
+    */
+    void print() const {
+        for(size_type i=0; i<m_height; ++i){
+            for(size_type j=0; j<m_width; ++j){
+                std::cout << get(i, j) << ' ';
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    /**
+     * @brief サイズの出力
+    */
+    void print_size() const {
+        std::cout << "(width:" << m_width << " height:" << m_height << ")" << std::endl;
+    }
+
+    friend bool operator ==(BitGrid2D const & a, BitGrid2D const & b){
+        return a.m_width == b.m_width && a.m_height == b.m_height && a.m_words == b.m_words;
+    }
+
+    friend bool operator !=(BitGrid2D const & a, BitGrid2D const & b){
+        return !(a == b);
+    }
+
+#ifdef UTILITY_POINT2I_H
+
+    // point2i.hがincludeされている場合
+
+    /**
+     * @brief (x, y)のPoint2iにより要素アクセス
+    */
+    BitReference at(Point2i const & pos){
+        return at(pos.y, pos.x);
+    }
+    bool at(Point2i const & pos) const {
+        return at(pos.y, pos.x);
+    }
+
+    /**
+     * @brief (x, y)のPoint2iが範囲内に収まるかを調べる
+    */
+    bool in(Point2i const & pos) const {
+        return in(pos.y, pos.x);
+    }
+
+#endif // ifdef UTILITY_POINT2I_H
+
+private:
+    static size_type words_for(size_type const w){
+        return (w + word_bits - 1) / word_bits;
+    }
+
+    /**
+     * @brief 幅wの行のk語目のうち、範囲内のビットのマスク
+    */
+    static word_type tail_mask(size_type const w, size_type const k){
+        size_type const bits = w - k * word_bits;
+        return (bits >= word_bits) ? ~word_type(0) : ((word_type(1) << bits) - 1);
+    }
+
+    /**
+     * @brief 各行の末尾の語の余りのビットを0にする
+    */
+    void clear_padding(){
+        if(m_width % word_bits == 0) return;
+        word_type const mask = tail_mask(m_width, m_words_per_row - 1);
+        for(size_type i=0; i<m_height; ++i){
+            row(i)[m_words_per_row - 1] &= mask;
+        }
+    }
+
+    void check_range(int const y, int const x) const {
+        if(!in(y, x)){
+            throw std::out_of_range("BitGrid2D: index out of range");
+        }
+    }
+
+    void check_size(BitGrid2D const & other) const {
+        if(m_width != other.m_width || m_height != other.m_height){
+            throw std::invalid_argument("BitGrid2D: size mismatch");
+        }
+    }
+};
+
+inline BitGrid2D operator &(BitGrid2D left, BitGrid2D const & right){
+    left &= right;
+    return left;
+}
+
+inline BitGrid2D operator |(BitGrid2D left, BitGrid2D const & right){
+    left |= right;
+    return left;
+}
+
+inline BitGrid2D operator ^(BitGrid2D left, BitGrid2D const & right){
+    left ^= right;
+    return left;
+}
+
+inline BitGrid2D operator ~(BitGrid2D grid){
+    grid.flip();
+    return grid;
+}
+
+/**
+ * @brief BitGrid3Dの[z][y][x]アクセスのうち、[y][x]の部分
+*/
+template <typename word_type>
+class BitSliceAccessor{
+private:
+    word_type * m_words;
+    size_t m_words_per_row;
+
+public:
+    BitSliceAccessor(word_type * words, size_t const words_per_row)
+        : m_words(words),
+        m_words_per_row(words_per_row){}
+
+    BitRowAccessor<word_type> operator [] (int const y) const {
+        return BitRowAccessor<word_type>(m_words + y * m_words_per_row);
+    }
+};
+
+/**
+ * @brief ビット単位の三次元配列クラス at(z,y,x)でアクセス
+ * @note 各行はwords_per_row()語で、行は(z, y)の順に並ぶ
+*/
+class BitGrid3D{
+public:
+    using size_type = size_t;
+    using word_type = uint64_t;
+    using value_type = bool;
+
+    static constexpr size_type word_bits = 64;
+
+private:
+    std::vector<word_type> m_words; // [(z * m_height + y) * m_words_per_row + x / 64]
+    size_type m_width = 0;          // 横
+    size_type m_height = 0;         // 縦
+    size_type m_depth = 0;          // 奥行
+    size_type m_words_per_row = 0;  // 一行の語数
+
+public:
+    BitGrid3D(size_type const m_width = 0, size_type const m_height = 0, size_type const m_depth = 0, bool const init = false)
+        : m_words(words_for(m_width) * m_height * m_depth, init ? ~word_type(0) : 0),
+        m_width(m_width),
+        m_height(m_height),
+        m_depth(m_depth),
+        m_words_per_row(words_for(m_width)){
+        clear_padding();
+    }
+
+    /**
+     * @brief width, height, depthのタプルから構築
+    */
+    BitGrid3D(std::tuple<size_type, size_type, size_type> const & size, bool const init = false)
+        : BitGrid3D(std::get<0>(size), std::get<1>(size), std::get<2>(size), init){}
+
+    /**
+     * @brief グリッドの各要素にpredを適用して構築
+     * @param[in] pred 要素の値を引数として受け取り、boolを返す関数
+    */
+    template <typename grid_type, typename Predicate>
+    static BitGrid3D from_grid(grid_type const & grid, Predicate const & pred){
+        BitGrid3D bits(grid.width(), grid.height(), grid.depth());
+        for(size_type k=0; k<bits.m_depth; ++k){
+            for(size_type i=0; i<bits.m_height; ++i){
+                word_type * const r = bits.row(k, i);
+                for(size_type j=0; j<bits.m_width; ++j){
+                    if(pred(grid.at(k, i, j))) r[j >> 6] |= word_type(1) << (j & 63);
+                }
+            }
+        }
+        return bits;
+    }
+
+    /**
+     * @brief 要素アクセス 範囲外ではstd::out_of_rangeを投げる
+    */
+    BitReference at(int const z, int const y, int const x){
+        check_range(z, y, x);
+        return BitReference(row(z, y) + (x >> 6), x & 63);
+    }
+    bool at(int const z, int const y, int const x) const {
+        check_range(z, y, x);
+        return get(z, y, x);
+    }
+
+    /**
+     * @brief (x,y,z)のタプルにより要素アクセス
+     * @param[in] pos (x,y,z)のタプル
+    */
+    BitReference at(std::tuple<int, int, int> const pos){
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+    bool at(std::tuple<int, int, int> const pos) const {
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief 値の読み出し 範囲チェックは行わない
+    */
+    bool get(int const z, int const y, int const x) const {
+        return ((row(z, y)[x >> 6] >> (x & 63)) & 1) != 0;
+    }
+
+    /**
+     * @brief 値の書き込み 範囲チェックは行わない
+    */
+    void set(int const z, int const y, int const x, bool const value = true){
+        word_type & word = row(z, y)[x >> 6];
+        word_type const mask = word_type(1) << (x & 63);
+        if(value) word |= mask;
+        else word &= ~mask;
+    }
+
+    /**
+     * @brief [z][y][x]で要素アクセス
+    */
+    BitSliceAccessor<word_type> operator [] (int const z){
+        return BitSliceAccessor<word_type>(row(z, 0), m_words_per_row);
+    }
+    BitSliceAccessor<word_type const> operator [] (int const z) const {
+        return BitSliceAccessor<word_type const>(row(z, 0), m_words_per_row);
+    }
+
+    /**
+     * @brief (z, y)行目の先頭の語へのポインタ
+    */
+    word_type * row(size_type const z, size_type const y){
+        return m_words.data() + (z * m_height + y) * m_words_per_row;
+    }
+    word_type const * row(size_type const z, size_type const y) const {
+        return m_words.data() + (z * m_height + y) * m_words_per_row;
+    }
+
+    /**
+     * @brief 範囲内に収まるかを調べる
+     * @return 収まっていたらtrue
+    */
+    bool in(int const z, int const y, int const x) const {
+        return z >= 0 && size_type(z) < m_depth && y >= 0 && size_type(y) < m_height && x >= 0 && size_type(x) < m_width;
+    }
+
+    /**
+     * @brief (x, y, z)のタプルが範囲内に収まるかを調べる
+    */
+    bool in(std::tuple<int, int, int> const & pos) const {
+        return in(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    size_t width() const {
+        return m_width;
+    }
+
+    size_t height() const {
+        return m_height;
+    }
+
+    size_t depth() const {
+        return m_depth;
+    }
+
+    /**
+     * @brief tupleでサイズを返す
+     * @return width, height, depthのタプル
+    */
+    std::tuple<size_t, size_t, size_t> size() const {
+        return std::make_tuple(m_width, m_height, m_depth);
+    }
+
+    /**
+     * @brief 一行の語数
+    */
+    size_type words_per_row() const {
+        return m_words_per_row;
+    }
+
+    /**
+     * @brief 先頭の語へのポインタ 行はwords_per_row()語ごとに並ぶ
+    */
+    word_type * data(){
+        return m_words.data();
+    }
+    word_type const * data() const {
+        return m_words.data();
+    }
+
+    /**
+     * @brief 配列のクリア
+    */
+    void clear(){
+        m_words.clear();
+        m_width = 0;
+        m_height = 0;
+        m_depth = 0;
+        m_words_per_row = 0;
+    }
+
+    /**
+     * @brief リサイズ 範囲内に残る要素は保持し、増えた要素はinitにする
+    */
+    void resize(size_type const w, size_type const h, size_type const d, bool const init = false){
+        BitGrid3D resized(w, h, d, init);
+        size_type const copy_d = std::min(d, m_depth);
+        size_type const copy_h = std::min(h, m_height);
+        size_type const copy_w = std::min(w, m_width);
+        size_type const copy_words = words_for(copy_w);
+        for(size_type k=0; k<copy_d; ++k){
+            for(size_type i=0; i<copy_h; ++i){
+                word_type * const dst = resized.row(k, i);
+                word_type const * const src = row(k, i);
+                for(size_type n=0; n<copy_words; ++n){
+                    word_type const mask = tail_mask(copy_w, n);
+                    dst[n] = (dst[n] & ~mask) | (src[n] & mask);
+                }
+            }
+        }
+        *this = std::move(resized);
+    }
+
+    /**
+     * @brief 全要素をvalueにする
+    */
+    void fill(bool const value){
+        std::fill(m_words.begin(), m_words.end(), value ? ~word_type(0) : 0);
+        clear_padding();
+    }
+
+    /**
+     * @brief 全要素の反転
+    */
+    void flip(){
+        for(auto & word : m_words) word = ~word;
+        clear_padding();
+    }
+
+    BitGrid3D & operator &=(BitGrid3D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] &= other.m_words[i];
+        return *this;
+    }
+
+    BitGrid3D & operator |=(BitGrid3D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] |= other.m_words[i];
+        return *this;
+    }
+
+    BitGrid3D & operator ^=(BitGrid3D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] ^= other.m_words[i];
+        return *this;
+    }
+
+    /**
+     * @brief otherが立っている要素を0にする (*this & ~other)
+    */
+    BitGrid3D & subtract(BitGrid3D const & other){
+        check_size(other);
+        for(size_type i=0; i<m_words.size(); ++i) m_words[i] &= ~other.m_words[i];
+        return *this;
+    }
+
+    /**
+     * @brief 各要素をx方向にnだけずらす 正ならxの大きい方へ はみ出した要素は捨て、空いた要素は0
+    */
+    void shift_columns(int const n){
+        if(n == 0) return;
+        for(size_type r=0; r<m_depth * m_height; ++r){
+            word_type * const words = m_words.data() + r * m_words_per_row;
+            if(n > 0) detail::shift_words_up(words, m_words_per_row, size_type(n));
+            else detail::shift_words_down(words, m_words_per_row, size_type(-n));
+        }
+        clear_padding();
+    }
+
+    /**
+     * @brief 各行をy方向にnだけずらす 正ならyの大きい方へ はみ出した行は捨て、空いた行は0
+    */
+    void shift_rows(int const n){
+        size_type const k = size_type(n < 0 ? -n : n);
+        for(size_type z=0; z<m_depth; ++z){
+            shift_blocks(row(z, 0), m_height, m_words_per_row, n, k);
+        }
+    }
+
+    /**
+     * @brief 各断面をz方向にnだけずらす 正ならzの大きい方へ はみ出した断面は捨て、空いた断面は0
+    */
+    void shift_slices(int const n){
+        size_type const k = size_type(n < 0 ? -n : n);
+        shift_blocks(m_words.data(), m_depth, m_height * m_words_per_row, n, k);
+    }
+
+    /**
+     * @brief trueの要素の数
+    */
+    size_type count() const {
+        size_type n = 0;
+        for(auto const word : m_words) n += detail::popcount64(word);
+        return n;
+    }
+
+    /**
+     * @brief (z, y)行目のtrueの要素の数
+    */
+    size_type count_row(size_type const z, size_type const y) const {
+        word_type const * const r = row(z, y);
+        size_type n = 0;
+        for(size_type k=0; k<m_words_per_row; ++k) n += detail::popcount64(r[k]);
+        return n;
+    }
+
+    /**
+     * @brief trueの要素があるか
+    */
+    bool any() const {
+        return std::any_of(m_words.begin(), m_words.end(), [](word_type const word){ return word != 0; });
+    }
+
+    bool none() const {
+        return !any();
+    }
+
+    /**
+     * @brief (z, y)行目のx_first列目以降で最初のtrueの要素の列
+     * @return 見つからなければ-1
+    */
+    int find_first(size_type const z, size_type const y, size_type const x_first = 0) const {
+        if(x_first >= m_width) return -1;
+        word_type const * const r = row(z, y);
+        size_type k = x_first >> 6;
+        word_type word = r[k] & (~word_type(0) << (x_first & 63));
+        for(;;){
+            if(word != 0) return static_cast<int>(k * word_bits + detail::countr_zero64(word));
+            if(++k == m_words_per_row) return -1;
+            word = r[k];
+        }
+    }
+
+    /**
+     * @brief trueの要素だけへの操作 行ごとに、語単位で0を読み飛ばす
+     * @param[in] func z,y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach_set(Function const & func) const {
+        for(size_type z=0; z<m_depth; ++z){
+            for(size_type i=0; i<m_height; ++i){
+                word_type const * const r = row(z, i);
+                for(size_type k=0; k<m_words_per_row; ++k){
+                    word_type word = r[k];
+                    while(word != 0){
+                        func(z, i, k * word_bits + detail::countr_zero64(word));
+                        word &= word - 1;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func z,y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(Function const & func) const {
+        for(size_type z=0; z<m_depth; ++z){
+            for(size_type i=0; i<m_height; ++i){
+                for(size_type j=0; j<m_width; ++j){
+                    func(z, i, j);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 出力
+    */
+    void print() const {
+        for(size_type i=0; i<m_height; ++i){
+            for(size_type z=0; z<m_depth; ++z){
+                std::cout << '[';
+                for(size_type j=0; j<m_width; ++j){
+                    std::cout << get(z, i, j);
+                    std::cout << ((j == m_width - 1) ? "" : " ");
+                }
+                std::cout << "] ";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    /**
+     * @brief サイズの出力
+    */
+    void print_size() const {
+        std::cout << "(width:" << m_width << " height:" << m_height << " depth:" << m_depth << ")" << std::endl;
+    }
+
+    friend bool operator ==(BitGrid3D const & a, BitGrid3D const & b){
+        return a.m_width == b.m_width && a.m_height == b.m_height && a.m_depth == b.m_depth && a.m_words == b.m_words;
+    }
+
+    friend bool operator !=(BitGrid3D const & a, BitGrid3D const & b){
+        return !(a == b);
+    }
+
+private:
+    static size_type words_for(size_type const w){
+        return (w + word_bits - 1) / word_bits;
+    }
+
+    static word_type tail_mask(size_type const w, size_type const k){
+        size_type const bits = w - k * word_bits;
+        return (bits >= word_bits) ? ~word_type(0) : ((word_type(1) << bits) - 1);
+    }
+
+    /**
+     * @brief count個のblock語の塊をnだけずらす kはnの絶対値
+    */
+    static void shift_blocks(word_type * const words, size_type const count, size_type const block, int const n, size_type const k){
+        if(n == 0) return;
+        word_type * const last = words + count * block;
+        if(k >= count){
+            std::fill(words, last, 0);
+            return;
+        }
+        size_type const offset = k * block;
+        if(n > 0){
+            std::copy_backward(words, last - offset, last);
+            std::fill(words, words + offset, 0);
+        }else{
+            std::copy(words + offset, last, words);
+            std::fill(last - offset, last, 0);
+        }
+    }
+
+    void clear_padding(){
+        if(m_width % word_bits == 0) return;
+        word_type const mask = tail_mask(m_width, m_words_per_row - 1);
+        for(size_type r=0; r<m_depth * m_height; ++r){
+            m_words[r * m_words_per_row + m_words_per_row - 1] &= mask;
+        }
+    }
+
+    void check_range(int const z, int const y, int const x) const {
+        if(!in(z, y, x)){
+            throw std::out_of_range("BitGrid3D: index out of range");
+        }
+    }
+
+    void check_size(BitGrid3D const & other) const {
+        if(m_width != other.m_width || m_height != other.m_height || m_depth != other.m_depth){
+            throw std::invalid_argument("BitGrid3D: size mismatch");
+        }
+    }
+};
+
+inline BitGrid3D operator &(BitGrid3D left, BitGrid3D const & right){
+    left &= right;
+    return left;
+}
+
+inline BitGrid3D operator |(BitGrid3D left, BitGrid3D const & right){
+    left |= right;
+    return left;
+}
+
+inline BitGrid3D operator ^(BitGrid3D left, BitGrid3D const & right){
+    left ^= right;
+    return left;
+}
+
+inline BitGrid3D operator ~(BitGrid3D grid){
+    grid.flip();
+    return grid;
+}
+
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_BIT_GRID_H
@@ -0,0 +1,326 @@
+/**
+ * @brief 大部分が空の巨大な三次元配列用のチャンク分割クラス
+ * @note 書き込まれたチャンクだけを確保するため、使用メモリは外接直方体ではなく使われている体積に比例する
+*/
+
+#ifndef UTILITY_CHUNKED_GRID3D_H
+#define UTILITY_CHUNKED_GRID3D_H
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <tuple>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Utility{
+
+/**
+ * @brief チャンク分割された三次元配列クラス at(z,y,x)でアクセス
+ * @tparam ChunkBits チャンクの一辺の要素数の対数 一辺は2^ChunkBits
+ * @note チャンクは座標をキーとしたオープンアドレス法のハッシュ表で管理する
+ * @note 確保されていない要素の値は構築時のinitとみなす
+*/
+template <typename data_type, size_t ChunkBits = 4>
+class ChunkedGrid3D{
+public:
+    using size_type = size_t;
+
+    static constexpr size_type chunk_size = size_type(1) << ChunkBits;         // チャンクの一辺
+    static constexpr size_type chunk_volume = chunk_size * chunk_size * chunk_size;
+
+private:
+    static constexpr uint64_t empty_key = ~uint64_t(0);
+    static constexpr size_type local_mask = chunk_size - 1;
+
+    std::vector<uint64_t> m_keys;                        // ハッシュ表のキー 空きはempty_key
+    std::vector<uint32_t> m_slots;                       // ハッシュ表の値 m_chunksの添字
+    std::vector<std::unique_ptr<data_type[]>> m_chunks;  // 確保されたチャンク
+    std::vector<uint64_t> m_chunk_keys;                  // m_chunks[i]のキー
+    size_type m_width = 0;  // 横
+    size_type m_height = 0; // 縦
+    size_type m_depth = 0;  // 奥行
+    data_type m_init{};     // 確保されていない要素の値
+
+public:
+    ChunkedGrid3D(size_type const m_width = 0, size_type const m_height = 0, size_type const m_depth = 0, data_type const & init = data_type{})
+        : m_width(m_width),
+        m_height(m_height),
+        m_depth(m_depth),
+        m_init(init){
+        if(chunk_count_of(m_width) >= (size_type(1) << 21) || chunk_count_of(m_height) >= (size_type(1) << 21) || chunk_count_of(m_depth) >= (size_type(1) << 21)){
+            throw std::length_error("ChunkedGrid3D: size too large");
+        }
+    }
+
+    /**
+     * @brief width, height, depthのタプルから構築
+    */
+    ChunkedGrid3D(std::tuple<size_type, size_type, size_type> const & size, data_type const & init = data_type{})
+        : ChunkedGrid3D(std::get<0>(size), std::get<1>(size), std::get<2>(size), init){}
+
+    ChunkedGrid3D(ChunkedGrid3D &&) = default;
+    ChunkedGrid3D & operator =(ChunkedGrid3D &&) = default;
+
+    ChunkedGrid3D(ChunkedGrid3D const & other)
+        : m_keys(other.m_keys),
+        m_slots(other.m_slots),
+        m_chunk_keys(other.m_chunk_keys),
+        m_width(other.m_width),
+        m_height(other.m_height),
+        m_depth(other.m_depth),
+        m_init(other.m_init){
+        m_chunks.reserve(other.m_chunks.size());
+        for(auto const & chunk : other.m_chunks){
+            m_chunks.emplace_back(new data_type[chunk_volume]);
+            std::copy(chunk.get(), chunk.get() + chunk_volume, m_chunks.back().get());
+        }
+    }
+
+    ChunkedGrid3D & operator =(ChunkedGrid3D const & other){
+        if(this != &other){
+            ChunkedGrid3D copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief 要素アクセス 要素を含むチャンクが確保されていなければ確保する
+     * @note 読むだけの場合はconst版かget()を使うと、チャンクを確保しない
+    */
+    data_type & at(int const z, int const y, int const x){
+        check_range(z, y, x);
+        return chunk_for_write(z, y, x)[local_index(z, y, x)];
+    }
+
+    /**
+     * @brief (x,y,z)のタプルにより要素アクセス
+     * @param[in] pos (x,y,z)のタプル
+    */
+    data_type & at(std::tuple<int, int, int> const pos){
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief 要素アクセス const 確保されていない要素はinitを返す
+    */
+    data_type const & at(int const z, int const y, int const x) const {
+        check_range(z, y, x);
+        data_type const * const chunk = find_chunk(z, y, x);
+        return (chunk != nullptr) ? chunk[local_index(z, y, x)] : m_init;
+    }
+
+    /**
+     * @brief (x,y,z)のタプルにより要素アクセス const
+     * @param[in] pos (x,y,z)のタプル
+    */
+    data_type const & at(std::tuple<int, int, int> const pos) const {
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief 値の読み出し チャンクを確保しない
+    */
+    data_type const & get(int const z, int const y, int const x) const {
+        return at(z, y, x);
+    }
+
+    /**
+     * @brief 値の書き込み
+    */
+    void set(int const z, int const y, int const x, data_type const & value){
+        at(z, y, x) = value;
+    }
+
+    /**
+     * @brief (z, y, x)が範囲内に収まるかを調べる
+     * @return 収まっていたらtrue
+    */
+    bool in(int const z, int const y, int const x) const {
+        return z >= 0 && size_type(z) < m_depth && y >= 0 && size_type(y) < m_height && x >= 0 && size_type(x) < m_width;
+    }
+
+    /**
+     * @brief (x, y, z)が範囲内に収まるかを調べる
+     * @param[in] pos (x, y, z)のタプル
+    */
+    bool in(std::tuple<int, int, int> const & pos) const {
+        return in(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief (z, y, x)を含むチャンクが確保されているか
+    */
+    bool allocated(int const z, int const y, int const x) const {
+        return in(z, y, x) && find_chunk(z, y, x) != nullptr;
+    }
+
+    size_t width() const {
+        return m_width;
+    }
+
+    size_t height() const {
+        return m_height;
+    }
+
+    size_t depth() const {
+        return m_depth;
+    }
+
+    /**
+     * @brief tupleでサイズを返す
+     * @return width, height, depthのタプル
+    */
+    std::tuple<size_t, size_t, size_t> size() const {
+        return std::make_tuple(m_width, m_height, m_depth);
+    }
+
+    /**
+     * @brief 確保されているチャンクの数
+    */
+    size_type chunk_count() const {
+        return m_chunks.size();
+    }
+
+    /**
+     * @brief チャンクとハッシュ表が使用しているおおよそのバイト数
+    */
+    size_type memory_usage() const {
+        return m_chunks.size() * (chunk_volume * sizeof(data_type) + sizeof(std::unique_ptr<data_type[]>) + sizeof(uint64_t))
+            + m_keys.size() * (sizeof(uint64_t) + sizeof(uint32_t));
+    }
+
+    /**
+     * @brief 全てのチャンクを解放し、全要素をinitに戻す
+    */
+    void clear(){
+        m_keys.clear();
+        m_slots.clear();
+        m_chunks.clear();
+        m_chunk_keys.clear();
+    }
+
+    /**
+     * @brief 確保されているチャンク内の各要素への一律な操作
+     * @param[in] func z,y,xを引数として受け取る関数
+     * @note 確保されていないチャンクは走査しない チャンクは確保した順、チャンク内はz,y,xの順に走査する
+    */
+    template <typename Function>
+    void foreach(Function const & func) const {
+        for(auto const key : m_chunk_keys){
+            size_type const z0 = size_type(key >> 42) << ChunkBits;
+            size_type const y0 = size_type((key >> 21) & 0x1FFFFF) << ChunkBits;
+            size_type const x0 = size_type(key & 0x1FFFFF) << ChunkBits;
+            size_type const z1 = std::min(z0 + chunk_size, m_depth);
+            size_type const y1 = std::min(y0 + chunk_size, m_height);
+            size_type const x1 = std::min(x0 + chunk_size, m_width);
+            for(size_type z=z0; z<z1; ++z){
+                for(size_type y=y0; y<y1; ++y){
+                    for(size_type x=x0; x<x1; ++x){
+                        func(z, y, x);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 確保されている要素の出力
+    */
+    void print() const {
+        foreach([this](size_type const z, size_type const y, size_type const x){
+            std::cout << '(' << x << ", " << y << ", " << z << "): " << at(z, y, x) << std::endl;
+        });
+    }
+
+    /**
+     * @brief サイズの出力
+    */
+    void print_size() const {
+        std::cout << "(width:" << m_width << " height:" << m_height << " depth:" << m_depth << ")" << std::endl;
+    }
+
+private:
+    static size_type chunk_count_of(size_type const n){
+        return (n + chunk_size - 1) >> ChunkBits;
+    }
+
+    static uint64_t chunk_key(int const z, int const y, int const x){
+        return (uint64_t(z >> ChunkBits) << 42) | (uint64_t(y >> ChunkBits) << 21) | uint64_t(x >> ChunkBits);
+    }
+
+    static size_type local_index(int const z, int const y, int const x){
+        return (((size_type(z) & local_mask) << ChunkBits | (size_type(y) & local_mask)) << ChunkBits) | (size_type(x) & local_mask);
+    }
+
+    static size_type hash(uint64_t key){
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return size_type(key);
+    }
+
+    void check_range(int const z, int const y, int const x) const {
+        if(!in(z, y, x)){
+            throw std::out_of_range("ChunkedGrid3D: index out of range");
+        }
+    }
+
+    /**
+     * @brief キーの入っている、または入るべきハッシュ表の位置
+    */
+    size_type probe(uint64_t const key) const {
+        size_type const mask = m_keys.size() - 1;
+        size_type i = hash(key) & mask;
+        while(m_keys[i] != key && m_keys[i] != empty_key){
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    data_type const * find_chunk(int const z, int const y, int const x) const {
+        if(m_keys.empty()) return nullptr;
+        size_type const i = probe(chunk_key(z, y, x));
+        return (m_keys[i] == empty_key) ? nullptr : m_chunks[m_slots[i]].get();
+    }
+
+    data_type * chunk_for_write(int const z, int const y, int const x){
+        uint64_t const key = chunk_key(z, y, x);
+        if(!m_keys.empty()){
+            size_type const i = probe(key);
+            if(m_keys[i] == key) return m_chunks[m_slots[i]].get();
+        }
+
+        // 負荷率が1/2を超えないように広げる
+        if((m_chunks.size() + 1) * 2 > m_keys.size()){
+            rehash(std::max<size_type>(16, m_keys.size() * 2));
+        }
+        std::unique_ptr<data_type[]> chunk(new data_type[chunk_volume]);
+        std::fill(chunk.get(), chunk.get() + chunk_volume, m_init);
+        size_type const i = probe(key);
+        m_keys[i] = key;
+        m_slots[i] = static_cast<uint32_t>(m_chunks.size());
+        m_chunks.push_back(std::move(chunk));
+        m_chunk_keys.push_back(key);
+        return m_chunks.back().get();
+    }
+
+    void rehash(size_type const capacity){
+        m_keys.assign(capacity, empty_key);
+        m_slots.assign(capacity, 0);
+        for(size_type n=0; n<m_chunk_keys.size(); ++n){
+            size_type const i = probe(m_chunk_keys[n]);
+            m_keys[i] = m_chunk_keys[n];
+            m_slots[i] = static_cast<uint32_t>(n);
+        }
+    }
+};
+
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_CHUNKED_GRID3D_H
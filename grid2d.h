@@ -8,50 +8,163 @@
 
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <utility>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include "grid_edit_batch.h"
+#include "thread_pool.h"
+#include "grid_wavefront.h"
+#include "grid_layout.h"
+#include "grid_bounds.h"
+#include "grid_instrument.h"
+#include "grid_trace.h"
+#include "grid_expression.h"
+#include "grid_view.h"
 
 namespace Utility{
 
 /**
  * @brief 二次元配列クラス at(y,x)でアクセス
+ * @tparam layout_type 要素の並べ方 RowMajorLayout(行優先)かTiledLayout(タイル単位)
+ * @tparam bounds_policy at(), operator[]での範囲検査 BoundsChecked(例外), BoundsAssert(assert), BoundsUnchecked(検査なし)
+ * @note 行優先以外のレイアウトではdata_typeがデフォルト構築可能であること(余りの要素に使う)
 */
-template <typename data_type>
+template <typename data_type, typename layout_type = RowMajorLayout, typename allocator_type = std::allocator<data_type>,
+    typename bounds_policy = DefaultBoundsPolicy>
 class Grid2D{
 public:
-    using container_type = std::vector<data_type>;
+    using value_type = data_type;
+    using bounds_policy_type = bounds_policy;
+    using container_type = std::vector<data_type, allocator_type>;
     using size_type = size_t;
 
 private: 
-    container_type m_data;  // [x + y * m_width]でデータへアクセス
+    container_type m_data;  // [m_layout.index(y, x)]でデータへアクセス
     size_type m_width = 0;  // 横
     size_type m_height = 0; // 縦
+    layout_type m_layout;   // 要素の並べ方
+    UTILITY_GRID_COUNTERS   // UTILITY_GRID_INSTRUMENTを定義した場合のみ
 
 public:
     Grid2D(size_type const m_width = 0, size_type const m_height = 0)
-        : m_data(m_width * m_height),
+        : m_data(layout_type(m_width, m_height).storage_size()),
         m_width(m_width),
-        m_height(m_height){}
+        m_height(m_height),
+        m_layout(m_width, m_height){
+        UTILITY_GRID_TRACK_MEMORY();
+    }
+
+    Grid2D(size_type const m_width, size_type const m_height, data_type const & init, allocator_type const & alloc = allocator_type())
+        : m_data(layout_type(m_width, m_height).storage_size(), init, alloc),
+        m_width(m_width),
+        m_height(m_height),
+        m_layout(m_width, m_height){
+        UTILITY_GRID_TRACK_MEMORY();
+    }
 
-    Grid2D(size_type const m_width, size_type const m_height, data_type const & init)
-        : m_data(m_width * m_height, init),
+    /**
+     * @brief allocで確保して構築 要素は値初期化する
+     * @note ArenaAllocatorのようにデフォルト構築できないアロケータではこちらを使う
+    */
+    Grid2D(size_type const m_width, size_type const m_height, allocator_type const & alloc)
+        : m_data(layout_type(m_width, m_height).storage_size(), alloc),
         m_width(m_width),
-        m_height(m_height){}
+        m_height(m_height),
+        m_layout(m_width, m_height){
+        UTILITY_GRID_TRACK_MEMORY();
+    }
     
     /**
      * @brief width, heightのペアから構築
     */
     Grid2D(std::pair<size_type, size_type> const & size)
-        : m_data(size.first, size.second),
-        m_width(size.first),
-        m_height(size.second){}
+        : Grid2D(size.first, size.second){}
 
     /**
      * @brief width, heightのペアから構築
     */
     Grid2D(std::pair<size_type, size_type> const & size, data_type const & init)
-        : m_data(size.first, size.second, init),
-        m_width(size.first),
-        m_height(size.second){}
+        : Grid2D(size.first, size.second, init){}
+
+    /**
+     * @brief 要素ごとの演算式から構築
+     * @note a + b * 0.5f などを一度の走査で評価する
+    */
+    template <typename Expr, std::enable_if_t<detail::is_grid_expression<Expr>::value, std::nullptr_t> = nullptr>
+    Grid2D(Expr const & expr, allocator_type const & alloc = allocator_type())
+        : m_data(alloc){
+        *this = expr;
+    }
+
+    /**
+     * @brief 要素ごとの演算式を一度の走査で評価して代入する
+     * @note 式に含まれるグリッドの大きさは式ごとに一度だけ確認し、一致しなければstd::invalid_argumentを投げる
+     * @note 大きさが異なる場合は式の大きさに合わせる
+    */
+    template <typename Expr, std::enable_if_t<detail::is_grid_expression<Expr>::value, std::nullptr_t> = nullptr>
+    Grid2D & operator =(Expr const & expr){
+        GridShape shape;
+        size_type const storage_size = detail::check_expression_shape(expr, shape);
+        if constexpr(std::is_same<typename Expr::layout, layout_type>::value && !detail::is_pitched_layout<layout_type>::value){
+            if(shape.width != m_width || shape.height != m_height){
+                m_data.resize(storage_size);
+                m_width = shape.width;
+                m_height = shape.height;
+                m_layout = layout_type(m_width, m_height);
+            }
+            detail::evaluate_expression(m_data.data(), expr, storage_size);
+        }else{
+            // 自身の別の位置を参照するビューを含みうるため、新しい領域に評価してから入れ替える
+            layout_type const new_layout(shape.width, shape.height);
+            container_type new_data(new_layout.storage_size(), m_data.get_allocator());
+            detail::evaluate_expression_at(new_data.data(), new_layout, expr, GridShape{shape.width, shape.height, 1});
+            m_data.swap(new_data);
+            m_width = shape.width;
+            m_height = shape.height;
+            m_layout = new_layout;
+        }
+        UTILITY_GRID_TRACK_MEMORY();
+        return *this;
+    }
+
+    /**
+     * @brief 要素ごとの加算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid2D, Right>::value, std::nullptr_t> = nullptr>
+    Grid2D & operator +=(Right const & right){
+        return *this = *this + right;
+    }
+
+    /**
+     * @brief 要素ごとの減算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid2D, Right>::value, std::nullptr_t> = nullptr>
+    Grid2D & operator -=(Right const & right){
+        return *this = *this - right;
+    }
+
+    /**
+     * @brief 要素ごとの乗算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid2D, Right>::value, std::nullptr_t> = nullptr>
+    Grid2D & operator *=(Right const & right){
+        return *this = *this * right;
+    }
+
+    /**
+     * @brief 要素ごとの除算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid2D, Right>::value, std::nullptr_t> = nullptr>
+    Grid2D & operator /=(Right const & right){
+        return *this = *this / right;
+    }
 
     /**
      * @brief 配列のクリア
@@ -60,6 +173,8 @@ public:
         m_data.clear();
         m_width = 0;
         m_height = 0;
+        m_layout = layout_type();
+        UTILITY_GRID_TRACK_MEMORY();
     }
 
     /**
@@ -67,13 +182,22 @@ public:
      * @param[in] pos 挿入する場所(挿入する位置がpos(0-indexed)列目になるように)
      * @param[in] init 初期化する値
     */
-    void insert_column(int const pos, data_type const & init){
-        reserve(m_width+1, m_height);
+    void insert_column(int const pos, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::insert_column", m_width, m_height);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.insert_column(pos, init);
+            apply_edits(batch);
+            return;
+        }
+        grow_storage(layout_type(m_width+1, m_height).storage_size());
 
         for(size_type i=0; i<m_height; ++i){
             m_data.insert(m_data.begin() + (pos + i * (m_width + 1)), init);
         }
         ++m_width;
+        m_layout = layout_type(m_width, m_height);
     }
 
     /**
@@ -81,30 +205,36 @@ public:
      * @param[in] pos 挿入する場所(挿入する位置がpos行目になるように)
      * @param[in] init 初期化する値
     */
-    void insert_row(int const pos, data_type const & init){
-        reserve(m_width, m_height+1);
+    void insert_row(int const pos, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertRow);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::insert_row", m_width, m_height);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.insert_row(pos, init);
+            apply_edits(batch);
+            return;
+        }
+        grow_storage(layout_type(m_width, m_height+1).storage_size());
 
         m_data.insert(m_data.begin() + pos*m_width, m_width, init);
         ++m_height;
+        m_layout = layout_type(m_width, m_height);
     }
 
     /**
      * @brief 列を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_column(data_type const & init){
-        insert_column(m_width, init);
+    void push_back_column(data_type const & init UTILITY_GRID_SITE){
+        push_back_columns(1, init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 行を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_row(data_type const & init){
-        for(size_type i=0; i<m_width; ++i){
-            m_data.push_back(init);
-        }
-        ++m_height;
+    void push_back_row(data_type const & init UTILITY_GRID_SITE){
+        push_back_rows(1, init UTILITY_GRID_SITE_ARG);
     }
 
     /**
@@ -112,8 +242,21 @@ public:
      * @param[in] n 追加する数
      * @param[in] init 初期化する値
     */
-    void push_back_columns(size_type const n, data_type const & init){
-        for(size_type i=0; i<n; ++i) push_back_column(init);
+    void push_back_columns(size_type const n, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::push_back_columns", m_width, m_height);
+        if(n == 0) return;
+        if constexpr(detail::is_pitched_layout<layout_type>::value){
+            // 余りの列に収まらなければ、pitchを倍に広げて再配置する(横方向の償却O(H))
+            if(m_width + n > m_layout.pitch()){
+                size_type const pitch = std::max(m_width + n, m_layout.pitch() * 2);
+                relayout_to(layout_type(m_width + n, m_height, pitch), m_width + n, m_height, init);
+                return;
+            }
+            grow_into_pitch(m_width + n, init);
+            return;
+        }
+        relayout(m_width + n, m_height, init);
     }
 
     /**
@@ -121,15 +264,38 @@ public:
      * @param[in] n 追加する数
      * @param[in] init 初期化する値
     */
-    void push_back_rows(size_type const n, data_type const & init){
-        for(size_type i=0; i<n; ++i) push_back_row(init);
+    void push_back_rows(size_type const n, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertRow);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::push_back_rows", m_width, m_height);
+        if constexpr(detail::is_pitched_layout<layout_type>::value){
+            m_data.insert(m_data.end(), n * m_layout.pitch(), init);
+            m_height += n;
+            m_layout = layout_type(m_width, m_height, m_layout.pitch());
+            return;
+        }
+        if constexpr(!layout_type::is_row_major){
+            if(n == 0) return;
+            relayout(m_width, m_height + n, init);
+            return;
+        }
+        m_data.insert(m_data.end(), n * m_width, init);
+        m_height += n;
+        m_layout = layout_type(m_width, m_height);
     }
 
     /**
      * @brief 任意の列の削除
      * @param[in] pos 消したい列(pos(0-indexed)列目となるように)
     */
-    void remove_column(size_type const pos){
+    void remove_column(size_type const pos UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::remove_column", m_width, m_height);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.remove_column(pos);
+            apply_edits(batch);
+            return;
+        }
         int index = 0;
 
         auto remove_it = std::remove_if(m_data.begin(), m_data.end(), [width = m_width, &pos, &index](data_type const &){
@@ -137,76 +303,215 @@ public:
         });
         m_data.erase(remove_it, m_data.end());
         --m_width;
+        m_layout = layout_type(m_width, m_height);
     }
 
     /**
      * @brief 任意の行の削除
      * @param[in] pos 消したい行(pos(0-indexed)行目となるように)
     */
-    void remove_row(int const pos){
+    void remove_row(int const pos UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveRow);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::remove_row", m_width, m_height);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.remove_row(pos);
+            apply_edits(batch);
+            return;
+        }
         m_data.erase(m_data.begin() + pos * m_width, m_data.begin() + (pos + 1) * m_width);
         --m_height;
+        m_layout = layout_type(m_width, m_height);
     }
 
     /**
      * @brief 後方の列の削除
     */
-    void pop_back_column(){
-        remove_column(m_width - 1);
+    void pop_back_column(UTILITY_GRID_SITE_ONLY){
+        pop_back_columns(1 UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 後方の行の削除
     */
-    void pop_back_row(){
-        --m_height;
-        m_data.resize(m_data.size() - m_width);
+    void pop_back_row(UTILITY_GRID_SITE_ONLY){
+        pop_back_rows(1 UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 後方の複数の列の削除
     */
-    void pop_back_columns(size_type const n){
-        for(size_type i=0; i<n; ++i) pop_back_column();
+    void pop_back_columns(size_type const n UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::pop_back_columns", m_width, m_height);
+        if(n == 0) return;
+        if constexpr(detail::is_pitched_layout<layout_type>::value){
+            // 余りの列として残す
+            m_width -= n;
+            m_layout = layout_type(m_width, m_height, m_layout.pitch());
+            return;
+        }
+        if constexpr(!layout_type::is_row_major){
+            relayout(m_width - n, m_height, data_type{});
+            return;
+        }
+        compact_columns(m_width - n);
     }
 
     /**
      * @brief 後方の複数の行の削除
     */
-    void pop_back_rows(size_type const n){
-        for(size_type i=0; i<n; ++i) pop_back_row();
+    void pop_back_rows(size_type const n UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveRow);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::pop_back_rows", m_width, m_height);
+        if constexpr(detail::is_pitched_layout<layout_type>::value){
+            m_data.erase(m_data.end() - n * m_layout.pitch(), m_data.end());
+            m_height -= n;
+            m_layout = layout_type(m_width, m_height, m_layout.pitch());
+            return;
+        }
+        if constexpr(!layout_type::is_row_major){
+            if(n == 0) return;
+            relayout(m_width, m_height - n, data_type{});
+            return;
+        }
+        m_data.erase(m_data.end() - n * m_width, m_data.end());
+        m_height -= n;
+        m_layout = layout_type(m_width, m_height);
+    }
+
+    /**
+     * @brief 記録した行・列の挿入と削除を一度に適用する
+     * @param[in] batch 適用する操作 削除位置は適用前、挿入位置は適用後のインデックス
+     * @note 操作の数によらず、新しいバッファへ一度だけ再配置する
+    */
+    void apply_edits(GridEditBatch<data_type> const & batch UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::ApplyEdits);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::apply_edits", m_width, m_height);
+        if(batch.empty()) return;
+        if(!batch.insertions(GridAxis::Depth).empty() || !batch.removals(GridAxis::Depth).empty()){
+            throw std::invalid_argument("Grid2D::apply_edits: Grid2D has no depth axis");
+        }
+
+        detail::GridEditAxisMap<data_type> const xs(m_width, batch, GridAxis::Column);
+        detail::GridEditAxisMap<data_type> const ys(m_height, batch, GridAxis::Row);
+
+        if constexpr(!layout_type::is_row_major){
+            layout_type const new_layout(xs.size(), ys.size());
+            container_type new_data(new_layout.storage_size(), m_data.get_allocator());
+            new_layout.foreach(0, ys.size(), [&](size_type const i, size_type const j){
+                auto const insertion = detail::latest_insertion(ys.insertion(i), xs.insertion(j));
+                new_data[new_layout.index(i, j)] = (insertion != nullptr)
+                    ? insertion->init
+                    : std::move(m_data[m_layout.index(ys.source(i), xs.source(j))]);
+            });
+            m_data.swap(new_data);
+            m_width = xs.size();
+            m_height = ys.size();
+            m_layout = new_layout;
+            return;
+        }
+
+        container_type new_data(m_data.get_allocator());
+        new_data.reserve(xs.size() * ys.size());
+        for(size_type i=0; i<ys.size(); ++i){
+            auto const row_insertion = ys.insertion(i);
+            if(row_insertion != nullptr){
+                for(size_type j=0; j<xs.size(); ++j){
+                    new_data.push_back(detail::latest_insertion(row_insertion, xs.insertion(j))->init);
+                }
+                continue;
+            }
+            auto const row = m_data.begin() + ys.source(i) * m_width;
+            for(size_type j=0; j<xs.size(); ++j){
+                auto const column_insertion = xs.insertion(j);
+                if(column_insertion != nullptr){
+                    new_data.push_back(column_insertion->init);
+                }else{
+                    new_data.push_back(std::move(row[xs.source(j)]));
+                }
+            }
+        }
+
+        m_data.swap(new_data);
+        m_width = xs.size();
+        m_height = ys.size();
+        m_layout = layout_type(m_width, m_height);
     }
 
     /**
      * @brief リザーブ
-     * @note m_width, m_heightは変えない
+     * @note m_width, m_heightは変えない 既に足りていれば何もしない
     */
-    void reserve(int const w, int const h){
-        m_data.reserve(w * h);
+    void reserve(size_type const w, size_type const h UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::Reserve);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::reserve", m_width, m_height);
+        m_data.reserve(layout_type(w, h).storage_size());
     }
 
     /**
      * @brief リザーブ
      * @note m_width, m_heightは変えない
     */
-    void reserve(std::pair<int, int> const & size){
-        m_data.reserve(size.first * size.second);
+    void reserve(std::pair<size_type, size_type> const & size UTILITY_GRID_SITE){
+        reserve(size.first, size.second UTILITY_GRID_SITE_ARG);
+    }
+
+    /**
+     * @brief 使っていない格納領域を解放する
+     * @note 要素は新しい領域へ移動するため、ポインタ、ビューは無効になる
+     * @note PitchedLayoutでは、列の追加・削除で広がったpitchを既定のpitchに詰め直す
+    */
+    void shrink_to_fit(UTILITY_GRID_SITE_ONLY){
+        UTILITY_GRID_RECORD_EDIT(GridOp::ShrinkToFit);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::shrink_to_fit", m_width, m_height);
+        if constexpr(detail::is_pitched_layout<layout_type>::value){
+            layout_type const compact_layout(m_width, m_height);
+            if(m_layout.pitch() != compact_layout.pitch()){
+                relayout_to(compact_layout, m_width, m_height, data_type());
+                return;
+            }
+        }
+        m_data.shrink_to_fit();
     }
 
     /**
      * @brief リサイズ
+     * @note 幅が増える場合は新しいバッファへ一度だけ再配置する
     */
-    void resize(size_type const w, size_type const h, data_type const & init){
-        // 幅を合わせる
-        if(w < m_width){
-            pop_back_columns(m_width - w);
-        }else if(w > m_width){
-            push_back_columns(w - m_width, init);
+    void resize(size_type const w, size_type const h, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::Resize);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::resize", m_width, m_height);
+        // 余りの列に収まる幅なら再配置しない
+        if constexpr(detail::is_pitched_layout<layout_type>::value){
+            if(w > m_layout.pitch()){
+                relayout(w, h, init);
+                return;
+            }
+            if(h < m_height) pop_back_rows(m_height - h);
+            if(w < m_width) pop_back_columns(m_width - w);
+            if(w > m_width) grow_into_pitch(w, init);
+            if(h > m_height) push_back_rows(h - m_height, init);
+            return;
+        }
+        // 行優先以外では常に一括で再配置
+        if constexpr(!layout_type::is_row_major){
+            if(w != m_width || h != m_height) relayout(w, h, init);
+            return;
+        }
+        // 幅が増える場合は一括で再配置
+        if(w > m_width){
+            relayout(w, h, init);
+            return;
         }
-        // 縦を合わせる
+        // 縦を減らしてから幅を詰める(捨てる行を移動しないように)
         if(h < m_height){
             pop_back_rows(m_height - h);
-        }else if(h > m_height){
+        }
+        if(w < m_width){
+            compact_columns(w);
+        }
+        if(h > m_height){
             push_back_rows(h - m_height, init);
         }
     }
@@ -214,82 +519,112 @@ public:
     /**
      * @brief リサイズ
     */
-    void resize(std::pair<size_type, size_type> const & size, data_type const & init){
-        resize(size.first, size.second, init);
+    void resize(std::pair<size_type, size_type> const & size, data_type const & init UTILITY_GRID_SITE){
+        resize(size.first, size.second, init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief リサイズ
     */
-    void resize(size_type const w, size_type const h){
-        resize(w, h, data_type{});
+    void resize(size_type const w, size_type const h UTILITY_GRID_SITE){
+        resize(w, h, data_type{} UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief リサイズ
     */
-    void resize(std::pair<size_type, size_type> const & size){
-        resize(size.first, size.second);
+    void resize(std::pair<size_type, size_type> const & size UTILITY_GRID_SITE){
+        resize(size.first, size.second UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 一番最初の要素のlvalue参照
     */
     data_type & front(){
-        return m_data.front();
+        return m_data[m_layout.index(0, 0)];
     }
     data_type const & front() const {
-        return m_data.front();
+        return m_data[m_layout.index(0, 0)];
     }
 
     /**
      * @brief 一番最後の要素のlvalue参照
     */
     data_type & back(){
-        return m_data.back();
+        return m_data[m_layout.index(m_height - 1, m_width - 1)];
     }
     data_type const & back() const {
-        return m_data.back();
+        return m_data[m_layout.index(m_height - 1, m_width - 1)];
     }
 
     /**
-     * @brief 要素アクセス
+     * @brief 要素アクセス 範囲の検査はbounds_policyに従う
     */
-    data_type & at(int const y, int const x){
-        return m_data.at(x + y*m_width);
+    data_type & at(int const y, int const x UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD(GridOp::At);
+        bounds_policy::check(y, m_height);
+        bounds_policy::check(x, m_width);
+        return m_data[m_layout.index(y, x)];
     }
 
     /**
      * @brief (x,y)のペアにより要素アクセス
      * @param[in] pos (x,y)のペア
     */
-    data_type & at(std::pair<int, int> const pos){
-        return m_data.at(pos.first + pos.second*m_width);
+    data_type & at(std::pair<int, int> const pos UTILITY_GRID_SITE){
+        return at(pos.second, pos.first UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 要素アクセス const
     */
-    data_type const & at(int const y, int const x) const {
-        return m_data.at(x + y*m_width);
+    data_type const & at(int const y, int const x UTILITY_GRID_SITE) const {
+        UTILITY_GRID_RECORD(GridOp::At);
+        bounds_policy::check(y, m_height);
+        bounds_policy::check(x, m_width);
+        return m_data[m_layout.index(y, x)];
     }
 
     /**
      * @brief (x,y)のペアにより要素アクセス const
      * @param[in] pos (x,y)のペア
     */
-    data_type const & at(std::pair<int, int> const pos) const {
-        return m_data.at(pos.first + pos.second*m_width);
+    data_type const & at(std::pair<int, int> const pos UTILITY_GRID_SITE) const {
+        return at(pos.second, pos.first UTILITY_GRID_SITE_ARG);
+    }
+
+    /**
+     * @brief 範囲を検査しない要素アクセス foreachのコールバックなど、添字が範囲内と分かっている場所で使う
+    */
+    data_type & at_unchecked(size_type const y, size_type const x){
+        return m_data[m_layout.index(y, x)];
+    }
+    data_type const & at_unchecked(size_type const y, size_type const x) const {
+        return m_data[m_layout.index(y, x)];
     }
 
     /**
      * @brief [y][x]で要素アクセス
+     * @return 行が連続するレイアウトでは行の先頭のポインタ、それ以外では[x]でアクセスできるオブジェクト
+     * @note yはbounds_policyに従って検査する 行の先頭のポインタを返す場合、xは検査しない
     */
-    data_type * operator [] (int const y){
-        return &m_data[y*m_width];
+    auto operator [] (int const y){
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(y, m_height);
+        if constexpr(layout_type::rows_contiguous){
+            return m_data.data() + m_layout.index(y, 0);
+        }else{
+            return GridRowAccessor<data_type, layout_type>(m_data.data(), &m_layout, y);
+        }
     }
-    data_type const * operator [] (int const y) const {
-        return &m_data[y*m_width];
+    auto operator [] (int const y) const {
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(y, m_height);
+        if constexpr(layout_type::rows_contiguous){
+            return m_data.data() + m_layout.index(y, 0);
+        }else{
+            return GridRowAccessor<data_type const, layout_type>(m_data.data(), &m_layout, y);
+        }
     }
 
     /**
@@ -308,17 +643,90 @@ public:
 
     /**
      * @brief 配列の先頭要素のポインタを返す
+     * @note 要素はレイアウトの順に並んでいる
     */
     data_type * data(){
         return m_data.data();
     }
+    data_type const * data() const {
+        return m_data.data();
+    }
+
+    /**
+     * @brief レイアウトを返す
+    */
+    layout_type const & layout() const {
+        return m_layout;
+    }
+
+    /**
+     * @brief 格納領域のアロケータを返す
+    */
+    allocator_type get_allocator() const {
+        return m_data.get_allocator();
+    }
+
+    /**
+     * @brief 格納領域の使用量 確保し直しの回数などはUTILITY_GRID_INSTRUMENTを定義した場合のみ記録される
+     * @note PitchedLayoutの余りの列は要素に含めず、使っていない領域として数える
+    */
+    GridMemoryStats memory_stats() const {
+#ifdef UTILITY_GRID_INSTRUMENT
+        GridMemoryStats stats = m_counters.memory_stats();
+#else
+        GridMemoryStats stats;
+#endif
+        if constexpr(detail::is_pitched_layout<layout_type>::value){
+            stats.size_bytes = m_width * m_height * sizeof(data_type);
+        }else{
+            stats.size_bytes = m_data.size() * sizeof(data_type);
+        }
+        stats.capacity_bytes = m_data.capacity() * sizeof(data_type);
+        stats.peak_bytes = std::max(stats.peak_bytes, stats.capacity_bytes);
+        return stats;
+    }
+
+#ifdef UTILITY_GRID_INSTRUMENT
+    /**
+     * @brief このグリッドへのアクセスと構造の変更の計数
+    */
+    GridCounters & counters() const {
+        return m_counters;
+    }
+#endif
+
+    /**
+     * @brief 全体のビュー
+     * @note 行優先のレイアウトのみ
+    */
+    GridView2D<data_type> view(){
+        static_assert(layout_type::rows_contiguous, "Grid2D::view: layout must be row-major");
+        return GridView2D<data_type>(m_data.data(), m_width, m_height, m_layout.row_stride());
+    }
+    GridView2D<data_type const> view() const {
+        static_assert(layout_type::rows_contiguous, "Grid2D::view: layout must be row-major");
+        return GridView2D<data_type const>(m_data.data(), m_width, m_height, m_layout.row_stride());
+    }
+
+    /**
+     * @brief [y_first, y_last)x[x_first, x_last)の領域のビュー 範囲外ではstd::out_of_rangeを投げる
+     * @note 要素はコピーしない 行優先のレイアウトのみ
+    */
+    GridView2D<data_type> subgrid(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last){
+        return view().subgrid(y_first, x_first, y_last, x_last);
+    }
+    GridView2D<data_type const> subgrid(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last) const {
+        return view().subgrid(y_first, x_first, y_last, x_last);
+    }
 
     /**
      * @brief 範囲内に収まるかを調べる
      * @return 収まっていたらtrue
     */
-    bool in(int const y, int const x) const {
-        return y >= 0 && y < m_height && x >= 0 && x < m_width;
+    bool in(int const y, int const x UTILITY_GRID_SITE) const {
+        bool const result = y >= 0 && static_cast<size_type>(y) < m_height && x >= 0 && static_cast<size_type>(x) < m_width;
+        if(!result) UTILITY_GRID_RECORD(GridOp::InMiss);
+        return result;
     }
 
     /**
@@ -326,8 +734,8 @@ public:
      * @param[in] pos (x, y)のペア
      * @return 収まっていたらtrue
     */
-    bool in(std::pair<int, int> const & pos) const {
-        return in(pos.second, pos.first);
+    bool in(std::pair<int, int> const & pos UTILITY_GRID_SITE) const {
+        return in(pos.second, pos.first UTILITY_GRID_SITE_ARG);
     }
 
     /**
@@ -342,9 +750,10 @@ public:
      * @brief 出力
     */
     void print() const {
+        UTILITY_GRID_TRACE_SPAN("Grid2D::print", m_width, m_height);
         for(size_type i=0; i<m_height; ++i){
             for(size_type j=0; j<m_width; ++j){
-                std::cout << at(i, j) << ' ';
+                std::cout << at_unchecked(i, j) << ' ';
             }
             std::cout << std::endl;
         }
@@ -359,17 +768,178 @@ public:
 
     /**
      * @brief 各要素への一律な操作
-     * @param[in] func y,xを引数として受け取る関数
+     * @param[in] func y,xか、y,xと要素の参照を引数として受け取る関数
+     * @note レイアウトの格納順(TiledLayoutならタイル順)に走査する
+     * @note 要素の参照はbounds_policyによらず検査せずに渡す(添字は常に範囲内)
     */
     template <typename Function>
     void foreach(const Function & func){
-        for(size_type i=0; i<m_height; ++i){
-            for(size_type j=0; j<m_width; ++j){
-                func(i, j);
+        UTILITY_GRID_TRACE_SPAN("Grid2D::foreach", m_width, m_height);
+        m_layout.foreach(0, m_height, element_callback(func));
+    }
+
+    /**
+     * @brief 各要素への一律な操作を行単位で並列に行う
+     * @param[in] func y,xか、y,xと要素の参照を引数として受け取る関数 異なる要素に対して同時に呼ばれる
+    */
+    template <typename Function>
+    void parallel_foreach(const Function & func){
+        parallel_foreach(ThreadPool::global(), func);
+    }
+
+    /**
+     * @brief 各要素への一律な操作を、指定したプールで行単位で並列に行う
+     * @param[in] pool 使用するスレッドプール
+     * @param[in] func y,xか、y,xと要素の参照を引数として受け取る関数 異なる要素に対して同時に呼ばれる
+     * @note TiledLayoutではタイルの行単位で分割する
+    */
+    template <typename Function>
+    void parallel_foreach(ThreadPool & pool, const Function & func){
+        UTILITY_GRID_TRACE_SPAN("Grid2D::parallel_foreach", m_width, m_height);
+        size_type const block = layout_type::row_block;
+        auto const callback = element_callback(func);
+        pool.parallel_for(0, (m_height + block - 1) / block, [&](size_type const first, size_type const last){
+            m_layout.foreach(first * block, std::min(m_height, last * block), callback);
+        });
+    }
+
+    /**
+     * @brief 隣接要素への依存関係を満たす順序で、各要素への操作をタイル単位で並列に行う
+     * @param[in] func y,xを引数として受け取る関数 依存先の要素の処理が終わった後に呼ばれる
+     * @param[in] dependencies (y, x)が依存する要素の相対位置(dx, dy)の一覧 各成分が0以下であること
+     * @param[in] tile_size 並列化の単位となるタイルの一辺
+     * @param[in] pool 使用するスレッドプール
+     * @note タイル内は行優先で処理し、タイル同士は反対角線上の波面をワークスティーリングで処理する
+    */
+    template <typename Function>
+    void wavefront_foreach(const Function & func,
+        std::vector<std::pair<int, int>> const & dependencies = {{-1, 0}, {0, -1}},
+        size_type const tile_size = 64,
+        ThreadPool & pool = ThreadPool::global()){
+
+        int const t = static_cast<int>(tile_size);
+        std::vector<WavefrontScheduler::offset_type> cell_dependencies;
+        for(auto const & d : dependencies){
+            cell_dependencies.push_back({d.first, d.second, 0});
+        }
+        auto const predecessors = WavefrontScheduler::tile_dependencies(cell_dependencies, {t, t, 1});
+
+        WavefrontScheduler::offset_type const count{
+            static_cast<int>((m_width + tile_size - 1) / tile_size),
+            static_cast<int>((m_height + tile_size - 1) / tile_size),
+            1};
+        WavefrontScheduler::run(pool, count, predecessors, [&](size_type, size_type const ty, size_type const tx){
+            size_type const y_end = std::min(m_height, (ty + 1) * tile_size);
+            size_type const x_end = std::min(m_width, (tx + 1) * tile_size);
+            for(size_type i=ty*tile_size; i<y_end; ++i){
+                for(size_type j=tx*tile_size; j<x_end; ++j){
+                    func(i, j);
+                }
             }
+        });
+    }
+
+private:
+    /**
+     * @brief 格納領域をsize要素以上にする 足りなければ現在の容量の倍以上を確保し、挿入の繰り返しでの確保し直しを償却する
+    */
+    void grow_storage(size_type const size){
+        if(size > m_data.capacity()){
+            m_data.reserve(std::max(size, m_data.capacity() * 2));
+        }
+    }
+
+    /**
+     * @brief foreachのコールバックをy,xで呼べる形にする
+     * @note y,xと要素の参照を受け取る関数には、検査せずに求めた要素を渡す
+    */
+    template <typename Function>
+    auto element_callback(Function const & func){
+        if constexpr(std::is_invocable<Function const &, size_type, size_type, data_type &>::value){
+            return [this, &func](size_type const y, size_type const x){
+                func(y, x, m_data[m_layout.index(y, x)]);
+            };
+        }else{
+            return [&func](size_type const y, size_type const x){
+                func(y, x);
+            };
+        }
+    }
+
+    /**
+     * @brief 新しいバッファへ(w, h)のレイアウトで一括再配置する
+     * @note 確保は一度だけで、既存の要素はムーブされる
+    */
+    void relayout(size_type const w, size_type const h, data_type const & init){
+        size_type const copy_w = std::min(w, m_width);
+        size_type const copy_h = std::min(h, m_height);
+
+        if constexpr(!layout_type::is_row_major){
+            relayout_to(layout_type(w, h), w, h, init);
+            return;
+        }
+
+        container_type new_data(m_data.get_allocator());
+        new_data.reserve(w * h);
+        for(size_type i=0; i<copy_h; ++i){
+            auto const row = m_data.begin() + i * m_width;
+            new_data.insert(new_data.end(), std::make_move_iterator(row), std::make_move_iterator(row + copy_w));
+            new_data.insert(new_data.end(), w - copy_w, init);
+        }
+        new_data.insert(new_data.end(), (h - copy_h) * w, init);
+
+        m_data.swap(new_data);
+        m_width = w;
+        m_height = h;
+        m_layout = layout_type(m_width, m_height);
+    }
+
+    /**
+     * @brief 新しいバッファへnew_layoutで一括再配置する 行優先以外のレイアウト用
+    */
+    void relayout_to(layout_type const & new_layout, size_type const w, size_type const h, data_type const & init){
+        size_type const copy_w = std::min(w, m_width);
+        size_type const copy_h = std::min(h, m_height);
+
+        container_type new_data(new_layout.storage_size(), m_data.get_allocator());
+        new_layout.foreach(0, h, [&](size_type const i, size_type const j){
+            new_data[new_layout.index(i, j)] = (i < copy_h && j < copy_w)
+                ? std::move(m_data[m_layout.index(i, j)])
+                : init;
+        });
+        m_data.swap(new_data);
+        m_width = w;
+        m_height = h;
+        m_layout = new_layout;
+    }
+
+    /**
+     * @brief 余りの列を使って幅をw(<= pitch)に広げる 再配置しない
+    */
+    void grow_into_pitch(size_type const w, data_type const & init){
+        size_type const pitch = m_layout.pitch();
+        for(size_type i=0; i<m_height; ++i){
+            std::fill(m_data.begin() + (i * pitch + m_width), m_data.begin() + (i * pitch + w), init);
         }
+        m_width = w;
+        m_layout = layout_type(m_width, m_height, pitch);
     }
 
+    /**
+     * @brief 幅をw(<= m_width)に詰める
+     * @note 確保せずにその場で前方へムーブする
+    */
+    void compact_columns(size_type const w){
+        for(size_type i=1; i<m_height; ++i){
+            auto const row = m_data.begin() + i * m_width;
+            std::move(row, row + w, m_data.begin() + i * w);
+        }
+        m_data.erase(m_data.begin() + w * m_height, m_data.end());
+        m_width = w;
+        m_layout = layout_type(m_width, m_height);
+    }
+
+public:
 
 #ifdef UTILITY_POINT2I_H
 
@@ -391,16 +961,16 @@ public:
      * @brief (x, y)で要素アクセス
      * @param[in] pos (x,y)のPoint2i
     */
-    data_type & at(Point2i const & pos){
-        return at(pos.y, pos.x);
+    data_type & at(Point2i const & pos UTILITY_GRID_SITE){
+        return at(pos.y, pos.x UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief (x, y)で要素アクセス const
      * @param[in] pos (x,y)のPoint2i
     */
-    data_type const & at(Point2i const & pos) const {
-        return at(pos.y, pos.x);
+    data_type const & at(Point2i const & pos UTILITY_GRID_SITE) const {
+        return at(pos.y, pos.x UTILITY_GRID_SITE_ARG);
     }
 
     /**
@@ -408,7 +978,10 @@ public:
      * @param[in] pos (x,y)のPoint2i
     */
     data_type & operator [] (Point2i const & pos){
-        return operator[](pos.y)[pos.x];
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(pos.y, m_height);
+        bounds_policy::check(pos.x, m_width);
+        return m_data[m_layout.index(pos.y, pos.x)];
     }
 
     /**
@@ -416,7 +989,10 @@ public:
      * @param[in] pos (x,y)のPoint2i
     */
     data_type const & operator [] (Point2i const & pos) const {
-        return operator[](pos.y)[pos.x];
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(pos.y, m_height);
+        bounds_policy::check(pos.x, m_width);
+        return m_data[m_layout.index(pos.y, pos.x)];
     }
 
     /**
@@ -424,16 +1000,26 @@ public:
      * @param[in] size (width, height)のPoint2i
      * @param[in] init 初期化したい値
     */
-    void resize(Point2i const & size, data_type const & init){
-        resize(size.x, size.y, init);
+    void resize(Point2i const & size, data_type const & init UTILITY_GRID_SITE){
+        resize(size.x, size.y, init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief リサイズ
      * @param[in] size (width, height)のPoint2i
     */
-    void resize(Point2i const & size){
-        resize(size.x, size.y);
+    void resize(Point2i const & size UTILITY_GRID_SITE){
+        resize(size.x, size.y UTILITY_GRID_SITE_ARG);
+    }
+
+    /**
+     * @brief (x, y)のPoint2iで指定した[first, last)の領域のビュー
+    */
+    GridView2D<data_type> subgrid(Point2i const & first, Point2i const & last){
+        return view().subgrid(first, last);
+    }
+    GridView2D<data_type const> subgrid(Point2i const & first, Point2i const & last) const {
+        return view().subgrid(first, last);
     }
 
     /**
@@ -441,8 +1027,8 @@ public:
      * @param[in] pos (x, y)のPoint2i
      * @return 収まっていたらtrue
     */
-    bool in(Point2i const & pos) const {
-        return in(pos.y, pos.x);
+    bool in(Point2i const & pos UTILITY_GRID_SITE) const {
+        return in(pos.y, pos.x UTILITY_GRID_SITE_ARG);
     }
 
 
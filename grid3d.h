@@ -8,66 +8,127 @@
 
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <utility>
 #include <tuple>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include "grid_edit_batch.h"
+#include "thread_pool.h"
+#include "grid_wavefront.h"
+#include "grid_layout.h"
+#include "grid_bounds.h"
+#include "grid_instrument.h"
+#include "grid_trace.h"
+#include "grid_expression.h"
+#include "grid_view.h"
 
 namespace Utility{
 
-template <typename data_type>
-class Grid3D;
-
 /**
  * @brief Grid3Dのoperator[]アクセス用クラス
+ * @note data_typeがconstの場合は読み取り専用
+ * @note 行優先のレイアウトでは奥行zの先頭を構築時に求めておき、[y]は行の距離の乗算と加算だけで求める
 */
-template <typename data_type>
+template <typename data_type, typename layout_type = RowMajorLayout3D, typename bounds_policy = BoundsUnchecked>
 class Grid3DAccessController{
 private:
-    Grid3D<data_type> * grid;
+    data_type * data;
+    layout_type const * layout;
     int z_pos;
+    size_t height;
+    data_type * slice;  // 行優先のレイアウトでの奥行z_posの先頭
 
 public:
-    Grid3DAccessController(Grid3D<data_type> * grid, int const z_pos)
-        : grid(grid),
-        z_pos(z_pos){}
+    Grid3DAccessController(data_type * data, layout_type const * layout, int const z_pos, size_t const height = 0)
+        : data(data),
+        layout(layout),
+        z_pos(z_pos),
+        height(height),
+        slice(nullptr){
+        if constexpr(detail::is_strided_layout<layout_type>::value){
+            slice = data + layout->index(z_pos, 0, 0);
+        }
+    }
+
+    /**
+     * @brief Grid3Dの奥行z_posを参照する
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid3d<std::remove_const_t<grid_type>>::value, std::nullptr_t> = nullptr>
+    Grid3DAccessController(grid_type * grid, int const z_pos)
+        : Grid3DAccessController(grid->data(), &grid->layout(), z_pos, grid->height()){}
     
     /**
-     * @brief [y][x]で要素アクセス
+     * @brief [y][x]で要素アクセス yはbounds_policyに従って検査する
+     * @return 行が連続するレイアウトでは行の先頭のポインタ、それ以外では[x]でアクセスできるオブジェクト
     */
-    data_type * operator [] (int const y){
-        return &(grid->data()[z_pos * (grid->width()) * (grid->height()) + y * grid->width()]);
-    }
-    data_type const * operator [] (int const y) const {
-        return &(grid->data()[z_pos * (grid->width()) * (grid->height()) + y * grid->width()]);
+    auto operator [] (int const y) const {
+        bounds_policy::check(y, height);
+        if constexpr(detail::is_strided_layout<layout_type>::value && layout_type::rows_contiguous){
+            return slice + y * layout->row_stride();
+        }else if constexpr(layout_type::rows_contiguous){
+            return data + layout->index(z_pos, y, 0);
+        }else{
+            return GridRowAccessor3D<data_type, layout_type>(data, layout, z_pos, y);
+        }
     }
 };
 
 /**
  * @brief 三次元配列クラス at(z,y,x)でアクセス
+ * @tparam layout_type 要素の並べ方 RowMajorLayout3D(行優先)かMortonLayout3D(モートン順)
+ * @tparam bounds_policy at(), operator[]での範囲検査 BoundsChecked(例外), BoundsAssert(assert), BoundsUnchecked(検査なし)
+ * @note 行優先以外のレイアウトではdata_typeがデフォルト構築可能であること(余りの要素に使う)
 */
-template <typename data_type>
+template <typename data_type, typename layout_type = RowMajorLayout3D, typename allocator_type = std::allocator<data_type>,
+    typename bounds_policy = DefaultBoundsPolicy>
 class Grid3D{
 public:
-    using container_type = std::vector<data_type>;
+    using value_type = data_type;
+    using bounds_policy_type = bounds_policy;
+    using container_type = std::vector<data_type, allocator_type>;
     using size_type = size_t;
 
 private: 
-    container_type m_data;  // [x + y * m_width + z * m_width * m_height]でアクセス
+    container_type m_data;  // [m_layout.index(z, y, x)]でアクセス
     size_type m_width = 0;  // 横
     size_type m_height = 0; // 縦
     size_type m_depth = 0;  // 奥行
+    layout_type m_layout;   // 要素の並べ方
+    UTILITY_GRID_COUNTERS   // UTILITY_GRID_INSTRUMENTを定義した場合のみ
 
 public:
     Grid3D(size_type const m_width = 0, size_type const m_height = 0, size_type const m_depth = 0)
-        : m_data(m_width * m_height * m_depth),
+        : m_data(layout_type(m_width, m_height, m_depth).storage_size()),
+        m_width(m_width),
+        m_height(m_height),
+        m_depth(m_depth),
+        m_layout(m_width, m_height, m_depth){
+        UTILITY_GRID_TRACK_MEMORY();
+    }
+
+    Grid3D(size_type const m_width, size_type const m_height, size_type const m_depth, data_type const & init, allocator_type const & alloc = allocator_type())
+        : m_data(layout_type(m_width, m_height, m_depth).storage_size(), init, alloc),
         m_width(m_width),
         m_height(m_height),
-        m_depth(m_depth){}
+        m_depth(m_depth),
+        m_layout(m_width, m_height, m_depth){
+        UTILITY_GRID_TRACK_MEMORY();
+    }
 
-    Grid3D(size_type const m_width, size_type const m_height, size_type const m_depth, data_type const & init)
-        : m_data(m_width * m_height * m_depth, init),
+    /**
+     * @brief allocで確保して構築 要素は値初期化する
+     * @note ArenaAllocatorのようにデフォルト構築できないアロケータではこちらを使う
+    */
+    Grid3D(size_type const m_width, size_type const m_height, size_type const m_depth, allocator_type const & alloc)
+        : m_data(layout_type(m_width, m_height, m_depth).storage_size(), alloc),
         m_width(m_width),
         m_height(m_height),
-        m_depth(m_depth){}
+        m_depth(m_depth),
+        m_layout(m_width, m_height, m_depth){
+        UTILITY_GRID_TRACK_MEMORY();
+    }
     
     /**
      * @brief width, height, depthのタプルから構築
@@ -81,6 +142,85 @@ public:
     Grid3D(std::tuple<size_type, size_type, size_type> const & size, data_type const & init)
         : Grid3D(std::get<0>(size), std::get<1>(size), std::get<2>(size), init){}
 
+    /**
+     * @brief 要素ごとの演算式から構築
+     * @note a + b * 0.5f などを一度の走査で評価する
+    */
+    template <typename Expr, std::enable_if_t<detail::is_grid_expression<Expr>::value, std::nullptr_t> = nullptr>
+    Grid3D(Expr const & expr, allocator_type const & alloc = allocator_type())
+        : m_data(alloc){
+        *this = expr;
+    }
+
+    /**
+     * @brief 要素ごとの演算式を一度の走査で評価して代入する
+     * @note 式に含まれるグリッドの大きさは式ごとに一度だけ確認し、一致しなければstd::invalid_argumentを投げる
+     * @note 大きさが異なる場合は式の大きさに合わせる
+    */
+    template <typename Expr, std::enable_if_t<detail::is_grid_expression<Expr>::value, std::nullptr_t> = nullptr>
+    Grid3D & operator =(Expr const & expr){
+        GridShape shape;
+        size_type const storage_size = detail::check_expression_shape(expr, shape);
+        if constexpr(std::is_same<typename Expr::layout, layout_type>::value){
+            if(shape.width != m_width || shape.height != m_height || shape.depth != m_depth){
+                m_data.resize(storage_size);
+                m_width = shape.width;
+                m_height = shape.height;
+                m_depth = shape.depth;
+                m_layout = layout_type(m_width, m_height, m_depth);
+            }
+            detail::evaluate_expression(m_data.data(), expr, storage_size);
+        }else{
+            // 自身の別の位置を参照するビューを含みうるため、新しい領域に評価してから入れ替える
+            layout_type const new_layout(shape.width, shape.height, shape.depth);
+            container_type new_data(new_layout.storage_size(), m_data.get_allocator());
+            detail::evaluate_expression_at(new_data.data(), new_layout, expr, shape);
+            m_data.swap(new_data);
+            m_width = shape.width;
+            m_height = shape.height;
+            m_depth = shape.depth;
+            m_layout = new_layout;
+        }
+        UTILITY_GRID_TRACK_MEMORY();
+        return *this;
+    }
+
+    /**
+     * @brief 要素ごとの加算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid3D, Right>::value, std::nullptr_t> = nullptr>
+    Grid3D & operator +=(Right const & right){
+        return *this = *this + right;
+    }
+
+    /**
+     * @brief 要素ごとの減算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid3D, Right>::value, std::nullptr_t> = nullptr>
+    Grid3D & operator -=(Right const & right){
+        return *this = *this - right;
+    }
+
+    /**
+     * @brief 要素ごとの乗算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid3D, Right>::value, std::nullptr_t> = nullptr>
+    Grid3D & operator *=(Right const & right){
+        return *this = *this * right;
+    }
+
+    /**
+     * @brief 要素ごとの除算
+     * @param[in] right 同じ大きさのグリッド、式、またはスカラー
+    */
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<Grid3D, Right>::value, std::nullptr_t> = nullptr>
+    Grid3D & operator /=(Right const & right){
+        return *this = *this / right;
+    }
+
     /**
      * @brief 配列のクリア
     */
@@ -89,6 +229,8 @@ public:
         m_width = 0;
         m_height = 0;
         m_depth = 0;
+        m_layout = layout_type();
+        UTILITY_GRID_TRACK_MEMORY();
     }
 
     /**
@@ -96,8 +238,16 @@ public:
      * @param[in] pos 挿入する場所(挿入する位置がpos(0-indexed)列目になるように)
      * @param[in] init 初期化する値
     */
-    void insert_column(int const pos, data_type const & init){
-        reserve(m_width+1, m_height, m_depth);
+    void insert_column(int const pos, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::insert_column", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.insert_column(pos, init);
+            apply_edits(batch);
+            return;
+        }
+        grow_storage(layout_type(m_width+1, m_height, m_depth).storage_size());
 
         for(size_type i=0; i<m_depth; ++i){
             for(size_type j=0; j<m_height; ++j){
@@ -106,6 +256,7 @@ public:
         }
 
         ++m_width;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
@@ -113,14 +264,23 @@ public:
      * @param[in] pos 挿入する場所(挿入する位置がpos行目になるように)
      * @param[in] init 初期化する値
     */
-    void insert_row(int const pos, data_type const & init){
-        reserve(m_width, m_height+1, m_depth);
+    void insert_row(int const pos, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertRow);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::insert_row", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.insert_row(pos, init);
+            apply_edits(batch);
+            return;
+        }
+        grow_storage(layout_type(m_width, m_height+1, m_depth).storage_size());
 
         for(size_type i=0; i<m_depth; ++i){
             m_data.insert(m_data.begin() + pos*m_width + i * (m_width) * (m_height + 1), m_width, init);
         }
         
         ++m_height;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
@@ -128,70 +288,99 @@ public:
      * @param[in] pos 挿入する場所(挿入する位置がpos奥目になるように)
      * @param[in] init 初期化する値
     */
-    void insert_depth(int const pos, data_type const & init){
-        reserve(m_width, m_height, m_depth+1);
+    void insert_depth(int const pos, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertDepth);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::insert_depth", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.insert_depth(pos, init);
+            apply_edits(batch);
+            return;
+        }
+        grow_storage(layout_type(m_width, m_height, m_depth+1).storage_size());
 
         m_data.insert(m_data.begin() + pos*m_width*m_height, m_width*m_height, init);
         
         ++m_depth;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
      * @brief 列を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_column(data_type const & init){
-        insert_column(m_width, init);
+    void push_back_column(data_type const & init UTILITY_GRID_SITE){
+        push_back_columns(1, init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 行を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_row(data_type const & init){
-        insert_row(m_height, init);
+    void push_back_row(data_type const & init UTILITY_GRID_SITE){
+        push_back_rows(1, init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 奥を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_depth(data_type const & init){
-        for(size_type i=0; i<m_width*m_height; ++i){
-            m_data.push_back(init);
-        }
-        ++m_depth;
+    void push_back_depth(data_type const & init UTILITY_GRID_SITE){
+        push_back_depths(1, init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 複数の列を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_columns(size_type const n, data_type const & init){
-        for(size_type i=0; i<n; ++i) push_back_column(init);
+    void push_back_columns(size_type const n, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::push_back_columns", m_width, m_height, m_depth);
+        if(n == 0) return;
+        relayout(m_width + n, m_height, m_depth, init);
     }
 
     /**
      * @brief 複数の行を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_rows(size_type const n, data_type const & init){
-        for(size_type i=0; i<n; ++i) push_back_row(init);
+    void push_back_rows(size_type const n, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertRow);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::push_back_rows", m_width, m_height, m_depth);
+        if(n == 0) return;
+        relayout(m_width, m_height + n, m_depth, init);
     }
 
     /**
      * @brief 複数の奥を後方に追加
      * @param[in] init 初期化する値
     */
-    void push_back_depths(size_type const n, data_type const & init){
-        for(size_type i=0; i<n; ++i) push_back_depth(init);
+    void push_back_depths(size_type const n, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::InsertDepth);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::push_back_depths", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            if(n == 0) return;
+            relayout(m_width, m_height, m_depth + n, init);
+            return;
+        }
+        m_data.insert(m_data.end(), n * m_width * m_height, init);
+        m_depth += n;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
      * @brief 任意の列の削除
      * @param[in] pos 消したい列(pos(0-indexed)列目となるように)
     */
-    void remove_column(size_type const pos){
+    void remove_column(size_type const pos UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::remove_column", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.remove_column(pos);
+            apply_edits(batch);
+            return;
+        }
         int index = 0;
 
         auto remove_it = std::remove_if(m_data.begin(), m_data.end(), [width = m_width, &pos, &index](data_type const &){
@@ -200,13 +389,22 @@ public:
         m_data.erase(remove_it, m_data.end());
 
         --m_width;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
      * @brief 任意の行の削除
      * @param[in] pos 消したい行(pos(0-indexed)行目となるように)
     */
-    void remove_row(size_type const pos){
+    void remove_row(size_type const pos UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveRow);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::remove_row", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.remove_row(pos);
+            apply_edits(batch);
+            return;
+        }
         // auto it = m_data.begin() + pos * m_width;
 
         // for(size_type i=0; i<m_depth; ++i){
@@ -222,90 +420,201 @@ public:
         m_data.erase(remove_it, m_data.end());
 
         --m_height;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
      * @brief 任意の奥の削除
      * @param[in] pos 消したい奥(pos(0-indexed)奥目となるように)
     */
-    void remove_depth(int const pos){
+    void remove_depth(int const pos UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveDepth);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::remove_depth", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            GridEditBatch<data_type> batch;
+            batch.remove_depth(pos);
+            apply_edits(batch);
+            return;
+        }
         auto it_begin = m_data.begin() + pos * m_width * m_height;
         m_data.erase(it_begin, it_begin + m_width * m_height);
         
         --m_depth;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
      * @brief 後方の列の削除
     */
-    void pop_back_column(){
-        remove_column(m_width - 1);
+    void pop_back_column(UTILITY_GRID_SITE_ONLY){
+        pop_back_columns(1 UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 後方の行の削除
     */
-    void pop_back_row(){
-        remove_row(m_height - 1);
+    void pop_back_row(UTILITY_GRID_SITE_ONLY){
+        pop_back_rows(1 UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 後方の奥の削除
     */
-    void pop_back_depth(){
-        --m_depth;
-        m_data.resize(m_data.size() - m_width * m_height);
+    void pop_back_depth(UTILITY_GRID_SITE_ONLY){
+        pop_back_depths(1 UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 後方の複数の列の削除
     */
-    void pop_back_columns(size_type const n){
-        for(size_type i=0; i<n; ++i) pop_back_column();
+    void pop_back_columns(size_type const n UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveColumn);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::pop_back_columns", m_width, m_height, m_depth);
+        if(n == 0) return;
+        if constexpr(!layout_type::is_row_major){
+            relayout(m_width - n, m_height, m_depth, data_type{});
+            return;
+        }
+        compact(m_width - n, m_height);
     }
 
     /**
      * @brief 後方の複数の行の削除
     */
-    void pop_back_rows(size_type const n){
-        for(size_type i=0; i<n; ++i) pop_back_row();
+    void pop_back_rows(size_type const n UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveRow);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::pop_back_rows", m_width, m_height, m_depth);
+        if(n == 0) return;
+        if constexpr(!layout_type::is_row_major){
+            relayout(m_width, m_height - n, m_depth, data_type{});
+            return;
+        }
+        compact(m_width, m_height - n);
     }
 
     /**
      * @brief 後方の複数の奥の削除
     */
-    void pop_back_depths(size_type const n){
-        for(size_type i=0; i<n; ++i) pop_back_depth();
+    void pop_back_depths(size_type const n UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::RemoveDepth);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::pop_back_depths", m_width, m_height, m_depth);
+        if constexpr(!layout_type::is_row_major){
+            if(n == 0) return;
+            relayout(m_width, m_height, m_depth - n, data_type{});
+            return;
+        }
+        m_data.erase(m_data.end() - n * m_width * m_height, m_data.end());
+        m_depth -= n;
+        m_layout = layout_type(m_width, m_height, m_depth);
+    }
+
+    /**
+     * @brief 記録した行・列・奥の挿入と削除を一度に適用する
+     * @param[in] batch 適用する操作 削除位置は適用前、挿入位置は適用後のインデックス
+     * @note 操作の数によらず、新しいバッファへ一度だけ再配置する
+    */
+    void apply_edits(GridEditBatch<data_type> const & batch UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::ApplyEdits);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::apply_edits", m_width, m_height, m_depth);
+        if(batch.empty()) return;
+
+        detail::GridEditAxisMap<data_type> const xs(m_width, batch, GridAxis::Column);
+        detail::GridEditAxisMap<data_type> const ys(m_height, batch, GridAxis::Row);
+        detail::GridEditAxisMap<data_type> const zs(m_depth, batch, GridAxis::Depth);
+
+        if constexpr(!layout_type::is_row_major){
+            layout_type const new_layout(xs.size(), ys.size(), zs.size());
+            container_type new_data(new_layout.storage_size(), m_data.get_allocator());
+            new_layout.foreach(0, new_layout.band_count(), [&](size_type const i, size_type const j, size_type const k){
+                auto const insertion = detail::latest_insertion(zs.insertion(i), detail::latest_insertion(ys.insertion(j), xs.insertion(k)));
+                new_data[new_layout.index(i, j, k)] = (insertion != nullptr)
+                    ? insertion->init
+                    : std::move(m_data[m_layout.index(zs.source(i), ys.source(j), xs.source(k))]);
+            });
+            m_data.swap(new_data);
+            m_width = xs.size();
+            m_height = ys.size();
+            m_depth = zs.size();
+            m_layout = new_layout;
+            return;
+        }
+
+        container_type new_data(m_data.get_allocator());
+        new_data.reserve(xs.size() * ys.size() * zs.size());
+        for(size_type i=0; i<zs.size(); ++i){
+            auto const depth_insertion = zs.insertion(i);
+            for(size_type j=0; j<ys.size(); ++j){
+                auto const row_insertion = detail::latest_insertion(depth_insertion, ys.insertion(j));
+                if(row_insertion != nullptr){
+                    for(size_type k=0; k<xs.size(); ++k){
+                        new_data.push_back(detail::latest_insertion(row_insertion, xs.insertion(k))->init);
+                    }
+                    continue;
+                }
+                auto const row = m_data.begin() + ys.source(j) * m_width + zs.source(i) * m_width * m_height;
+                for(size_type k=0; k<xs.size(); ++k){
+                    auto const column_insertion = xs.insertion(k);
+                    if(column_insertion != nullptr){
+                        new_data.push_back(column_insertion->init);
+                    }else{
+                        new_data.push_back(std::move(row[xs.source(k)]));
+                    }
+                }
+            }
+        }
+
+        m_data.swap(new_data);
+        m_width = xs.size();
+        m_height = ys.size();
+        m_depth = zs.size();
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
     /**
      * @brief リザーブ
-     * @note m_width, m_height, m_depthは変えない
+     * @note m_width, m_height, m_depthは変えない 既に足りていれば何もしない
+    */
+    void reserve(size_type const w, size_type const h, size_type const d UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::Reserve);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::reserve", m_width, m_height, m_depth);
+        m_data.reserve(layout_type(w, h, d).storage_size());
+    }
+
+    /**
+     * @brief 使っていない格納領域を解放する
+     * @note 要素は新しい領域へ移動するため、ポインタ、ビューは無効になる
     */
-    void reserve(int const w, int const h, int const d){
-        m_data.reserve(w * h * d);
+    void shrink_to_fit(UTILITY_GRID_SITE_ONLY){
+        UTILITY_GRID_RECORD_EDIT(GridOp::ShrinkToFit);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::shrink_to_fit", m_width, m_height, m_depth);
+        m_data.shrink_to_fit();
     }
 
     /**
      * @brief リサイズ
+     * @note 幅か縦が増える場合は新しいバッファへ一度だけ再配置する
     */
-    void resize(size_type const w, size_type const h, size_type const d, data_type const & init){
-        // 幅を合わせる
-        if(w < m_width){
-            pop_back_columns(m_width - w);
-        }else if(w > m_width){
-            push_back_columns(w - m_width, init);
+    void resize(size_type const w, size_type const h, size_type const d, data_type const & init UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD_EDIT(GridOp::Resize);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::resize", m_width, m_height, m_depth);
+        // 行優先以外では常に一括で再配置
+        if constexpr(!layout_type::is_row_major){
+            if(w != m_width || h != m_height || d != m_depth) relayout(w, h, d, init);
+            return;
         }
-        // 縦を合わせる
-        if(h < m_height){
-            pop_back_rows(m_height - h);
-        }else if(h > m_height){
-            push_back_rows(h - m_height, init);
+        // 幅か縦が増える場合は一括で再配置
+        if(w > m_width || h > m_height){
+            relayout(w, h, d, init);
+            return;
         }
-        // 奥行を合わせる
+        // 奥行を減らしてから幅と縦を詰める(捨てる奥を移動しないように)
         if(d < m_depth){
             pop_back_depths(m_depth - d);
-        }else if(d > m_depth){
+        }
+        if(w < m_width || h < m_height){
+            compact(w, h);
+        }
+        if(d > m_depth){
             push_back_depths(d - m_depth, init);
         }
     }
@@ -315,82 +624,105 @@ public:
      * @param[in] size (width, height, depth)のタプル
      * @param[in] init 初期化したい値
     */
-    void resize(std::tuple<size_type, size_type, size_type> const & size, data_type const & init){
-        resize(std::get<0>(size), std::get<1>(size), std::get<2>(size), init);
+    void resize(std::tuple<size_type, size_type, size_type> const & size, data_type const & init UTILITY_GRID_SITE){
+        resize(std::get<0>(size), std::get<1>(size), std::get<2>(size), init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief リサイズ
     */
-    void resize(size_type const w, size_type const h, size_type const d){
-        resize(w, h, d, data_type{});
+    void resize(size_type const w, size_type const h, size_type const d UTILITY_GRID_SITE){
+        resize(w, h, d, data_type{} UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief リサイズ
     */
-    void resize(std::tuple<size_type, size_type, size_type> const & size){
-        resize(std::get<0>(size), std::get<1>(size), std::get<2>(size));
+    void resize(std::tuple<size_type, size_type, size_type> const & size UTILITY_GRID_SITE){
+        resize(std::get<0>(size), std::get<1>(size), std::get<2>(size) UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 一番最初の要素のlvalue参照
     */
     data_type & front(){
-        return m_data.front();
+        return m_data[m_layout.index(0, 0, 0)];
     }
     data_type const & front() const {
-        return m_data.front();
+        return m_data[m_layout.index(0, 0, 0)];
     }
 
     /**
      * @brief 一番最後の要素のlvalue参照
     */
     data_type & back(){
-        return m_data.back();
+        return m_data[m_layout.index(m_depth - 1, m_height - 1, m_width - 1)];
     }
     data_type const & back() const {
-        return m_data.back();
+        return m_data[m_layout.index(m_depth - 1, m_height - 1, m_width - 1)];
     }
 
     /**
-     * @brief 要素アクセス
+     * @brief 要素アクセス 範囲の検査はbounds_policyに従う
     */
-    data_type & at(int const z, int const y, int const x){
-        return m_data.at(x + y*m_width + z*m_width*m_height);
+    data_type & at(int const z, int const y, int const x UTILITY_GRID_SITE){
+        UTILITY_GRID_RECORD(GridOp::At);
+        bounds_policy::check(z, m_depth);
+        bounds_policy::check(y, m_height);
+        bounds_policy::check(x, m_width);
+        return m_data[m_layout.index(z, y, x)];
     }
 
     /**
      * @brief (x,y,z)のタプルにより要素アクセス
      * @param[in] pos (x,y,z)のタプル
     */
-    data_type & at(std::tuple<int, int, int> const pos){
-        return m_data.at(std::get<0>(pos) + std::get<1>(pos)*m_width + std::get<2>(pos)*m_width*m_height);
+    data_type & at(std::tuple<int, int, int> const pos UTILITY_GRID_SITE){
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos) UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief 要素アクセス const
     */
-    data_type const & at(int const z, int const y, int const x) const {
-        return m_data.at(x + y*m_width + z*m_width*m_height);
+    data_type const & at(int const z, int const y, int const x UTILITY_GRID_SITE) const {
+        UTILITY_GRID_RECORD(GridOp::At);
+        bounds_policy::check(z, m_depth);
+        bounds_policy::check(y, m_height);
+        bounds_policy::check(x, m_width);
+        return m_data[m_layout.index(z, y, x)];
     }
 
     /**
      * @brief (x,y,z)のタプルにより要素アクセス const
      * @param[in] pos (x,y,z)のタプル
     */
-    data_type const & at(std::tuple<int, int, int> const pos) const {
-        return m_data.at(std::get<0>(pos) + std::get<1>(pos)*m_width + std::get<2>(pos)*m_width*m_height);
+    data_type const & at(std::tuple<int, int, int> const pos UTILITY_GRID_SITE) const {
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos) UTILITY_GRID_SITE_ARG);
+    }
+
+    /**
+     * @brief 範囲を検査しない要素アクセス foreachのコールバックなど、添字が範囲内と分かっている場所で使う
+    */
+    data_type & at_unchecked(size_type const z, size_type const y, size_type const x){
+        return m_data[m_layout.index(z, y, x)];
+    }
+    data_type const & at_unchecked(size_type const z, size_type const y, size_type const x) const {
+        return m_data[m_layout.index(z, y, x)];
     }
 
     /**
      * @brief [z][y][x]で要素アクセス
+     * @note z, yはbounds_policyに従って検査する 行の先頭のポインタを返す場合、xは検査しない
     */
-    Grid3DAccessController<data_type> operator [] (int const z){
-        return Grid3DAccessController<data_type>(this, z);
+    Grid3DAccessController<data_type, layout_type, bounds_policy> operator [] (int const z){
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(z, m_depth);
+        return Grid3DAccessController<data_type, layout_type, bounds_policy>(m_data.data(), &m_layout, z, m_height);
     }
-    Grid3DAccessController<data_type> const operator [] (int const z) const {
-        return Grid3DAccessController<data_type>(this, z);
+    Grid3DAccessController<data_type const, layout_type, bounds_policy> operator [] (int const z) const {
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(z, m_depth);
+        return Grid3DAccessController<data_type const, layout_type, bounds_policy>(m_data.data(), &m_layout, z, m_height);
     }
 
     /**
@@ -398,10 +730,18 @@ public:
      * @param[in] pos (x,y,z)のタプル
     */
     data_type & operator [] (std::tuple<int, int, int> const & pos){
-        return operator[](std::get<2>(pos))[std::get<1>(pos)][std::get<0>(pos)];
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(std::get<2>(pos), m_depth);
+        bounds_policy::check(std::get<1>(pos), m_height);
+        bounds_policy::check(std::get<0>(pos), m_width);
+        return m_data[m_layout.index(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos))];
     }
     data_type const & operator [] (std::tuple<int, int, int> const & pos) const {
-        return operator[](std::get<2>(pos))[std::get<1>(pos)][std::get<0>(pos)];
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(std::get<2>(pos), m_depth);
+        bounds_policy::check(std::get<1>(pos), m_height);
+        bounds_policy::check(std::get<0>(pos), m_width);
+        return m_data[m_layout.index(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos))];
     }
 
     /**
@@ -427,17 +767,121 @@ public:
 
     /**
      * @brief 配列の先頭要素のポインタを返す
+     * @note 要素はレイアウトの順に並んでいる
     */
     data_type * data(){
         return m_data.data();
     }
+    data_type const * data() const {
+        return m_data.data();
+    }
+
+    /**
+     * @brief レイアウトを返す
+    */
+    layout_type const & layout() const {
+        return m_layout;
+    }
+
+    /**
+     * @brief 格納領域のアロケータを返す
+    */
+    allocator_type get_allocator() const {
+        return m_data.get_allocator();
+    }
+
+    /**
+     * @brief 格納領域の使用量 確保し直しの回数などはUTILITY_GRID_INSTRUMENTを定義した場合のみ記録される
+    */
+    GridMemoryStats memory_stats() const {
+#ifdef UTILITY_GRID_INSTRUMENT
+        GridMemoryStats stats = m_counters.memory_stats();
+#else
+        GridMemoryStats stats;
+#endif
+        stats.size_bytes = m_data.size() * sizeof(data_type);
+        stats.capacity_bytes = m_data.capacity() * sizeof(data_type);
+        stats.peak_bytes = std::max(stats.peak_bytes, stats.capacity_bytes);
+        return stats;
+    }
+
+#ifdef UTILITY_GRID_INSTRUMENT
+    /**
+     * @brief このグリッドへのアクセスと構造の変更の計数
+    */
+    GridCounters & counters() const {
+        return m_counters;
+    }
+#endif
+
+    /**
+     * @brief 全体のビュー
+     * @note 行優先のレイアウトのみ
+    */
+    GridView3D<data_type> view(){
+        static_assert(layout_type::is_row_major, "Grid3D::view: layout must be row-major");
+        return GridView3D<data_type>(m_data.data(), m_width, m_height, m_depth, m_width * m_height, m_width);
+    }
+    GridView3D<data_type const> view() const {
+        static_assert(layout_type::is_row_major, "Grid3D::view: layout must be row-major");
+        return GridView3D<data_type const>(m_data.data(), m_width, m_height, m_depth, m_width * m_height, m_width);
+    }
+
+    /**
+     * @brief [z_first, z_last)x[y_first, y_last)x[x_first, x_last)の領域のビュー 範囲外ではstd::out_of_rangeを投げる
+     * @note 要素はコピーしない 行優先のレイアウトのみ
+    */
+    GridView3D<data_type> subgrid(size_type const z_first, size_type const y_first, size_type const x_first,
+        size_type const z_last, size_type const y_last, size_type const x_last){
+        return view().subgrid(z_first, y_first, x_first, z_last, y_last, x_last);
+    }
+    GridView3D<data_type const> subgrid(size_type const z_first, size_type const y_first, size_type const x_first,
+        size_type const z_last, size_type const y_last, size_type const x_last) const {
+        return view().subgrid(z_first, y_first, x_first, z_last, y_last, x_last);
+    }
+
+    /**
+     * @brief z枚目のxy平面を二次元のビューとして返す (y, x)でアクセスする
+     * @note 要素はコピーしない 行優先のレイアウトのみ 範囲外ではstd::out_of_rangeを投げる
+    */
+    GridView2D<data_type> slice_z(size_type const z){
+        return view().slice_z(z);
+    }
+    GridView2D<data_type const> slice_z(size_type const z) const {
+        return view().slice_z(z);
+    }
+
+    /**
+     * @brief y行目のxz平面を二次元のビューとして返す (z, x)でアクセスする
+     * @note 幅はwidth()、高さはdepth()
+    */
+    GridView2D<data_type> slice_y(size_type const y){
+        return view().slice_y(y);
+    }
+    GridView2D<data_type const> slice_y(size_type const y) const {
+        return view().slice_y(y);
+    }
+
+    /**
+     * @brief x列目のyz平面を二次元のビューとして返す (z, y)でアクセスする
+     * @note 幅はheight()、高さはdepth() 要素は連続していないため、間隔を置いてアクセスする
+    */
+    GridView2D<data_type> slice_x(size_type const x){
+        return view().slice_x(x);
+    }
+    GridView2D<data_type const> slice_x(size_type const x) const {
+        return view().slice_x(x);
+    }
 
     /**
      * @brief 範囲内に収まるかを調べる
      * @return 収まっていたらtrue
     */
-    bool in(int const z, int const y, int const x) const {
-        return z >= 0 && z < m_depth && y >= 0 && y < m_height && x >= 0 && x < m_width;
+    bool in(int const z, int const y, int const x UTILITY_GRID_SITE) const {
+        bool const result = z >= 0 && static_cast<size_type>(z) < m_depth && y >= 0 && static_cast<size_type>(y) < m_height
+            && x >= 0 && static_cast<size_type>(x) < m_width;
+        if(!result) UTILITY_GRID_RECORD(GridOp::InMiss);
+        return result;
     }
 
     /**
@@ -445,8 +889,8 @@ public:
      * @param[in] pos (x, y, z)のタプル
      * @return 収まっていたらtrue
     */
-    bool in(std::tuple<int, int, int> const & pos) const {
-        return in(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    bool in(std::tuple<int, int, int> const & pos UTILITY_GRID_SITE) const {
+        return in(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos) UTILITY_GRID_SITE_ARG);
     }
 
     /**
@@ -461,11 +905,12 @@ public:
      * @brief 出力
     */
     void print() const {
+        UTILITY_GRID_TRACE_SPAN("Grid3D::print", m_width, m_height, m_depth);
         for(size_type i=0; i<m_height; ++i){
             for(size_type j=0; j<m_depth; ++j){
                 std::cout << '[';
                 for(size_type k=0; k<m_width; ++k){
-                    std::cout << at(j, i, k);
+                    std::cout << at_unchecked(j, i, k);
                     std::cout << ((k == m_width - 1) ? "" : " ");
                 }
                 std::cout << "] ";
@@ -483,19 +928,172 @@ public:
 
     /**
      * @brief 各要素への一律な操作
-     * @param[in] func z,y,xを引数として受け取る関数
+     * @param[in] func z,y,xか、z,y,xと要素の参照を引数として受け取る関数
+     * @note レイアウトの格納順(MortonLayout3Dならブリック順)に走査する
+     * @note 要素の参照はbounds_policyによらず検査せずに渡す(添字は常に範囲内)
     */
     template <typename Function>
     void foreach(const Function & func){
-        for(size_type i=0; i<m_depth; ++i){
-            for(size_type j=0; j<m_height; ++j){
-                for(size_type k=0; k<m_width; ++k){
-                    func(i, j, k);
+        UTILITY_GRID_TRACE_SPAN("Grid3D::foreach", m_width, m_height, m_depth);
+        m_layout.foreach(0, m_layout.band_count(), element_callback(func));
+    }
+
+    /**
+     * @brief 各要素への一律な操作を並列に行う
+     * @param[in] func z,y,xか、z,y,xと要素の参照を引数として受け取る関数 異なる要素に対して同時に呼ばれる
+    */
+    template <typename Function>
+    void parallel_foreach(const Function & func){
+        parallel_foreach(ThreadPool::global(), func);
+    }
+
+    /**
+     * @brief 各要素への一律な操作を、指定したプールで並列に行う
+     * @param[in] pool 使用するスレッドプール
+     * @param[in] func z,y,xか、z,y,xと要素の参照を引数として受け取る関数 異なる要素に対して同時に呼ばれる
+     * @note (z, y)の行(MortonLayout3Dではブリックの列)を通し番号にして連続した範囲で分割するため、奥行が小さくても全スレッドに行き渡る
+    */
+    template <typename Function>
+    void parallel_foreach(ThreadPool & pool, const Function & func){
+        UTILITY_GRID_TRACE_SPAN("Grid3D::parallel_foreach", m_width, m_height, m_depth);
+        auto const callback = element_callback(func);
+        pool.parallel_for(0, m_layout.band_count(), [&](size_type const first, size_type const last){
+            m_layout.foreach(first, last, callback);
+        });
+    }
+
+    /**
+     * @brief 隣接要素への依存関係を満たす順序で、各要素への操作をタイル単位で並列に行う
+     * @param[in] func z,y,xを引数として受け取る関数 依存先の要素の処理が終わった後に呼ばれる
+     * @param[in] dependencies (z, y, x)が依存する要素の相対位置(dx, dy, dz)の一覧 各成分が0以下であること
+     * @param[in] tile_size 並列化の単位となるタイルの一辺
+     * @param[in] pool 使用するスレッドプール
+     * @note タイル内はz,y,xの順で処理し、タイル同士は波面をワークスティーリングで処理する
+    */
+    template <typename Function>
+    void wavefront_foreach(const Function & func,
+        std::vector<std::tuple<int, int, int>> const & dependencies = {{-1, 0, 0}, {0, -1, 0}, {0, 0, -1}},
+        size_type const tile_size = 16,
+        ThreadPool & pool = ThreadPool::global()){
+
+        int const t = static_cast<int>(tile_size);
+        std::vector<WavefrontScheduler::offset_type> cell_dependencies;
+        for(auto const & d : dependencies){
+            cell_dependencies.push_back({std::get<0>(d), std::get<1>(d), std::get<2>(d)});
+        }
+        auto const predecessors = WavefrontScheduler::tile_dependencies(cell_dependencies, {t, t, t});
+
+        WavefrontScheduler::offset_type const count{
+            static_cast<int>((m_width + tile_size - 1) / tile_size),
+            static_cast<int>((m_height + tile_size - 1) / tile_size),
+            static_cast<int>((m_depth + tile_size - 1) / tile_size)};
+        WavefrontScheduler::run(pool, count, predecessors, [&](size_type const tz, size_type const ty, size_type const tx){
+            size_type const z_end = std::min(m_depth, (tz + 1) * tile_size);
+            size_type const y_end = std::min(m_height, (ty + 1) * tile_size);
+            size_type const x_end = std::min(m_width, (tx + 1) * tile_size);
+            for(size_type i=tz*tile_size; i<z_end; ++i){
+                for(size_type j=ty*tile_size; j<y_end; ++j){
+                    for(size_type k=tx*tile_size; k<x_end; ++k){
+                        func(i, j, k);
+                    }
                 }
             }
+        });
+    }
+
+private:
+    /**
+     * @brief 格納領域をsize要素以上にする 足りなければ現在の容量の倍以上を確保し、挿入の繰り返しでの確保し直しを償却する
+    */
+    void grow_storage(size_type const size){
+        if(size > m_data.capacity()){
+            m_data.reserve(std::max(size, m_data.capacity() * 2));
+        }
+    }
+
+    /**
+     * @brief foreachのコールバックをz,y,xで呼べる形にする
+     * @note z,y,xと要素の参照を受け取る関数には、検査せずに求めた要素を渡す
+    */
+    template <typename Function>
+    auto element_callback(Function const & func){
+        if constexpr(std::is_invocable<Function const &, size_type, size_type, size_type, data_type &>::value){
+            return [this, &func](size_type const z, size_type const y, size_type const x){
+                func(z, y, x, m_data[m_layout.index(z, y, x)]);
+            };
+        }else{
+            return [&func](size_type const z, size_type const y, size_type const x){
+                func(z, y, x);
+            };
+        }
+    }
+
+
+    /**
+     * @brief 新しいバッファへ(w, h, d)のレイアウトで一括再配置する
+     * @note 確保は一度だけで、既存の要素はムーブされる
+    */
+    void relayout(size_type const w, size_type const h, size_type const d, data_type const & init){
+        size_type const copy_w = std::min(w, m_width);
+        size_type const copy_h = std::min(h, m_height);
+        size_type const copy_d = std::min(d, m_depth);
+
+        if constexpr(!layout_type::is_row_major){
+            layout_type const new_layout(w, h, d);
+            container_type new_data(new_layout.storage_size(), m_data.get_allocator());
+            new_layout.foreach(0, new_layout.band_count(), [&](size_type const i, size_type const j, size_type const k){
+                new_data[new_layout.index(i, j, k)] = (i < copy_d && j < copy_h && k < copy_w)
+                    ? std::move(m_data[m_layout.index(i, j, k)])
+                    : init;
+            });
+            m_data.swap(new_data);
+            m_width = w;
+            m_height = h;
+            m_depth = d;
+            m_layout = new_layout;
+            return;
+        }
+
+        container_type new_data(m_data.get_allocator());
+        new_data.reserve(w * h * d);
+        for(size_type i=0; i<copy_d; ++i){
+            for(size_type j=0; j<copy_h; ++j){
+                auto const row = m_data.begin() + j * m_width + i * m_width * m_height;
+                new_data.insert(new_data.end(), std::make_move_iterator(row), std::make_move_iterator(row + copy_w));
+                new_data.insert(new_data.end(), w - copy_w, init);
+            }
+            new_data.insert(new_data.end(), (h - copy_h) * w, init);
         }
+        new_data.insert(new_data.end(), (d - copy_d) * w * h, init);
+
+        m_data.swap(new_data);
+        m_width = w;
+        m_height = h;
+        m_depth = d;
+        m_layout = layout_type(m_width, m_height, m_depth);
+    }
+
+    /**
+     * @brief 幅をw(<= m_width)、縦をh(<= m_height)に詰める
+     * @note 確保せずにその場で前方へムーブする
+    */
+    void compact(size_type const w, size_type const h){
+        for(size_type i=0; i<m_depth; ++i){
+            for(size_type j=0; j<h; ++j){
+                size_type const src = j * m_width + i * m_width * m_height;
+                size_type const dst = j * w + i * w * h;
+                if(src == dst) continue;
+                std::move(m_data.begin() + src, m_data.begin() + src + w, m_data.begin() + dst);
+            }
+        }
+        m_data.erase(m_data.begin() + w * h * m_depth, m_data.end());
+        m_width = w;
+        m_height = h;
+        m_layout = layout_type(m_width, m_height, m_depth);
     }
 
+public:
+
 #ifdef EIGEN_CORE_H
 
     // Eigen/Coreがincludeされている場合
@@ -516,16 +1114,16 @@ public:
      * @brief (x, y, z)で要素アクセス
      * @param[in] pos (x,y,z)の整数ベクトル
     */
-    data_type & at(Eigen::Vector3i const & pos){
-        return at(pos.z(), pos.y(), pos.x());
+    data_type & at(Eigen::Vector3i const & pos UTILITY_GRID_SITE){
+        return at(pos.z(), pos.y(), pos.x() UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief (x, y, z)で要素アクセス const
      * @param[in] pos (x,y,z)の整数ベクトル
     */
-    data_type const & at(Eigen::Vector3i const & pos) const {
-        return at(pos.z(), pos.y(), pos.x());
+    data_type const & at(Eigen::Vector3i const & pos UTILITY_GRID_SITE) const {
+        return at(pos.z(), pos.y(), pos.x() UTILITY_GRID_SITE_ARG);
     }
 
     /**
@@ -533,7 +1131,11 @@ public:
      * @param[in] pos (x,y,z)の整数ベクトル
     */
     data_type & operator [] (Eigen::Vector3i const & pos){
-        return operator[](pos.z())[pos.y()][pos.x()];
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(pos.z(), m_depth);
+        bounds_policy::check(pos.y(), m_height);
+        bounds_policy::check(pos.x(), m_width);
+        return m_data[m_layout.index(pos.z(), pos.y(), pos.x())];
     }
 
     /**
@@ -541,7 +1143,11 @@ public:
      * @param[in] pos (x,y,z)の整数ベクトル
     */
     data_type const & operator [] (Eigen::Vector3i const & pos) const {
-        return operator[](pos.z())[pos.y()][pos.x()];
+        UTILITY_GRID_RECORD_SUBSCRIPT();
+        bounds_policy::check(pos.z(), m_depth);
+        bounds_policy::check(pos.y(), m_height);
+        bounds_policy::check(pos.x(), m_width);
+        return m_data[m_layout.index(pos.z(), pos.y(), pos.x())];
     }
 
     /**
@@ -549,16 +1155,16 @@ public:
      * @param[in] size (width, height, depth)の整数ベクトル
      * @param[in] init 初期化したい値
     */
-    void resize(Eigen::Vector3i const & size, data_type const & init){
-        resize(size.x(), size.y(), size.z(), init);
+    void resize(Eigen::Vector3i const & size, data_type const & init UTILITY_GRID_SITE){
+        resize(size.x(), size.y(), size.z(), init UTILITY_GRID_SITE_ARG);
     }
 
     /**
      * @brief リサイズ
      * @param[in] size (width, height, depth)の整数ベクトル
     */
-    void resize(Eigen::Vector3i const & size){
-        resize(size.x(), size.y(), size.z());
+    void resize(Eigen::Vector3i const & size UTILITY_GRID_SITE){
+        resize(size.x(), size.y(), size.z() UTILITY_GRID_SITE_ARG);
     }
 
     /**
@@ -566,8 +1172,8 @@ public:
      * @param[in] pos (x, y, z)の整数ベクトル
      * @return 収まっていたらtrue
     */
-    bool in(Eigen::Vector3i const & pos) const {
-        return in(pos.z(), pos.y(), pos.x());
+    bool in(Eigen::Vector3i const & pos UTILITY_GRID_SITE) const {
+        return in(pos.z(), pos.y(), pos.x() UTILITY_GRID_SITE_ARG);
     }
 
 #endif // ifdef EIGEN_CORE_H
@@ -0,0 +1,272 @@
+/**
+ * @brief Grid2D, Grid3Dの格納領域用のアロケータ
+ * @note AlignedAllocatorは先頭をキャッシュライン、ページなどの境界に揃える
+ * @note ArenaAllocatorはMonotonicArenaからポインタを進めるだけで確保し、解放はアリーナ単位でまとめて行う
+*/
+
+#ifndef UTILITY_GRID_ALLOCATOR_H
+#define UTILITY_GRID_ALLOCATOR_H
+
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+namespace Utility{
+
+/**
+ * @brief 先頭をAlignmentバイト境界に揃えて確保するアロケータ
+ * @tparam Alignment 2のべき乗 alignof(T)以上であること
+*/
+template <typename T, size_t Alignment = 64>
+class AlignedAllocator{
+    static_assert((Alignment & (Alignment - 1)) == 0, "AlignedAllocator: Alignment must be a power of two");
+    static_assert(Alignment >= alignof(T), "AlignedAllocator: Alignment must not be smaller than alignof(T)");
+
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    static constexpr size_t alignment = Alignment;
+
+    template <typename U>
+    struct rebind{
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+
+    template <typename U>
+    AlignedAllocator(AlignedAllocator<U, Alignment> const &) noexcept {}
+
+    T * allocate(size_t const n){
+        if(n > size_t(-1) / sizeof(T)){
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T * const p, size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator ==(AlignedAllocator<T, Alignment> const &, AlignedAllocator<U, Alignment> const &) noexcept {
+    return true;
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator !=(AlignedAllocator<T, Alignment> const &, AlignedAllocator<U, Alignment> const &) noexcept {
+    return false;
+}
+
+/**
+ * @brief 64バイト(キャッシュライン)境界に揃えるアロケータ AVX-512の整列ロードに使える
+*/
+template <typename T>
+using CacheAlignedAllocator = AlignedAllocator<T, 64>;
+
+/**
+ * @brief 4096バイト(ページ)境界に揃えるアロケータ
+*/
+template <typename T>
+using PageAlignedAllocator = AlignedAllocator<T, 4096>;
+
+/**
+ * @brief ポインタを進めるだけで確保し、まとめて解放する領域
+ * @note 個々の解放は何もしない reset()で全体を巻き戻し、確保済みのブロックは次回に使い回す
+ * @note スレッドセーフではない フレームごとの一時的なグリッドなど、寿命の揃った確保に使う
+*/
+class MonotonicArena{
+public:
+    using size_type = size_t;
+
+    static constexpr size_type default_block_size = size_type(1) << 20;
+    static constexpr size_type block_alignment = 4096;
+
+private:
+    struct Block{
+        char * data;
+        size_type size;
+    };
+
+    std::vector<Block> m_blocks;   // 確保したブロック 先頭から順に使う
+    size_type m_current = 0;       // 使用中のブロックの添字
+    char * m_pos = nullptr;        // 次に確保する位置
+    char * m_end = nullptr;        // 使用中のブロックの終端
+    size_type m_block_size;        // 新しいブロックの最小の大きさ
+    size_type m_used = 0;          // 巻き戻してから消費したバイト数(整列の詰め物と使わなかったブロックの末尾を含む)
+
+public:
+    explicit MonotonicArena(size_type const block_size = default_block_size)
+        : m_block_size(std::max<size_type>(block_size, 1)){}
+
+    MonotonicArena(MonotonicArena const &) = delete;
+    MonotonicArena & operator =(MonotonicArena const &) = delete;
+
+    ~MonotonicArena(){
+        release();
+    }
+
+    /**
+     * @brief bytesバイトをalignment境界に揃えて確保する
+     * @param[in] alignment 2のべき乗
+    */
+    void * allocate(size_type const bytes, size_type const alignment = alignof(std::max_align_t)){
+        for(;;){
+            if(m_pos != nullptr){
+                uintptr_t const p = reinterpret_cast<uintptr_t>(m_pos);
+                size_type const padding = static_cast<size_type>(((p + alignment - 1) & ~uintptr_t(alignment - 1)) - p);
+                if(padding <= static_cast<size_type>(m_end - m_pos) && bytes <= static_cast<size_type>(m_end - m_pos) - padding){
+                    char * const result = m_pos + padding;
+                    m_pos = result + bytes;
+                    m_used += padding + bytes;
+                    return result;
+                }
+            }
+            next_block(bytes, alignment);
+        }
+    }
+
+    /**
+     * @brief 全ての確保を無効にして先頭へ巻き戻す
+     * @note 複数のブロックを使っていた場合は、合計の大きさの一つのブロックにまとめ直す
+    */
+    void reset(){
+        if(m_blocks.size() > 1){
+            size_type total = 0;
+            for(auto const & block : m_blocks) total += block.size;
+            release();
+            m_blocks.push_back(Block{allocate_block(total), total});
+        }
+        m_current = 0;
+        m_used = 0;
+        if(m_blocks.empty()){
+            m_pos = m_end = nullptr;
+        }else{
+            m_pos = m_blocks.front().data;
+            m_end = m_pos + m_blocks.front().size;
+        }
+    }
+
+    /**
+     * @brief 全てのブロックを解放する
+    */
+    void release(){
+        for(auto const & block : m_blocks){
+            ::operator delete(block.data, std::align_val_t(block_alignment));
+        }
+        m_blocks.clear();
+        m_current = 0;
+        m_used = 0;
+        m_pos = m_end = nullptr;
+    }
+
+    /**
+     * @brief 巻き戻してから消費したバイト数
+    */
+    size_type used() const {
+        return m_used;
+    }
+
+    /**
+     * @brief 確保しているブロックの合計のバイト数
+    */
+    size_type capacity() const {
+        size_type total = 0;
+        for(auto const & block : m_blocks) total += block.size;
+        return total;
+    }
+
+private:
+    static char * allocate_block(size_type const size){
+        return static_cast<char *>(::operator new(size, std::align_val_t(block_alignment)));
+    }
+
+    /**
+     * @brief 次のブロックへ移る 収まるブロックが残っていなければ新しく確保する
+    */
+    void next_block(size_type const bytes, size_type const alignment){
+        size_type const required = bytes + (alignment > block_alignment ? alignment : 0);
+        if(m_pos != nullptr){
+            m_used += static_cast<size_type>(m_end - m_pos);
+            ++m_current;
+        }
+        while(m_current < m_blocks.size() && m_blocks[m_current].size < required){
+            m_used += m_blocks[m_current].size;
+            ++m_current;
+        }
+        if(m_current == m_blocks.size()){
+            size_type const size = std::max(m_block_size, required);
+            m_blocks.push_back(Block{allocate_block(size), size});
+        }
+        m_pos = m_blocks[m_current].data;
+        m_end = m_pos + m_blocks[m_current].size;
+    }
+};
+
+/**
+ * @brief MonotonicArenaから確保するアロケータ deallocate()は何もしない
+ * @tparam Alignment 各確保の先頭を揃える境界 2のべき乗
+ * @note アリーナはアロケータとそれを使うコンテナより長く生存していること
+*/
+template <typename T, size_t Alignment = 64>
+class ArenaAllocator{
+    static_assert((Alignment & (Alignment - 1)) == 0, "ArenaAllocator: Alignment must be a power of two");
+    static_assert(Alignment >= alignof(T), "ArenaAllocator: Alignment must not be smaller than alignof(T)");
+
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    template <typename U>
+    struct rebind{
+        using other = ArenaAllocator<U, Alignment>;
+    };
+
+private:
+    MonotonicArena * m_arena;
+
+public:
+    ArenaAllocator(MonotonicArena & arena) noexcept
+        : m_arena(&arena){}
+
+    template <typename U>
+    ArenaAllocator(ArenaAllocator<U, Alignment> const & other) noexcept
+        : m_arena(&other.arena()){}
+
+    T * allocate(size_t const n){
+        if(n > size_t(-1) / sizeof(T)){
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(m_arena->allocate(n * sizeof(T), Alignment));
+    }
+
+    void deallocate(T *, size_t) noexcept {}
+
+    MonotonicArena & arena() const {
+        return *m_arena;
+    }
+};
+
+template <typename T, typename U, size_t Alignment>
+bool operator ==(ArenaAllocator<T, Alignment> const & a, ArenaAllocator<U, Alignment> const & b) noexcept {
+    return &a.arena() == &b.arena();
+}
+
+template <typename T, typename U, size_t Alignment>
+bool operator !=(ArenaAllocator<T, Alignment> const & a, ArenaAllocator<U, Alignment> const & b) noexcept {
+    return !(a == b);
+}
+
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_ALLOCATOR_H
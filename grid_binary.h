@@ -0,0 +1,604 @@
+/**
+ * @brief Grid2D, Grid3Dのバイナリ形式での保存と、メモリマップによるコピーなしの読み込み
+ * @note ファイルはヘッダ(GridFileHeader)と、data()の格納領域をそのまま並べたものからなる
+ * @note メモリマップはPOSIXのmmapを使う
+*/
+
+#ifndef UTILITY_GRID_BINARY_H
+#define UTILITY_GRID_BINARY_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "grid2d.h"
+#include "grid3d.h"
+
+namespace Utility{
+
+/**
+ * @brief バイナリ形式のヘッダ
+ * @note 全て処理系のバイト順で書き込む byte_orderで読み込み側と一致するかを確認する
+*/
+struct GridFileHeader{
+    static constexpr uint32_t current_version = 1;
+    static constexpr uint32_t byte_order_mark = 0x01020304;
+    static constexpr size_t data_alignment = 64; // 格納領域の開始位置の整列
+
+    char magic[8] = {'U', 'T', 'L', 'G', 'R', 'I', 'D', '\0'};
+    uint32_t version = current_version;
+    uint32_t byte_order = byte_order_mark;
+    uint32_t element_size = 0;       // 要素のバイト数
+    uint32_t dimension = 0;          // 2か3
+    uint32_t layout[3] = {0, 0, 0};  // レイアウトの種類と引数
+    uint32_t reserved = 0;
+    uint64_t width = 0;
+    uint64_t height = 0;
+    uint64_t depth = 0;
+    uint64_t storage_size = 0;       // 格納領域の要素数
+    uint64_t data_offset = 0;        // ファイル先頭から格納領域までのバイト数
+};
+
+namespace detail{
+
+/**
+ * @brief レイアウトをファイルに記録するための識別子 {種類, 引数, 引数}
+ * @note 識別子のないレイアウトは保存・読み込みできない
+*/
+template <typename layout_type>
+struct GridLayoutSignature{
+    static_assert(sizeof(layout_type) == 0, "grid binary: layout_type has no GridLayoutSignature and cannot be saved or loaded");
+};
+
+template <>
+struct GridLayoutSignature<RowMajorLayout>{
+    static constexpr std::array<uint32_t, 3> value{1, 0, 0};
+};
+
+template <size_t TileWidth, size_t TileHeight>
+struct GridLayoutSignature<TiledLayout<TileWidth, TileHeight>>{
+    static constexpr std::array<uint32_t, 3> value{2, TileWidth, TileHeight};
+};
+
+/**
+ * @note pitchは記録しない 保存する際に既定のpitch(widthをRowAlignmentに切り上げた値)へ詰める
+*/
+template <size_t RowAlignment>
+struct GridLayoutSignature<PitchedLayout<RowAlignment>>{
+    static constexpr std::array<uint32_t, 3> value{5, RowAlignment, 0};
+};
+
+template <>
+struct GridLayoutSignature<RowMajorLayout3D>{
+    static constexpr std::array<uint32_t, 3> value{3, 0, 0};
+};
+
+template <size_t BrickBits>
+struct GridLayoutSignature<MortonLayout3D<BrickBits>>{
+    static constexpr std::array<uint32_t, 3> value{4, BrickBits, 0};
+};
+
+template <typename data_type, typename layout_type>
+GridFileHeader make_grid_header(uint32_t const dimension, size_t const width, size_t const height, size_t const depth, size_t const storage_size){
+    static_assert(std::is_trivially_copyable<data_type>::value, "grid binary: data_type must be trivially copyable");
+    GridFileHeader header;
+    header.element_size = sizeof(data_type);
+    header.dimension = dimension;
+    for(int i=0; i<3; ++i) header.layout[i] = GridLayoutSignature<layout_type>::value[i];
+    header.width = width;
+    header.height = height;
+    header.depth = depth;
+    header.storage_size = storage_size;
+    header.data_offset = (sizeof(GridFileHeader) + GridFileHeader::data_alignment - 1) / GridFileHeader::data_alignment * GridFileHeader::data_alignment;
+    return header;
+}
+
+/**
+ * @brief ヘッダと格納領域を書き込む
+*/
+inline void write_grid_file(std::string const & path, GridFileHeader const & header, void const * data){
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(!file){
+        throw std::runtime_error("grid binary: cannot open " + path);
+    }
+    char padding[GridFileHeader::data_alignment] = {};
+    file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    file.write(padding, header.data_offset - sizeof(header));
+    file.write(static_cast<char const *>(data), header.storage_size * header.element_size);
+    if(!file){
+        throw std::runtime_error("grid binary: failed to write " + path);
+    }
+}
+
+/**
+ * @brief ヘッダの大きさで構築したレイアウトの格納領域の大きさ
+*/
+template <typename layout_type, uint32_t dimension>
+size_t header_storage_size(GridFileHeader const & header){
+    if constexpr(dimension == 2){
+        return layout_type(header.width, header.height).storage_size();
+    }
+    else{
+        return layout_type(header.width, header.height, header.depth).storage_size();
+    }
+}
+
+/**
+ * @brief ヘッダが読み込み先の型と一致するかを確認する
+ * @note 幅・高さ・奥行きは、積が溢れず、レイアウトの格納領域の大きさがstorage_sizeと一致することを確認する
+ *       グリッドの構築やマップの受け入れより前に呼ぶ
+*/
+template <typename data_type, typename layout_type, uint32_t dimension>
+void check_grid_header(GridFileHeader const & header, size_t const file_size){
+    static_assert(std::is_trivially_copyable<data_type>::value, "grid binary: data_type must be trivially copyable");
+    GridFileHeader const expected;
+    if(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0){
+        throw std::runtime_error("grid binary: not a grid file");
+    }
+    if(header.version != GridFileHeader::current_version){
+        throw std::runtime_error("grid binary: unsupported version");
+    }
+    if(header.byte_order != GridFileHeader::byte_order_mark){
+        throw std::runtime_error("grid binary: byte order mismatch");
+    }
+    if(header.element_size != sizeof(data_type) || header.dimension != dimension){
+        throw std::runtime_error("grid binary: element size or dimension mismatch");
+    }
+    for(int i=0; i<3; ++i){
+        if(header.layout[i] != GridLayoutSignature<layout_type>::value[i]){
+            throw std::runtime_error("grid binary: layout mismatch");
+        }
+    }
+    if(header.data_offset % alignof(data_type) != 0 || header.data_offset < sizeof(GridFileHeader)
+        || file_size < header.data_offset || (file_size - header.data_offset) / sizeof(data_type) < header.storage_size){
+        throw std::runtime_error("grid binary: truncated file");
+    }
+    // 各辺はptrdiff_tに収まること(レイアウトでの切り上げが溢れないように)
+    uint64_t const max_extent = static_cast<uint64_t>(std::numeric_limits<std::ptrdiff_t>::max());
+    uint64_t const depth = (dimension == 2) ? 1 : header.depth;
+    if(header.width > max_extent || header.height > max_extent || depth > max_extent){
+        throw std::runtime_error("grid binary: invalid grid size");
+    }
+    uint64_t const max_elements = std::numeric_limits<uint64_t>::max();
+    if((header.height != 0 && header.width > max_elements / header.height)
+        || (depth != 0 && header.width * header.height > max_elements / depth)){
+        throw std::runtime_error("grid binary: invalid grid size");
+    }
+    if(header.width * header.height * depth > header.storage_size || header_storage_size<layout_type, dimension>(header) != header.storage_size){
+        throw std::runtime_error("grid binary: storage size mismatch");
+    }
+}
+
+/**
+ * @brief 読み込み専用のメモリマップ 移動のみ可能
+*/
+class MappedFile{
+private:
+    void * m_address = nullptr;
+    size_t m_size = 0;
+
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(std::string const & path){
+        int const fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){
+            throw std::runtime_error("grid binary: cannot open " + path);
+        }
+        struct stat st;
+        if(::fstat(fd, &st) != 0){
+            ::close(fd);
+            throw std::runtime_error("grid binary: cannot stat " + path);
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        if(m_size > 0){
+            m_address = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if(m_address == MAP_FAILED || m_address == nullptr){
+            m_address = nullptr;
+            throw std::runtime_error("grid binary: cannot map " + path);
+        }
+    }
+
+    MappedFile(MappedFile && other) noexcept
+        : m_address(std::exchange(other.m_address, nullptr)),
+        m_size(std::exchange(other.m_size, 0)){}
+
+    MappedFile & operator =(MappedFile && other) noexcept {
+        if(this != &other){
+            unmap();
+            m_address = std::exchange(other.m_address, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile & operator =(MappedFile const &) = delete;
+
+    ~MappedFile(){
+        unmap();
+    }
+
+    char const * data() const {
+        return static_cast<char const *>(m_address);
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    GridFileHeader header() const {
+        if(m_size < sizeof(GridFileHeader)){
+            throw std::runtime_error("grid binary: truncated file");
+        }
+        GridFileHeader header;
+        std::memcpy(&header, m_address, sizeof(header));
+        return header;
+    }
+
+private:
+    void unmap(){
+        if(m_address != nullptr) ::munmap(m_address, m_size);
+        m_address = nullptr;
+        m_size = 0;
+    }
+};
+
+/**
+ * @brief ファイル全体を読み込まずに、ヘッダと格納領域を順に読む
+*/
+template <typename data_type, typename layout_type, uint32_t dimension>
+GridFileHeader read_grid_file(std::ifstream & file, std::string const & path){
+    if(!file){
+        throw std::runtime_error("grid binary: cannot open " + path);
+    }
+    file.seekg(0, std::ios::end);
+    size_t const file_size = static_cast<size_t>(file.tellg());
+    file.seekg(0, std::ios::beg);
+    GridFileHeader header;
+    if(file_size < sizeof(header) || !file.read(reinterpret_cast<char *>(&header), sizeof(header))){
+        throw std::runtime_error("grid binary: truncated file");
+    }
+    check_grid_header<data_type, layout_type, dimension>(header, file_size);
+    file.seekg(header.data_offset, std::ios::beg);
+    return header;
+}
+
+} // namespace detail
+
+/**
+ * @brief メモリマップしたファイルを読み込み専用の二次元配列として扱うクラス
+ * @note 要素はファイルの内容を直接参照し、コピーしない 破棄するとマップを解除する
+*/
+template <typename data_type, typename layout_type = RowMajorLayout>
+class MappedGrid2D{
+public:
+    using size_type = size_t;
+
+private:
+    detail::MappedFile m_file;
+    data_type const * m_data = nullptr;
+    size_type m_width = 0;
+    size_type m_height = 0;
+    layout_type m_layout;
+
+public:
+    MappedGrid2D() = default;
+
+    /**
+     * @brief ファイルをマップして構築 ヘッダが一致しなければstd::runtime_errorを投げる
+    */
+    explicit MappedGrid2D(std::string const & path)
+        : m_file(path){
+        GridFileHeader const header = m_file.header();
+        detail::check_grid_header<data_type, layout_type, 2>(header, m_file.size());
+        m_width = header.width;
+        m_height = header.height;
+        m_layout = layout_type(m_width, m_height);
+        m_data = reinterpret_cast<data_type const *>(m_file.data() + header.data_offset);
+    }
+
+    /**
+     * @brief 要素アクセス 範囲外ではstd::out_of_rangeを投げる
+    */
+    data_type const & at(int const y, int const x) const {
+        if(!in(y, x)){
+            throw std::out_of_range("MappedGrid2D: index out of range");
+        }
+        return m_data[m_layout.index(y, x)];
+    }
+
+    /**
+     * @brief (x,y)のペアにより要素アクセス
+     * @param[in] pos (x,y)のペア
+    */
+    data_type const & at(std::pair<int, int> const & pos) const {
+        return at(pos.second, pos.first);
+    }
+
+    /**
+     * @brief [y][x]で要素アクセス
+    */
+    auto operator [] (int const y) const {
+        if constexpr(layout_type::rows_contiguous){
+            return m_data + m_layout.index(y, 0);
+        }else{
+            return GridRowAccessor<data_type const, layout_type>(m_data, &m_layout, y);
+        }
+    }
+
+    bool in(int const y, int const x) const {
+        return y >= 0 && size_type(y) < m_height && x >= 0 && size_type(x) < m_width;
+    }
+
+    size_t width() const {
+        return m_width;
+    }
+
+    size_t height() const {
+        return m_height;
+    }
+
+    std::pair<size_t, size_t> size() const {
+        return std::make_pair(m_width, m_height);
+    }
+
+    /**
+     * @brief 格納領域の先頭 要素の並びはlayout()に従う
+    */
+    data_type const * data() const {
+        return m_data;
+    }
+
+    layout_type const & layout() const {
+        return m_layout;
+    }
+
+    /**
+     * @brief マップした領域全体のビュー 行優先のレイアウトのみ
+    */
+    GridView2D<data_type const> view() const {
+        static_assert(layout_type::is_row_major, "MappedGrid2D::view: layout must be row-major");
+        return GridView2D<data_type const>(m_data, m_width, m_height, m_width);
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(Function const & func) const {
+        m_layout.foreach(0, m_height, func);
+    }
+
+    /**
+     * @brief 所有するGrid2Dへコピーする
+    */
+    Grid2D<data_type, layout_type> to_grid() const {
+        Grid2D<data_type, layout_type> grid(m_width, m_height);
+        std::memcpy(grid.data(), m_data, m_layout.storage_size() * sizeof(data_type));
+        return grid;
+    }
+};
+
+/**
+ * @brief メモリマップしたファイルを読み込み専用の三次元配列として扱うクラス
+ * @note 要素はファイルの内容を直接参照し、コピーしない 破棄するとマップを解除する
+*/
+template <typename data_type, typename layout_type = RowMajorLayout3D>
+class MappedGrid3D{
+public:
+    using size_type = size_t;
+
+private:
+    detail::MappedFile m_file;
+    data_type const * m_data = nullptr;
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_depth = 0;
+    layout_type m_layout;
+
+public:
+    MappedGrid3D() = default;
+
+    /**
+     * @brief ファイルをマップして構築 ヘッダが一致しなければstd::runtime_errorを投げる
+    */
+    explicit MappedGrid3D(std::string const & path)
+        : m_file(path){
+        GridFileHeader const header = m_file.header();
+        detail::check_grid_header<data_type, layout_type, 3>(header, m_file.size());
+        m_width = header.width;
+        m_height = header.height;
+        m_depth = header.depth;
+        m_layout = layout_type(m_width, m_height, m_depth);
+        m_data = reinterpret_cast<data_type const *>(m_file.data() + header.data_offset);
+    }
+
+    /**
+     * @brief 要素アクセス 範囲外ではstd::out_of_rangeを投げる
+    */
+    data_type const & at(int const z, int const y, int const x) const {
+        if(!in(z, y, x)){
+            throw std::out_of_range("MappedGrid3D: index out of range");
+        }
+        return m_data[m_layout.index(z, y, x)];
+    }
+
+    /**
+     * @brief (x,y,z)のタプルにより要素アクセス
+     * @param[in] pos (x,y,z)のタプル
+    */
+    data_type const & at(std::tuple<int, int, int> const pos) const {
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief [z][y][x]で要素アクセス
+    */
+    Grid3DAccessController<data_type const, layout_type> operator [] (int const z) const {
+        return Grid3DAccessController<data_type const, layout_type>(m_data, &m_layout, z);
+    }
+
+    bool in(int const z, int const y, int const x) const {
+        return z >= 0 && size_type(z) < m_depth && y >= 0 && size_type(y) < m_height && x >= 0 && size_type(x) < m_width;
+    }
+
+    size_t width() const {
+        return m_width;
+    }
+
+    size_t height() const {
+        return m_height;
+    }
+
+    size_t depth() const {
+        return m_depth;
+    }
+
+    std::tuple<size_t, size_t, size_t> size() const {
+        return std::make_tuple(m_width, m_height, m_depth);
+    }
+
+    /**
+     * @brief 格納領域の先頭 要素の並びはlayout()に従う
+    */
+    data_type const * data() const {
+        return m_data;
+    }
+
+    layout_type const & layout() const {
+        return m_layout;
+    }
+
+    /**
+     * @brief マップした領域全体のビュー 行優先のレイアウトのみ
+    */
+    GridView3D<data_type const> view() const {
+        static_assert(layout_type::is_row_major, "MappedGrid3D::view: layout must be row-major");
+        return GridView3D<data_type const>(m_data, m_width, m_height, m_depth, m_width * m_height, m_width);
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func z,y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(Function const & func) const {
+        m_layout.foreach(0, m_layout.band_count(), func);
+    }
+
+    /**
+     * @brief 所有するGrid3Dへコピーする
+    */
+    Grid3D<data_type, layout_type> to_grid() const {
+        Grid3D<data_type, layout_type> grid(m_width, m_height, m_depth);
+        std::memcpy(grid.data(), m_data, m_layout.storage_size() * sizeof(data_type));
+        return grid;
+    }
+};
+
+/**
+ * @brief Grid2Dをバイナリ形式で保存する 失敗した場合はstd::runtime_errorを投げる
+ * @note PitchedLayoutで列の挿入・削除によりpitchが広がっている場合は、既定のpitchに詰めて保存する
+*/
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+void save_grid(std::string const & path, Grid2D<data_type, layout_type, allocator_type, bounds_policy> const & grid){
+    UTILITY_GRID_TRACE_SPAN("save_grid", grid.width(), grid.height());
+    if constexpr(detail::is_pitched_layout<layout_type>::value){
+        layout_type const compact_layout(grid.width(), grid.height());
+        if(grid.layout().pitch() != compact_layout.pitch()){
+            Grid2D<data_type, layout_type> compact(grid.width(), grid.height());
+            for(size_t i=0; i<grid.height(); ++i){
+                std::copy_n(grid.data() + grid.layout().index(i, 0), grid.width(), compact.data() + compact_layout.index(i, 0));
+            }
+            save_grid(path, compact);
+            return;
+        }
+    }
+    detail::write_grid_file(path,
+        detail::make_grid_header<data_type, layout_type>(2, grid.width(), grid.height(), 1, grid.layout().storage_size()),
+        grid.data());
+}
+
+/**
+ * @brief Grid3Dをバイナリ形式で保存する 失敗した場合はstd::runtime_errorを投げる
+*/
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+void save_grid(std::string const & path, Grid3D<data_type, layout_type, allocator_type, bounds_policy> const & grid){
+    UTILITY_GRID_TRACE_SPAN("save_grid", grid.width(), grid.height(), grid.depth());
+    detail::write_grid_file(path,
+        detail::make_grid_header<data_type, layout_type>(3, grid.width(), grid.height(), grid.depth(), grid.layout().storage_size()),
+        grid.data());
+}
+
+/**
+ * @brief GridView2Dの範囲を行優先の配列としてバイナリ形式で保存する
+*/
+template <typename data_type>
+void save_grid(std::string const & path, GridView2D<data_type> const & view){
+    Grid2D<std::remove_const_t<data_type>> grid(view.width(), view.height());
+    grid.view().assign(view);
+    save_grid(path, grid);
+}
+
+/**
+ * @brief GridView3Dの範囲を行優先の配列としてバイナリ形式で保存する
+*/
+template <typename data_type>
+void save_grid(std::string const & path, GridView3D<data_type> const & view){
+    Grid3D<std::remove_const_t<data_type>> grid(view.width(), view.height(), view.depth());
+    grid.view().assign(view);
+    save_grid(path, grid);
+}
+
+/**
+ * @brief バイナリ形式のファイルをGrid2Dへ読み込む
+ * @note コピーせずに参照するだけならMappedGrid2Dを使う
+*/
+template <typename data_type, typename layout_type = RowMajorLayout>
+Grid2D<data_type, layout_type> load_grid2d(std::string const & path){
+    std::ifstream file(path, std::ios::binary);
+    GridFileHeader const header = detail::read_grid_file<data_type, layout_type, 2>(file, path);
+    UTILITY_GRID_TRACE_SPAN("load_grid2d", header.width, header.height);
+    Grid2D<data_type, layout_type> grid(header.width, header.height);
+    if(!file.read(reinterpret_cast<char *>(grid.data()), header.storage_size * sizeof(data_type))){
+        throw std::runtime_error("grid binary: failed to read " + path);
+    }
+    return grid;
+}
+
+/**
+ * @brief バイナリ形式のファイルをGrid3Dへ読み込む
+ * @note コピーせずに参照するだけならMappedGrid3Dを使う
+*/
+template <typename data_type, typename layout_type = RowMajorLayout3D>
+Grid3D<data_type, layout_type> load_grid3d(std::string const & path){
+    std::ifstream file(path, std::ios::binary);
+    GridFileHeader const header = detail::read_grid_file<data_type, layout_type, 3>(file, path);
+    UTILITY_GRID_TRACE_SPAN("load_grid3d", header.width, header.height, header.depth);
+    Grid3D<data_type, layout_type> grid(header.width, header.height, header.depth);
+    if(!file.read(reinterpret_cast<char *>(grid.data()), header.storage_size * sizeof(data_type))){
+        throw std::runtime_error("grid binary: failed to read " + path);
+    }
+    return grid;
+}
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_BINARY_H
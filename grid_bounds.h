@@ -0,0 +1,57 @@
+/**
+ * @brief Grid2D, Grid3Dの要素アクセスでの範囲検査の方針
+ * @note at(), operator[]の全ての多重定義がグリッドのbounds_policyに従う
+ * @note 既定の方針はUTILITY_GRID_BOUNDS_POLICYで差し替えられる 例えばリリースビルドで-DUTILITY_GRID_BOUNDS_POLICY=BoundsAssertとすると、NDEBUGの下で検査がなくなる
+ * @note check()はconstexprで、StaticGrid2D, StaticGrid3Dの定数式の中でも使える(範囲外は定数式にならない)
+*/
+
+#ifndef UTILITY_GRID_BOUNDS_H
+#define UTILITY_GRID_BOUNDS_H
+
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+
+namespace Utility{
+
+/**
+ * @brief 範囲外ならstd::out_of_rangeを投げる
+*/
+struct BoundsChecked{
+    static constexpr void check(int const i, size_t const extent){
+        if(i < 0 || static_cast<size_t>(i) >= extent){
+            throw std::out_of_range("grid: index out of range");
+        }
+    }
+};
+
+/**
+ * @brief assertで検査する NDEBUGが定義されていれば何もしない
+*/
+struct BoundsAssert{
+    static constexpr void check([[maybe_unused]] int const i, [[maybe_unused]] size_t const extent){
+        assert(i >= 0 && static_cast<size_t>(i) < extent && "grid: index out of range");
+    }
+};
+
+/**
+ * @brief 検査しない 要素の位置は格納位置の計算だけで求まる
+*/
+struct BoundsUnchecked{
+    static constexpr void check(int, size_t){}
+};
+
+#ifndef UTILITY_GRID_BOUNDS_POLICY
+#define UTILITY_GRID_BOUNDS_POLICY BoundsChecked
+#endif
+
+/**
+ * @brief Grid2D, Grid3Dのbounds_policyの既定値
+*/
+using DefaultBoundsPolicy = UTILITY_GRID_BOUNDS_POLICY;
+
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_BOUNDS_H
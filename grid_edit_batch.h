@@ -0,0 +1,242 @@
+/**
+ * @brief Grid2D, Grid3Dの行・列・奥の挿入と削除をまとめて適用するためのクラス
+*/
+
+#ifndef UTILITY_GRID_EDIT_BATCH_H
+#define UTILITY_GRID_EDIT_BATCH_H
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Utility{
+
+/**
+ * @brief 挿入・削除の対象となる軸
+*/
+enum class GridAxis{
+    Column, // x
+    Row,    // y
+    Depth   // z
+};
+
+/**
+ * @brief 行・列・奥の挿入と削除を記録しておき、apply_edits()で一度に適用するためのバッチ
+ * @note 削除位置は適用前のインデックス、挿入位置は適用後のインデックスで指定する
+ * @note 挿入された行と列が交わる要素は、後から記録した挿入の値で初期化される
+*/
+template <typename data_type>
+class GridEditBatch{
+public:
+    using size_type = size_t;
+
+    /**
+     * @brief 一つの挿入操作
+    */
+    struct Insertion{
+        size_type pos;     // 適用後のインデックス
+        data_type init;    // 初期化する値
+        size_type order;   // 記録した順番
+    };
+
+private:
+    std::vector<Insertion> m_insertions[3];
+    std::vector<size_type> m_removals[3];
+    size_type m_count = 0;
+
+public:
+
+    /**
+     * @brief 列の挿入を記録
+     * @param[in] pos 適用後にpos(0-indexed)列目となる位置
+     * @param[in] init 初期化する値
+    */
+    void insert_column(size_type const pos, data_type const & init){
+        insert(GridAxis::Column, pos, init);
+    }
+
+    /**
+     * @brief 行の挿入を記録
+     * @param[in] pos 適用後にpos(0-indexed)行目となる位置
+     * @param[in] init 初期化する値
+    */
+    void insert_row(size_type const pos, data_type const & init){
+        insert(GridAxis::Row, pos, init);
+    }
+
+    /**
+     * @brief 奥の挿入を記録
+     * @param[in] pos 適用後にpos(0-indexed)奥目となる位置
+     * @param[in] init 初期化する値
+    */
+    void insert_depth(size_type const pos, data_type const & init){
+        insert(GridAxis::Depth, pos, init);
+    }
+
+    /**
+     * @brief 列の削除を記録
+     * @param[in] pos 適用前のpos(0-indexed)列目
+    */
+    void remove_column(size_type const pos){
+        remove(GridAxis::Column, pos);
+    }
+
+    /**
+     * @brief 行の削除を記録
+     * @param[in] pos 適用前のpos(0-indexed)行目
+    */
+    void remove_row(size_type const pos){
+        remove(GridAxis::Row, pos);
+    }
+
+    /**
+     * @brief 奥の削除を記録
+     * @param[in] pos 適用前のpos(0-indexed)奥目
+    */
+    void remove_depth(size_type const pos){
+        remove(GridAxis::Depth, pos);
+    }
+
+    /**
+     * @brief 任意の軸への挿入を記録
+    */
+    void insert(GridAxis const axis, size_type const pos, data_type const & init){
+        m_insertions[static_cast<int>(axis)].push_back(Insertion{pos, init, m_count++});
+    }
+
+    /**
+     * @brief 任意の軸の削除を記録
+    */
+    void remove(GridAxis const axis, size_type const pos){
+        m_removals[static_cast<int>(axis)].push_back(pos);
+        ++m_count;
+    }
+
+    /**
+     * @brief 記録した操作の数
+    */
+    size_type size() const {
+        return m_count;
+    }
+
+    /**
+     * @brief 何も記録されていなければtrue
+    */
+    bool empty() const {
+        return m_count == 0;
+    }
+
+    /**
+     * @brief 記録のクリア
+    */
+    void clear(){
+        for(int i=0; i<3; ++i){
+            m_insertions[i].clear();
+            m_removals[i].clear();
+        }
+        m_count = 0;
+    }
+
+    /**
+     * @brief 軸ごとの挿入操作
+    */
+    std::vector<Insertion> const & insertions(GridAxis const axis) const {
+        return m_insertions[static_cast<int>(axis)];
+    }
+
+    /**
+     * @brief 軸ごとの削除位置
+    */
+    std::vector<size_type> const & removals(GridAxis const axis) const {
+        return m_removals[static_cast<int>(axis)];
+    }
+};
+
+namespace detail{
+
+/**
+ * @brief GridEditBatchの一軸分を、適用後のインデックス -> 適用前のインデックスの対応表にしたもの
+*/
+template <typename data_type>
+class GridEditAxisMap{
+public:
+    using size_type = size_t;
+    using insertion_type = typename GridEditBatch<data_type>::Insertion;
+
+private:
+    std::vector<size_type> m_source;                    // 適用前のインデックス
+    std::vector<insertion_type const *> m_insertion;    // 挿入された位置ならその操作、それ以外はnullptr
+
+public:
+    GridEditAxisMap(size_type const old_size, GridEditBatch<data_type> const & batch, GridAxis const axis){
+        auto const & insertions = batch.insertions(axis);
+        std::vector<size_type> removals = batch.removals(axis);
+        std::sort(removals.begin(), removals.end());
+        if(std::adjacent_find(removals.begin(), removals.end()) != removals.end()){
+            throw std::out_of_range("GridEditBatch: the same index is removed twice");
+        }
+        if(!removals.empty() && removals.back() >= old_size){
+            throw std::out_of_range("GridEditBatch: removal index is out of range");
+        }
+
+        size_type const new_size = old_size - removals.size() + insertions.size();
+        m_source.assign(new_size, 0);
+        m_insertion.assign(new_size, nullptr);
+        for(auto const & ins : insertions){
+            if(ins.pos >= new_size || m_insertion[ins.pos] != nullptr){
+                throw std::out_of_range("GridEditBatch: insertion index is out of range or duplicated");
+            }
+            m_insertion[ins.pos] = &ins;
+        }
+
+        // 挿入されていない位置へ、削除されなかった元のインデックスを順番に割り当てる
+        size_type src = 0;
+        auto removed = removals.begin();
+        for(size_type i=0; i<new_size; ++i){
+            if(m_insertion[i] != nullptr) continue;
+            while(removed != removals.end() && *removed == src){
+                ++removed;
+                ++src;
+            }
+            m_source[i] = src++;
+        }
+    }
+
+    /**
+     * @brief 適用後のサイズ
+    */
+    size_type size() const {
+        return m_source.size();
+    }
+
+    /**
+     * @brief 適用後のi番目に対応する適用前のインデックス
+    */
+    size_type source(size_type const i) const {
+        return m_source[i];
+    }
+
+    /**
+     * @brief 適用後のi番目が挿入されたものならその操作、それ以外はnullptr
+    */
+    insertion_type const * insertion(size_type const i) const {
+        return m_insertion[i];
+    }
+};
+
+/**
+ * @brief 複数の軸で挿入された要素について、後から記録した方の挿入を返す
+*/
+template <typename insertion_type>
+insertion_type const * latest_insertion(insertion_type const * a, insertion_type const * b){
+    if(a == nullptr) return b;
+    if(b == nullptr) return a;
+    return (a->order > b->order) ? a : b;
+}
+
+} // namespace detail
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_EDIT_BATCH_H
@@ -0,0 +1,411 @@
+/**
+ * @brief Grid2D, Grid3Dの要素ごとの四則演算を遅延評価する式テンプレート
+ * @note a = b * 0.5f + c - d は一時的なグリッドを作らず、data()上を一度だけ走査して評価される
+ * @note レイアウトの異なるグリッドやビューを含む式は、座標ごとに評価する
+*/
+
+#ifndef UTILITY_GRID_EXPRESSION_H
+#define UTILITY_GRID_EXPRESSION_H
+
+#include <cstddef>
+#include <type_traits>
+#include <stdexcept>
+#include <utility>
+#include "grid_layout.h"
+
+namespace Utility{
+
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+class Grid2D;
+
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+class Grid3D;
+
+template <typename data_type>
+class GridView2D;
+
+template <typename data_type>
+class GridView3D;
+
+/**
+ * @brief グリッドの大きさ Grid2Dではdepthを1とする
+*/
+struct GridShape{
+    size_t width = 0;
+    size_t height = 0;
+    size_t depth = 0;
+
+    bool operator ==(GridShape const & right) const {
+        return width == right.width && height == right.height && depth == right.depth;
+    }
+
+    bool operator !=(GridShape const & right) const {
+        return !(*this == right);
+    }
+};
+
+/**
+ * @brief 式の基底クラス(CRTP)
+*/
+template <typename Derived>
+class GridExpression{
+public:
+    Derived const & derived() const {
+        return static_cast<Derived const &>(*this);
+    }
+};
+
+namespace detail{
+
+/**
+ * @brief レイアウトを持たない項(スカラー)を表すタグ
+*/
+struct NoLayout{};
+
+/**
+ * @brief レイアウトの異なる項を含むことを表すタグ 格納領域を一度に走査できないため、座標ごとに評価する
+*/
+struct MixedLayout{};
+
+/**
+ * @brief 二つの項のレイアウトをまとめる 異なる場合はMixedLayout
+*/
+template <typename A, typename B>
+struct common_layout{
+    using type = MixedLayout;
+};
+template <typename A>
+struct common_layout<A, A>{
+    using type = A;
+};
+template <typename A>
+struct common_layout<A, NoLayout>{
+    using type = A;
+};
+template <typename B>
+struct common_layout<NoLayout, B>{
+    using type = B;
+};
+template <>
+struct common_layout<NoLayout, NoLayout>{
+    using type = NoLayout;
+};
+
+/**
+ * @brief 二次元(z = 0)と三次元のレイアウトの格納位置を同じ形で求める
+*/
+template <typename layout_type>
+auto layout_index(layout_type const & layout, size_t const z, size_t const y, size_t const x) -> decltype(layout.index(z, y, x)){
+    return layout.index(z, y, x);
+}
+template <typename layout_type>
+auto layout_index(layout_type const & layout, size_t, size_t const y, size_t const x) -> decltype(layout.index(y, x)){
+    return layout.index(y, x);
+}
+
+template <typename T>
+struct is_grid_container : std::false_type{};
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+struct is_grid_container<Grid2D<data_type, layout_type, allocator_type, bounds_policy>> : std::true_type{};
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+struct is_grid_container<Grid3D<data_type, layout_type, allocator_type, bounds_policy>> : std::true_type{};
+template <typename data_type>
+struct is_grid_container<GridView2D<data_type>> : std::true_type{};
+template <typename data_type>
+struct is_grid_container<GridView3D<data_type>> : std::true_type{};
+
+/**
+ * @brief Grid2DかGridView2D
+*/
+template <typename T>
+struct is_grid2d : std::false_type{};
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+struct is_grid2d<Grid2D<data_type, layout_type, allocator_type, bounds_policy>> : std::true_type{};
+template <typename data_type>
+struct is_grid2d<GridView2D<data_type>> : std::true_type{};
+
+/**
+ * @brief Grid3DかGridView3D
+*/
+template <typename T>
+struct is_grid3d : std::false_type{};
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+struct is_grid3d<Grid3D<data_type, layout_type, allocator_type, bounds_policy>> : std::true_type{};
+template <typename data_type>
+struct is_grid3d<GridView3D<data_type>> : std::true_type{};
+
+template <typename T>
+struct is_grid_expression : std::is_base_of<GridExpression<T>, T>{};
+
+/**
+ * @brief 演算子の被演算子になれるか(グリッドか式)
+*/
+template <typename T>
+struct is_grid_operand : std::integral_constant<bool, is_grid_container<T>::value || is_grid_expression<T>::value>{};
+
+/**
+ * @brief 二項演算子を式テンプレートとして定義してよい組み合わせか
+*/
+template <typename L, typename R>
+struct is_grid_operator_pair : std::integral_constant<bool,
+    (is_grid_operand<L>::value && (is_grid_operand<R>::value || std::is_arithmetic<R>::value))
+    || (std::is_arithmetic<L>::value && is_grid_operand<R>::value)>{};
+
+struct Plus{
+    template <typename A, typename B>
+    static auto apply(A const & a, B const & b){ return a + b; }
+};
+struct Minus{
+    template <typename A, typename B>
+    static auto apply(A const & a, B const & b){ return a - b; }
+};
+struct Multiplies{
+    template <typename A, typename B>
+    static auto apply(A const & a, B const & b){ return a * b; }
+};
+struct Divides{
+    template <typename A, typename B>
+    static auto apply(A const & a, B const & b){ return a / b; }
+};
+
+} // namespace detail
+
+/**
+ * @brief グリッドを参照する項
+*/
+template <typename data_type, typename layout_type>
+class GridTerminal : public GridExpression<GridTerminal<data_type, layout_type>>{
+public:
+    using layout = layout_type;
+
+private:
+    data_type const * m_data;
+    GridShape m_shape;
+    size_t m_storage_size;
+    layout_type m_layout;
+
+public:
+    GridTerminal(data_type const * data, GridShape const & shape, size_t const storage_size, layout_type const & layout)
+        : m_data(data),
+        m_shape(shape),
+        m_storage_size(storage_size),
+        m_layout(layout){}
+
+    data_type const & eval(size_t const i) const {
+        return m_data[i];
+    }
+
+    data_type const & eval_at(size_t const z, size_t const y, size_t const x) const {
+        return m_data[detail::layout_index(m_layout, z, y, x)];
+    }
+
+    /**
+     * @brief 大きさを確認する 最初に見つかった項の大きさをshapeに入れ、以降はそれと比較する
+    */
+    void check_shape(GridShape & shape, size_t & storage_size, bool & found) const {
+        if(!found){
+            shape = m_shape;
+            storage_size = m_storage_size;
+            found = true;
+        }else if(shape != m_shape){
+            throw std::invalid_argument("grid expression: shape mismatch");
+        }
+    }
+};
+
+/**
+ * @brief スカラーの項
+*/
+template <typename value_type>
+class GridScalar : public GridExpression<GridScalar<value_type>>{
+public:
+    using layout = detail::NoLayout;
+
+private:
+    value_type m_value;
+
+public:
+    GridScalar(value_type const value)
+        : m_value(value){}
+
+    value_type eval(size_t) const {
+        return m_value;
+    }
+
+    value_type eval_at(size_t, size_t, size_t) const {
+        return m_value;
+    }
+
+    void check_shape(GridShape &, size_t &, bool &) const {}
+};
+
+/**
+ * @brief 二項演算の式
+*/
+template <typename Op, typename L, typename R>
+class GridBinaryExpression : public GridExpression<GridBinaryExpression<Op, L, R>>{
+public:
+    using layout = typename detail::common_layout<typename L::layout, typename R::layout>::type;
+
+private:
+    L m_left;
+    R m_right;
+
+public:
+    GridBinaryExpression(L const & left, R const & right)
+        : m_left(left),
+        m_right(right){}
+
+    auto eval(size_t const i) const {
+        return Op::apply(m_left.eval(i), m_right.eval(i));
+    }
+
+    auto eval_at(size_t const z, size_t const y, size_t const x) const {
+        return Op::apply(m_left.eval_at(z, y, x), m_right.eval_at(z, y, x));
+    }
+
+    void check_shape(GridShape & shape, size_t & storage_size, bool & found) const {
+        m_left.check_shape(shape, storage_size, found);
+        m_right.check_shape(shape, storage_size, found);
+    }
+};
+
+/**
+ * @brief 符号反転の式
+*/
+template <typename E>
+class GridNegateExpression : public GridExpression<GridNegateExpression<E>>{
+public:
+    using layout = typename E::layout;
+
+private:
+    E m_expr;
+
+public:
+    GridNegateExpression(E const & expr)
+        : m_expr(expr){}
+
+    auto eval(size_t const i) const {
+        return -m_expr.eval(i);
+    }
+
+    auto eval_at(size_t const z, size_t const y, size_t const x) const {
+        return -m_expr.eval_at(z, y, x);
+    }
+
+    void check_shape(GridShape & shape, size_t & storage_size, bool & found) const {
+        m_expr.check_shape(shape, storage_size, found);
+    }
+};
+
+namespace detail{
+
+/**
+ * @brief グリッド、式、スカラーをそれぞれ式の項にする
+*/
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+GridTerminal<data_type, layout_type> as_expression(Grid2D<data_type, layout_type, allocator_type, bounds_policy> const & grid){
+    return GridTerminal<data_type, layout_type>(grid.data(), GridShape{grid.width(), grid.height(), 1}, grid.layout().storage_size(), grid.layout());
+}
+
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+GridTerminal<data_type, layout_type> as_expression(Grid3D<data_type, layout_type, allocator_type, bounds_policy> const & grid){
+    return GridTerminal<data_type, layout_type>(grid.data(), GridShape{grid.width(), grid.height(), grid.depth()}, grid.layout().storage_size(), grid.layout());
+}
+
+template <typename data_type>
+GridTerminal<std::remove_const_t<data_type>, StridedLayout2D> as_expression(GridView2D<data_type> const & view){
+    return GridTerminal<std::remove_const_t<data_type>, StridedLayout2D>(view.data(), GridShape{view.width(), view.height(), 1}, 0, view.layout());
+}
+
+template <typename data_type>
+GridTerminal<std::remove_const_t<data_type>, StridedLayout3D> as_expression(GridView3D<data_type> const & view){
+    return GridTerminal<std::remove_const_t<data_type>, StridedLayout3D>(view.data(), GridShape{view.width(), view.height(), view.depth()}, 0, view.layout());
+}
+
+template <typename Derived>
+Derived const & as_expression(GridExpression<Derived> const & expr){
+    return expr.derived();
+}
+
+template <typename T, std::enable_if_t<std::is_arithmetic<T>::value, std::nullptr_t> = nullptr>
+GridScalar<T> as_expression(T const value){
+    return GridScalar<T>(value);
+}
+
+template <typename T>
+using expression_type = std::decay_t<decltype(as_expression(std::declval<T const &>()))>;
+
+template <typename Op, typename L, typename R>
+GridBinaryExpression<Op, expression_type<L>, expression_type<R>> make_binary(L const & left, R const & right){
+    return GridBinaryExpression<Op, expression_type<L>, expression_type<R>>(as_expression(left), as_expression(right));
+}
+
+/**
+ * @brief 式全体の大きさを一度だけ確認し、格納領域の大きさを返す
+*/
+template <typename Expr>
+size_t check_expression_shape(Expr const & expr, GridShape & shape){
+    size_t storage_size = 0;
+    bool found = false;
+    expr.check_shape(shape, storage_size, found);
+    return storage_size;
+}
+
+/**
+ * @brief 格納領域の各要素について式を評価して書き込む
+ * @note 要素ごとの範囲チェックは行わない
+*/
+template <typename data_type, typename Expr>
+void evaluate_expression(data_type * out, Expr const & expr, size_t const n){
+    for(size_t i=0; i<n; ++i){
+        out[i] = static_cast<data_type>(expr.eval(i));
+    }
+}
+
+/**
+ * @brief 各座標について式を評価して、outのlayoutの位置へ書き込む
+ * @note レイアウトの異なる項やビューを含む式で使う
+*/
+template <typename data_type, typename layout_type, typename Expr>
+void evaluate_expression_at(data_type * out, layout_type const & layout, Expr const & expr, GridShape const & shape){
+    for(size_t k=0; k<shape.depth; ++k){
+        for(size_t i=0; i<shape.height; ++i){
+            for(size_t j=0; j<shape.width; ++j){
+                out[layout_index(layout, k, i, j)] = static_cast<data_type>(expr.eval_at(k, i, j));
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+template <typename L, typename R, std::enable_if_t<detail::is_grid_operator_pair<L, R>::value, std::nullptr_t> = nullptr>
+auto operator +(L const & left, R const & right){
+    return detail::make_binary<detail::Plus>(left, right);
+}
+
+template <typename L, typename R, std::enable_if_t<detail::is_grid_operator_pair<L, R>::value, std::nullptr_t> = nullptr>
+auto operator -(L const & left, R const & right){
+    return detail::make_binary<detail::Minus>(left, right);
+}
+
+template <typename L, typename R, std::enable_if_t<detail::is_grid_operator_pair<L, R>::value, std::nullptr_t> = nullptr>
+auto operator *(L const & left, R const & right){
+    return detail::make_binary<detail::Multiplies>(left, right);
+}
+
+template <typename L, typename R, std::enable_if_t<detail::is_grid_operator_pair<L, R>::value, std::nullptr_t> = nullptr>
+auto operator /(L const & left, R const & right){
+    return detail::make_binary<detail::Divides>(left, right);
+}
+
+template <typename E, std::enable_if_t<detail::is_grid_operand<E>::value, std::nullptr_t> = nullptr>
+auto operator -(E const & expr){
+    return GridNegateExpression<detail::expression_type<E>>(detail::as_expression(expr));
+}
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_EXPRESSION_H
@@ -0,0 +1,639 @@
+/**
+ * @brief Grid2D, Grid3Dのアクセスと構造の変更の計数
+ * @note UTILITY_GRID_INSTRUMENTを定義した場合のみ有効 未定義ではグリッドに計数用のメンバも引数も加わらず、記録も全て消える
+ * @note 定義の有無は全ての翻訳単位で揃えること(グリッドの大きさと関数の引数が変わる)
+ * @note グリッドごとの計数はcounters()で、呼び出し元(ファイルと行)ごとの計数はGridInstrumentationで参照する
+ * @note 呼び出し元の取得には__builtin_FILE(), __builtin_LINE()を使う(GCC, Clang)
+ * @note 生存中のグリッドの格納領域はGridMemoryRegistryで、最後に領域を確保し直した呼び出し元ごとに集計できる
+*/
+
+#ifndef UTILITY_GRID_INSTRUMENT_H
+#define UTILITY_GRID_INSTRUMENT_H
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <tuple>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+namespace Utility{
+
+/**
+ * @brief 計数する操作
+ * @note InMissはin()が範囲外を返した回数 push_back_*, pop_back_*はそれぞれ挿入、削除として数える
+*/
+enum class GridOp : int{
+    At,
+    Subscript,
+    InMiss,
+    InsertColumn,
+    InsertRow,
+    InsertDepth,
+    RemoveColumn,
+    RemoveRow,
+    RemoveDepth,
+    Resize,
+    ApplyEdits,
+    Reserve,
+    ShrinkToFit,
+    Count
+};
+
+/**
+ * @brief 操作の名前
+*/
+inline char const * grid_op_name(GridOp const op){
+    static char const * const names[] = {
+        "at", "operator[]", "in() miss", "insert_column", "insert_row", "insert_depth",
+        "remove_column", "remove_row", "remove_depth", "resize", "apply_edits", "reserve", "shrink_to_fit"};
+    return names[static_cast<int>(op)];
+}
+
+/**
+ * @brief 呼び出し元の位置
+*/
+struct GridCallSite{
+    char const * file;
+    int line;
+
+    /**
+     * @brief 既定引数で使うと、呼び出した側の位置になる
+    */
+    static GridCallSite current(char const * const file = __builtin_FILE(), int const line = __builtin_LINE()){
+        return GridCallSite{file, line};
+    }
+};
+
+/**
+ * @brief 一つの操作の計数
+ * @note reallocationsは格納領域が確保し直された回数、bytes_movedはその際に保持された要素のバイト数(移動量の目安)
+*/
+struct GridOpStats{
+    uint64_t calls = 0;
+    uint64_t reallocations = 0;
+    uint64_t bytes_moved = 0;
+};
+
+/**
+ * @brief 一つのグリッドの格納領域
+ * @note size_bytes, capacity_bytesは常に求まる peak_bytes以降はUTILITY_GRID_INSTRUMENTを定義した場合のみ記録され、未定義では0(peak_bytesは現在の容量)
+*/
+struct GridMemoryStats{
+    uint64_t size_bytes = 0;        // 要素が占めるバイト数 TiledLayoutなどの余りを含み、PitchedLayoutの余りの列は含まない
+    uint64_t capacity_bytes = 0;    // 確保済みのバイト数
+    uint64_t peak_bytes = 0;        // 確保済みのバイト数の最大
+    uint64_t reallocations = 0;     // 構造の変更で格納領域を確保し直した回数
+    uint64_t bytes_moved = 0;       // その際に保持された要素のバイト数
+
+    /**
+     * @brief 確保済みで使っていないバイト数
+    */
+    uint64_t slack_bytes() const {
+        return capacity_bytes - size_bytes;
+    }
+};
+
+namespace detail{
+
+inline void write_stats_header(std::ostream & os){
+    os << std::left << std::setw(16) << "op" << std::right
+        << std::setw(14) << "calls" << std::setw(14) << "reallocations" << std::setw(16) << "bytes_moved" << '\n';
+}
+
+inline void write_stats_row(std::ostream & os, GridOp const op, GridOpStats const & stats){
+    os << std::left << std::setw(16) << grid_op_name(op) << std::right
+        << std::setw(14) << stats.calls << std::setw(14) << stats.reallocations << std::setw(16) << stats.bytes_moved << '\n';
+}
+
+} // namespace detail
+
+/**
+ * @brief 呼び出し元ごとの計数の登録先 プロセス全体で一つ
+ * @note 記録はスレッドごとの表に行い、report(), stats()で合算する 表のロックは記録するスレッドと合算の間でしか競合しない
+ * @note 呼び出し元のファイル名は__builtin_FILE()の静的な文字列であり、記録ではポインタのまま比べる
+*/
+class GridInstrumentation{
+private:
+    struct Key{
+        char const * file;
+        int line;
+        int op;
+
+        bool operator <(Key const & other) const {
+            if(file != other.file) return std::less<char const *>()(file, other.file);
+            return std::tie(line, op) < std::tie(other.line, other.op);
+        }
+    };
+
+    /**
+     * @brief 一つのスレッドの記録
+    */
+    struct Shard{
+        std::mutex mutex;
+        std::map<Key, GridOpStats> sites;
+    };
+
+    using merged_key_type = std::tuple<std::string, int, int>;  // ファイル、行、操作
+
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<Shard>> m_shards;
+    bool m_report_at_exit = false;
+
+    GridInstrumentation() = default;
+
+    ~GridInstrumentation(){
+        if(m_report_at_exit){
+            report(std::cerr);
+        }
+    }
+
+    /**
+     * @brief 呼び出したスレッドの表 初回のみ登録のためにロックを取る
+    */
+    Shard & local_shard(){
+        thread_local std::shared_ptr<Shard> shard = [this]{
+            auto created = std::make_shared<Shard>();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_shards.push_back(created);
+            return created;
+        }();
+        return *shard;
+    }
+
+    /**
+     * @brief 全スレッドの記録を、ファイル名の文字列で合算する
+    */
+    std::map<merged_key_type, GridOpStats> merged(){
+        std::map<merged_key_type, GridOpStats> result;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto const & shard : m_shards){
+            std::lock_guard<std::mutex> shard_lock(shard->mutex);
+            for(auto const & site : shard->sites){
+                auto & stats = result[merged_key_type(site.first.file, site.first.line, site.first.op)];
+                stats.calls += site.second.calls;
+                stats.reallocations += site.second.reallocations;
+                stats.bytes_moved += site.second.bytes_moved;
+            }
+        }
+        return result;
+    }
+
+public:
+    GridInstrumentation(GridInstrumentation const &) = delete;
+    GridInstrumentation & operator =(GridInstrumentation const &) = delete;
+
+    static GridInstrumentation & global(){
+        static GridInstrumentation instance;
+        return instance;
+    }
+
+    void record(GridOp const op, GridCallSite const & site, uint64_t const reallocations = 0, uint64_t const bytes_moved = 0){
+        Shard & shard = local_shard();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto & stats = shard.sites[Key{site.file, site.line, static_cast<int>(op)}];
+        ++stats.calls;
+        stats.reallocations += reallocations;
+        stats.bytes_moved += bytes_moved;
+    }
+
+    /**
+     * @brief 呼び出し元ごとの計数 記録がなければ全て0
+    */
+    GridOpStats stats(GridOp const op, char const * const file, int const line){
+        auto const sites = merged();
+        auto const it = sites.find(merged_key_type(file, line, static_cast<int>(op)));
+        return (it == sites.end()) ? GridOpStats() : it->second;
+    }
+
+    /**
+     * @brief 呼び出し元ごとの計数を、呼び出し回数の多い順に出力する
+    */
+    void report(std::ostream & os = std::cerr){
+        auto const sites = merged();
+        std::vector<std::pair<merged_key_type, GridOpStats>> rows(sites.begin(), sites.end());
+        std::stable_sort(rows.begin(), rows.end(), [](auto const & a, auto const & b){
+            return a.second.calls > b.second.calls;
+        });
+        os << "# grid access by call site\n";
+        detail::write_stats_header(os);
+        for(auto const & row : rows){
+            detail::write_stats_row(os, static_cast<GridOp>(std::get<2>(row.first)), row.second);
+            os << "    " << std::get<0>(row.first) << ':' << std::get<1>(row.first) << '\n';
+        }
+        os.flush();
+    }
+
+    /**
+     * @brief プロセスの終了時にstd::cerrへreport()するか
+    */
+    void report_at_exit(bool const enable = true){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_report_at_exit = enable;
+    }
+
+    /**
+     * @brief 全ての記録を捨てる
+    */
+    void reset(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto const & shard : m_shards){
+            std::lock_guard<std::mutex> shard_lock(shard->mutex);
+            shard->sites.clear();
+        }
+    }
+};
+
+/**
+ * @brief 生存中のグリッドの格納領域の登録先 プロセス全体で一つ
+ * @note グリッドは最後に格納領域を確保し直した呼び出し元(構築後に一度もなければ構築)で分類する
+ * @note 更新のたびにロックを取る 計測用であり、速さは求めない
+*/
+class GridMemoryRegistry{
+public:
+    /**
+     * @brief 全体の集計 reallocations, bytes_movedは破棄されたグリッドの分も含む
+    */
+    struct Totals{
+        uint64_t live_grids = 0;
+        uint64_t size_bytes = 0;
+        uint64_t capacity_bytes = 0;
+        uint64_t peak_capacity_bytes = 0;   // 生存中のグリッドの容量の合計の最大
+        uint64_t reallocations = 0;
+        uint64_t bytes_moved = 0;
+
+        uint64_t slack_bytes() const {
+            return capacity_bytes - size_bytes;
+        }
+    };
+
+    /**
+     * @brief 呼び出し元ごとの集計 fileがnullptrなら構築後に確保し直していないグリッド
+    */
+    struct Site{
+        GridCallSite site;
+        uint64_t grids = 0;
+        uint64_t size_bytes = 0;
+        uint64_t capacity_bytes = 0;
+
+        uint64_t slack_bytes() const {
+            return capacity_bytes - size_bytes;
+        }
+    };
+
+private:
+    struct Entry{
+        uint64_t size_bytes = 0;
+        uint64_t capacity_bytes = 0;
+        GridCallSite site{nullptr, 0};
+    };
+
+    std::mutex m_mutex;
+    std::map<void const *, Entry> m_live;
+    Totals m_totals;
+
+    GridMemoryRegistry() = default;
+
+public:
+    GridMemoryRegistry(GridMemoryRegistry const &) = delete;
+    GridMemoryRegistry & operator =(GridMemoryRegistry const &) = delete;
+
+    static GridMemoryRegistry & global(){
+        static GridMemoryRegistry instance;
+        return instance;
+    }
+
+    void add(void const * const key, uint64_t const size_bytes, uint64_t const capacity_bytes){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_live[key] = Entry{size_bytes, capacity_bytes, GridCallSite{nullptr, 0}};
+        ++m_totals.live_grids;
+        m_totals.size_bytes += size_bytes;
+        m_totals.capacity_bytes += capacity_bytes;
+        m_totals.peak_capacity_bytes = std::max(m_totals.peak_capacity_bytes, m_totals.capacity_bytes);
+    }
+
+    void update(void const * const key, uint64_t const size_bytes, uint64_t const capacity_bytes){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto const it = m_live.find(key);
+        if(it == m_live.end()) return;
+        m_totals.size_bytes += size_bytes - it->second.size_bytes;
+        m_totals.capacity_bytes += capacity_bytes - it->second.capacity_bytes;
+        m_totals.peak_capacity_bytes = std::max(m_totals.peak_capacity_bytes, m_totals.capacity_bytes);
+        it->second.size_bytes = size_bytes;
+        it->second.capacity_bytes = capacity_bytes;
+    }
+
+    /**
+     * @brief 格納領域が確保し直されたことを記録する reallocationsは既存の領域からの確保し直しなら1
+    */
+    void record_reallocation(void const * const key, GridCallSite const & site, uint64_t const reallocations, uint64_t const bytes_moved){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_totals.reallocations += reallocations;
+        m_totals.bytes_moved += bytes_moved;
+        auto const it = m_live.find(key);
+        if(it != m_live.end()){
+            it->second.site = site;
+        }
+    }
+
+    /**
+     * @brief fromの呼び出し元をtoへ引き継ぐ 格納領域ごとムーブした場合に使う
+    */
+    void move_site(void const * const from, void const * const to){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto const source = m_live.find(from);
+        auto const destination = m_live.find(to);
+        if(source != m_live.end() && destination != m_live.end()){
+            destination->second.site = source->second.site;
+        }
+    }
+
+    void remove(void const * const key){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto const it = m_live.find(key);
+        if(it == m_live.end()) return;
+        --m_totals.live_grids;
+        m_totals.size_bytes -= it->second.size_bytes;
+        m_totals.capacity_bytes -= it->second.capacity_bytes;
+        m_live.erase(it);
+    }
+
+    Totals totals(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_totals;
+    }
+
+    /**
+     * @brief 呼び出し元ごとの集計を、使っていないバイト数の多い順に返す
+    */
+    std::vector<Site> sites(){
+        std::map<std::pair<std::string, int>, Site> grouped;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(auto const & live : m_live){
+                Entry const & entry = live.second;
+                auto & site = grouped[std::make_pair(std::string(entry.site.file ? entry.site.file : ""), entry.site.line)];
+                site.site = entry.site;
+                ++site.grids;
+                site.size_bytes += entry.size_bytes;
+                site.capacity_bytes += entry.capacity_bytes;
+            }
+        }
+        std::vector<Site> result;
+        for(auto const & site : grouped){
+            result.push_back(site.second);
+        }
+        std::stable_sort(result.begin(), result.end(), [](Site const & a, Site const & b){
+            return a.slack_bytes() > b.slack_bytes();
+        });
+        return result;
+    }
+
+    /**
+     * @brief 全体の集計と、使っていないバイト数の多い順に最大top件の呼び出し元を出力する
+    */
+    void report(std::ostream & os = std::cerr, size_t const top = 16){
+        Totals const total = totals();
+        std::vector<Site> const list = sites();
+        os << "# grid memory\n"
+            << "live grids " << total.live_grids << ", size " << total.size_bytes << ", capacity " << total.capacity_bytes
+            << ", slack " << total.slack_bytes() << ", peak capacity " << total.peak_capacity_bytes << '\n'
+            << "reallocations " << total.reallocations << ", bytes moved " << total.bytes_moved << '\n';
+        os << std::setw(8) << "grids" << std::setw(14) << "size" << std::setw(14) << "capacity" << std::setw(14) << "slack" << '\n';
+        for(size_t i=0; i<list.size() && i<top; ++i){
+            Site const & site = list[i];
+            os << std::setw(8) << site.grids << std::setw(14) << site.size_bytes << std::setw(14) << site.capacity_bytes
+                << std::setw(14) << site.slack_bytes() << '\n';
+            if(site.site.file != nullptr){
+                os << "    " << site.site.file << ':' << site.site.line << '\n';
+            }else{
+                os << "    (not reallocated since construction)\n";
+            }
+        }
+        os.flush();
+    }
+};
+
+/**
+ * @brief グリッド一つ分の計数
+ * @note 計数はスレッドセーフ 複製・代入では引き継がず、新しいグリッドは0から数える
+ * @note 格納領域の大きさはtrack_memory()で更新し、GridMemoryRegistryへ登録する 複製の直後は複製元の格納領域(PitchedLayoutの余りを含む)の大きさを容量とみなす
+ * @note ムーブはnoexcept(グリッドのstd::vectorが再配置の際に複製しないように)
+*/
+class GridCounters{
+private:
+    struct Entry{
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> reallocations{0};
+        std::atomic<uint64_t> bytes_moved{0};
+    };
+
+    std::array<Entry, static_cast<size_t>(GridOp::Count)> m_entries;
+    int m_edit_depth = 0;   // 構造の変更の入れ子の深さ 一番外側の操作だけを数える
+    uint64_t m_size_bytes = 0;
+    uint64_t m_capacity_bytes = 0;
+    uint64_t m_storage_bytes = 0;  // レイアウトのstorage_size()分のバイト数 複製した際の容量の見積もりに使う
+    uint64_t m_peak_bytes = 0;
+
+    template <typename grid_type>
+    friend class GridEditRecord;
+
+    void set_memory(uint64_t const size_bytes, uint64_t const capacity_bytes, uint64_t const storage_bytes){
+        m_size_bytes = size_bytes;
+        m_capacity_bytes = capacity_bytes;
+        m_storage_bytes = storage_bytes;
+        m_peak_bytes = std::max(m_peak_bytes, capacity_bytes);
+        GridMemoryRegistry::global().update(this, size_bytes, capacity_bytes);
+    }
+
+public:
+    GridCounters(){
+        GridMemoryRegistry::global().add(this, 0, 0);
+    }
+    GridCounters(GridCounters const & other)
+        : m_size_bytes(other.m_size_bytes),
+        m_capacity_bytes(other.m_storage_bytes),
+        m_storage_bytes(other.m_storage_bytes),
+        m_peak_bytes(other.m_storage_bytes){
+        GridMemoryRegistry::global().add(this, m_size_bytes, m_capacity_bytes);
+    }
+    GridCounters(GridCounters && other) noexcept
+        : m_size_bytes(other.m_size_bytes),
+        m_capacity_bytes(other.m_capacity_bytes),
+        m_storage_bytes(other.m_storage_bytes),
+        m_peak_bytes(other.m_capacity_bytes){
+        GridMemoryRegistry::global().add(this, m_size_bytes, m_capacity_bytes);
+        GridMemoryRegistry::global().move_site(&other, this);
+        other.set_memory(0, 0, 0);
+    }
+    ~GridCounters(){
+        GridMemoryRegistry::global().remove(this);
+    }
+    GridCounters & operator =(GridCounters const & other){
+        if(this != &other){
+            set_memory(other.m_size_bytes, std::max(m_capacity_bytes, other.m_storage_bytes), other.m_storage_bytes);
+        }
+        return *this;
+    }
+    GridCounters & operator =(GridCounters && other) noexcept {
+        if(this != &other){
+            set_memory(other.m_size_bytes, other.m_capacity_bytes, other.m_storage_bytes);
+            GridMemoryRegistry::global().move_site(&other, this);
+            other.set_memory(0, 0, 0);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief アクセスを数える siteを渡した場合は呼び出し元ごとにも数える
+    */
+    void record(GridOp const op){
+        m_entries[static_cast<size_t>(op)].calls.fetch_add(1, std::memory_order_relaxed);
+    }
+    void record(GridOp const op, GridCallSite const & site){
+        record(op);
+        GridInstrumentation::global().record(op, site);
+    }
+
+    void record_edit(GridOp const op, GridCallSite const & site, uint64_t const reallocations, uint64_t const bytes_moved){
+        auto & entry = m_entries[static_cast<size_t>(op)];
+        entry.calls.fetch_add(1, std::memory_order_relaxed);
+        entry.reallocations.fetch_add(reallocations, std::memory_order_relaxed);
+        entry.bytes_moved.fetch_add(bytes_moved, std::memory_order_relaxed);
+        GridInstrumentation::global().record(op, site, reallocations, bytes_moved);
+    }
+
+    GridOpStats operator [] (GridOp const op) const {
+        auto const & entry = m_entries[static_cast<size_t>(op)];
+        GridOpStats stats;
+        stats.calls = entry.calls.load(std::memory_order_relaxed);
+        stats.reallocations = entry.reallocations.load(std::memory_order_relaxed);
+        stats.bytes_moved = entry.bytes_moved.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /**
+     * @brief 一度でも記録された操作を出力する
+    */
+    void report(std::ostream & os = std::cerr) const {
+        detail::write_stats_header(os);
+        for(int i=0; i<static_cast<int>(GridOp::Count); ++i){
+            GridOpStats const stats = (*this)[static_cast<GridOp>(i)];
+            if(stats.calls != 0){
+                detail::write_stats_row(os, static_cast<GridOp>(i), stats);
+            }
+        }
+        os.flush();
+    }
+
+    /**
+     * @brief グリッドのmemory_stats()の要素と容量のバイト数、レイアウトのstorage_size()分のバイト数を記録する
+    */
+    void track_memory(GridMemoryStats const & stats, uint64_t const storage_bytes){
+        set_memory(stats.size_bytes, stats.capacity_bytes, storage_bytes);
+    }
+
+    /**
+     * @brief 記録した格納領域と、構造の変更での確保し直しの合計 size_bytes, capacity_bytesは最後にtrack_memory()した時点の値
+    */
+    GridMemoryStats memory_stats() const {
+        GridMemoryStats stats;
+        stats.size_bytes = m_size_bytes;
+        stats.capacity_bytes = m_capacity_bytes;
+        stats.peak_bytes = m_peak_bytes;
+        for(auto const & entry : m_entries){
+            stats.reallocations += entry.reallocations.load(std::memory_order_relaxed);
+            stats.bytes_moved += entry.bytes_moved.load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    void reset(){
+        for(auto & entry : m_entries){
+            entry.calls.store(0, std::memory_order_relaxed);
+            entry.reallocations.store(0, std::memory_order_relaxed);
+            entry.bytes_moved.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+/**
+ * @brief 構造の変更の前後で格納領域を比べ、終了時に記録する
+ * @note 入れ子になった変更(push_back_columnからinsert_columnなど)は一番外側だけを数える
+ * @note 大きさはグリッドのmemory_stats()で比べる(PitchedLayoutの余りの列は要素に含めない)
+*/
+template <typename grid_type>
+class GridEditRecord{
+private:
+    GridCounters & m_counters;
+    GridOp m_op;
+    grid_type const & m_grid;
+    GridCallSite m_site;
+    void const * m_old_data;
+    uint64_t m_old_capacity;
+    uint64_t m_old_size;
+    bool m_outer;
+
+public:
+    GridEditRecord(GridCounters & counters, GridOp const op, grid_type const & grid, GridCallSite const & site)
+        : m_counters(counters),
+        m_op(op),
+        m_grid(grid),
+        m_site(site),
+        m_old_data(grid.data()),
+        m_old_capacity(grid.memory_stats().capacity_bytes),
+        m_old_size(grid.memory_stats().size_bytes),
+        m_outer(counters.m_edit_depth++ == 0){}
+
+    GridEditRecord(GridEditRecord const &) = delete;
+    GridEditRecord & operator =(GridEditRecord const &) = delete;
+
+    ~GridEditRecord(){
+        --m_counters.m_edit_depth;
+        if(!m_outer) return;
+        GridMemoryStats const stats = m_grid.memory_stats();
+        bool const changed = m_grid.data() != m_old_data || stats.capacity_bytes != m_old_capacity;
+        bool const reallocated = changed && m_old_capacity != 0;
+        uint64_t const bytes = reallocated ? std::min(m_old_size, stats.size_bytes) : 0;
+        m_counters.record_edit(m_op, m_site, reallocated ? 1 : 0, bytes);
+        m_counters.track_memory(stats, m_grid.layout().storage_size() * sizeof(typename grid_type::value_type));
+        if(changed){
+            GridMemoryRegistry::global().record_reallocation(&m_counters, m_site, reallocated ? 1 : 0, bytes);
+        }
+    }
+};
+
+} // namespace Utility
+
+#ifdef UTILITY_GRID_INSTRUMENT
+#define UTILITY_GRID_SITE , ::Utility::GridCallSite const site = ::Utility::GridCallSite::current()
+#define UTILITY_GRID_SITE_ONLY ::Utility::GridCallSite const site = ::Utility::GridCallSite::current()
+#define UTILITY_GRID_SITE_ARG , site
+#define UTILITY_GRID_COUNTERS mutable ::Utility::GridCounters m_counters;
+#define UTILITY_GRID_RECORD(op) m_counters.record(op, site)
+#define UTILITY_GRID_RECORD_SUBSCRIPT() m_counters.record(::Utility::GridOp::Subscript)
+#define UTILITY_GRID_RECORD_EDIT(op) ::Utility::GridEditRecord<std::remove_reference_t<decltype(*this)>> const grid_edit_record(m_counters, op, *this, site)
+#define UTILITY_GRID_TRACK_MEMORY() m_counters.track_memory(memory_stats(), layout().storage_size() * sizeof(data_type))
+#else
+#define UTILITY_GRID_SITE
+#define UTILITY_GRID_SITE_ONLY
+#define UTILITY_GRID_SITE_ARG
+#define UTILITY_GRID_COUNTERS
+#define UTILITY_GRID_RECORD(op) ((void)0)
+#define UTILITY_GRID_RECORD_SUBSCRIPT() ((void)0)
+#define UTILITY_GRID_RECORD_EDIT(op) ((void)0)
+#define UTILITY_GRID_TRACK_MEMORY() ((void)0)
+#endif
+
+
+#endif // ifndef UTILITY_GRID_INSTRUMENT_H
@@ -0,0 +1,703 @@
+/**
+ * @brief Grid2D, Grid3Dの要素の並べ方(レイアウト)を決めるクラス
+*/
+
+#ifndef UTILITY_GRID_LAYOUT_H
+#define UTILITY_GRID_LAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <type_traits>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace Utility{
+
+/**
+ * @brief 行優先のレイアウト [x + y * width]に格納する
+*/
+class RowMajorLayout{
+public:
+    using size_type = size_t;
+
+    static constexpr bool is_row_major = true;      // 隙間のない行優先か
+    static constexpr bool rows_contiguous = true;   // 各行がメモリ上で連続しているか
+    static constexpr size_type row_block = 1;       // 並列化などで行をまとめて扱う単位
+
+private:
+    size_type m_width = 0;
+    size_type m_height = 0;
+
+public:
+    RowMajorLayout(size_type const w = 0, size_type const h = 0)
+        : m_width(w),
+        m_height(h){}
+
+    /**
+     * @brief (y, x)の要素の格納位置
+    */
+    size_type index(size_type const y, size_type const x) const {
+        return x + y * m_width;
+    }
+
+    /**
+     * @brief 必要な格納領域の大きさ
+    */
+    size_type storage_size() const {
+        return m_width * m_height;
+    }
+
+    /**
+     * @brief 隣の行までの距離
+    */
+    size_type row_stride() const {
+        return m_width;
+    }
+
+    /**
+     * @brief [y_first, y_last)行の要素を格納順に走査する
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(size_type const y_first, size_type const y_last, const Function & func) const {
+        for(size_type i=y_first; i<y_last; ++i){
+            for(size_type j=0; j<m_width; ++j){
+                func(i, j);
+            }
+        }
+    }
+};
+
+/**
+ * @brief TileWidth x TileHeightのタイル単位で格納するレイアウト
+ * @note タイルの中は行優先、タイル同士も行優先に並べる 端のタイルは余りの要素を含む
+ * @note 縦方向の近傍アクセスが同じタイル内に収まりやすくなる
+*/
+template <size_t TileWidth, size_t TileHeight = TileWidth>
+class TiledLayout{
+public:
+    using size_type = size_t;
+
+    static_assert(TileWidth > 0 && (TileWidth & (TileWidth - 1)) == 0, "TileWidth must be a power of two");
+    static_assert(TileHeight > 0 && (TileHeight & (TileHeight - 1)) == 0, "TileHeight must be a power of two");
+
+    static constexpr bool is_row_major = false;
+    static constexpr bool rows_contiguous = false;
+    static constexpr size_type row_block = TileHeight;
+
+    static constexpr size_type tile_width = TileWidth;
+    static constexpr size_type tile_height = TileHeight;
+    static constexpr size_type tile_size = TileWidth * TileHeight;
+
+private:
+    static constexpr size_type log2(size_type const n){
+        return (n <= 1) ? 0 : 1 + log2(n >> 1);
+    }
+    static constexpr size_type shift_x = log2(TileWidth);
+    static constexpr size_type shift_y = log2(TileHeight);
+    static constexpr size_type mask_x = TileWidth - 1;
+    static constexpr size_type mask_y = TileHeight - 1;
+
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_tiles_x = 0; // 横方向のタイル数
+    size_type m_tiles_y = 0; // 縦方向のタイル数
+
+public:
+    TiledLayout(size_type const w = 0, size_type const h = 0)
+        : m_width(w),
+        m_height(h),
+        m_tiles_x((w + mask_x) >> shift_x),
+        m_tiles_y((h + mask_y) >> shift_y){}
+
+    /**
+     * @brief (y, x)の要素の格納位置
+    */
+    size_type index(size_type const y, size_type const x) const {
+        size_type const tile = (y >> shift_y) * m_tiles_x + (x >> shift_x);
+        return (tile << (shift_x + shift_y)) + ((y & mask_y) << shift_x) + (x & mask_x);
+    }
+
+    /**
+     * @brief 必要な格納領域の大きさ(余りの要素を含む)
+    */
+    size_type storage_size() const {
+        return m_tiles_x * m_tiles_y * tile_size;
+    }
+
+    /**
+     * @brief [y_first, y_last)行の要素をタイル順に走査する
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(size_type const y_first, size_type const y_last, const Function & func) const {
+        for(size_type ty=(y_first >> shift_y); (ty << shift_y) < y_last; ++ty){
+            size_type const i_first = (ty << shift_y) > y_first ? (ty << shift_y) : y_first;
+            size_type const i_last = ((ty + 1) << shift_y) < y_last ? ((ty + 1) << shift_y) : y_last;
+            for(size_type tx=0; tx<m_tiles_x; ++tx){
+                size_type const j_first = tx << shift_x;
+                size_type const j_last = ((tx + 1) << shift_x) < m_width ? ((tx + 1) << shift_x) : m_width;
+                for(size_type i=i_first; i<i_last; ++i){
+                    for(size_type j=j_first; j<j_last; ++j){
+                        func(i, j);
+                    }
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief 行の先頭をRowAlignment要素の境界に揃える行優先のレイアウト [x + y * pitch]に格納する
+ * @tparam RowAlignment 行の間隔(pitch)を揃える要素数 2のべき乗
+ * @note pitchはwidth以上で、行末の余りの列は後方への列の追加に使う
+ * @note 行の先頭のアドレスが揃うのは、格納領域の先頭もRowAlignment * sizeof(要素)に揃っている場合(CacheAlignedAllocatorなど)
+*/
+template <size_t RowAlignment = 16>
+class PitchedLayout{
+public:
+    using size_type = size_t;
+
+    static_assert(RowAlignment > 0 && (RowAlignment & (RowAlignment - 1)) == 0, "RowAlignment must be a power of two");
+
+    static constexpr bool is_row_major = false;
+    static constexpr bool rows_contiguous = true;
+    static constexpr size_type row_block = 1;
+
+    static constexpr size_type row_alignment = RowAlignment;
+
+private:
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_pitch = 0; // 隣の行までの要素数
+
+public:
+    /**
+     * @brief pitchをwidthをRowAlignmentに切り上げた値にして構築
+    */
+    PitchedLayout(size_type const w = 0, size_type const h = 0)
+        : m_width(w),
+        m_height(h),
+        m_pitch(aligned_pitch(w)){}
+
+    /**
+     * @brief pitchを指定して構築 pitchはwidth以上に、RowAlignmentの倍数に切り上げる
+    */
+    PitchedLayout(size_type const w, size_type const h, size_type const pitch)
+        : m_width(w),
+        m_height(h),
+        m_pitch(aligned_pitch(pitch < w ? w : pitch)){}
+
+    /**
+     * @brief widthをRowAlignmentの倍数に切り上げる
+    */
+    static constexpr size_type aligned_pitch(size_type const w){
+        return (w + RowAlignment - 1) & ~(RowAlignment - 1);
+    }
+
+    /**
+     * @brief (y, x)の要素の格納位置
+    */
+    size_type index(size_type const y, size_type const x) const {
+        return x + y * m_pitch;
+    }
+
+    /**
+     * @brief 必要な格納領域の大きさ(余りの列を含む)
+    */
+    size_type storage_size() const {
+        return m_pitch * m_height;
+    }
+
+    /**
+     * @brief 隣の行までの距離
+    */
+    size_type row_stride() const {
+        return m_pitch;
+    }
+
+    /**
+     * @brief 再配置せずに広げられる幅
+    */
+    size_type pitch() const {
+        return m_pitch;
+    }
+
+    /**
+     * @brief [y_first, y_last)行の要素を格納順に走査する 余りの列は走査しない
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(size_type const y_first, size_type const y_last, const Function & func) const {
+        for(size_type i=y_first; i<y_last; ++i){
+            for(size_type j=0; j<m_width; ++j){
+                func(i, j);
+            }
+        }
+    }
+};
+
+/**
+ * @brief 各行が連続していないレイアウトでの[y][x]アクセス用クラス
+*/
+template <typename data_type, typename layout_type>
+class GridRowAccessor{
+private:
+    data_type * m_data;
+    layout_type const * m_layout;
+    size_t m_y;
+
+public:
+    GridRowAccessor(data_type * data, layout_type const * layout, size_t const y)
+        : m_data(data),
+        m_layout(layout),
+        m_y(y){}
+
+    /**
+     * @brief [x]で要素アクセス
+    */
+    data_type & operator [] (int const x) const {
+        return m_data[m_layout->index(m_y, x)];
+    }
+};
+
+/**
+ * @brief 三次元の行優先のレイアウト [x + y * width + z * width * height]に格納する
+*/
+class RowMajorLayout3D{
+public:
+    using size_type = size_t;
+
+    static constexpr bool is_row_major = true;
+    static constexpr bool rows_contiguous = true;
+
+private:
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_depth = 0;
+
+public:
+    RowMajorLayout3D(size_type const w = 0, size_type const h = 0, size_type const d = 0)
+        : m_width(w),
+        m_height(h),
+        m_depth(d){}
+
+    /**
+     * @brief (z, y, x)の要素の格納位置
+    */
+    size_type index(size_type const z, size_type const y, size_type const x) const {
+        return x + y * m_width + z * m_width * m_height;
+    }
+
+    /**
+     * @brief 必要な格納領域の大きさ
+    */
+    size_type storage_size() const {
+        return m_width * m_height * m_depth;
+    }
+
+    /**
+     * @brief 隣の行までの距離
+    */
+    size_type row_stride() const {
+        return m_width;
+    }
+
+    /**
+     * @brief 隣の奥までの距離
+    */
+    size_type slice_stride() const {
+        return m_width * m_height;
+    }
+
+    /**
+     * @brief 並列化などで分割する単位(帯)の数 (z, y)の行ごと
+    */
+    size_type band_count() const {
+        return m_depth * m_height;
+    }
+
+    /**
+     * @brief [b_first, b_last)番目の帯の要素を格納順に走査する
+     * @param[in] func z,y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(size_type const b_first, size_type const b_last, const Function & func) const {
+        for(size_type r=b_first; r<b_last; ++r){
+            size_type const i = r / m_height;
+            size_type const j = r % m_height;
+            for(size_type k=0; k<m_width; ++k){
+                func(i, j, k);
+            }
+        }
+    }
+};
+
+namespace detail{
+
+/**
+ * @brief 各ビットの間に2ビットずつ空けるための表
+*/
+template <size_t Bits>
+struct MortonTable{
+    std::array<std::uint32_t, (1u << Bits)> spread{};
+
+    constexpr MortonTable(){
+        for(std::uint32_t v=0; v<(1u << Bits); ++v){
+            std::uint32_t r = 0;
+            for(size_t b=0; b<Bits; ++b){
+                r |= ((v >> b) & 1u) << (3 * b);
+            }
+            spread[v] = r;
+        }
+    }
+};
+
+/**
+ * @brief 余りの列を持ち、大きさだけでは格納位置が決まらないレイアウトか
+*/
+template <typename layout_type>
+struct is_pitched_layout{
+    static constexpr bool value = false;
+};
+
+template <size_t RowAlignment>
+struct is_pitched_layout<PitchedLayout<RowAlignment>>{
+    static constexpr bool value = true;
+};
+
+} // namespace detail
+
+/**
+ * @brief 2^BrickBitsの立方体(ブリック)の中をモートン順(Z-order)に並べる三次元のレイアウト
+ * @note ブリック同士はx, y, zの順に並べる 端のブリックは余りの要素を含む
+ * @note BMI2が使える場合はpdep、それ以外では表引きでビットを交互に並べる
+*/
+template <size_t BrickBits = 3>
+class MortonLayout3D{
+public:
+    using size_type = size_t;
+
+    static_assert(BrickBits >= 1 && BrickBits <= 8, "BrickBits must be in [1, 8]");
+
+    static constexpr bool is_row_major = false;
+    static constexpr bool rows_contiguous = false;
+
+    static constexpr size_type brick_width = size_type(1) << BrickBits;
+    static constexpr size_type brick_size = size_type(1) << (3 * BrickBits);
+
+private:
+    static constexpr size_type mask = brick_width - 1;
+    static constexpr detail::MortonTable<BrickBits> table{};
+
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_depth = 0;
+    size_type m_bricks_x = 0;
+    size_type m_bricks_y = 0;
+    size_type m_bricks_z = 0;
+    size_type m_stride_y = 0; // y方向に隣のブリックまでの距離
+    size_type m_stride_z = 0; // z方向に隣のブリックまでの距離
+
+public:
+    MortonLayout3D(size_type const w = 0, size_type const h = 0, size_type const d = 0)
+        : m_width(w),
+        m_height(h),
+        m_depth(d),
+        m_bricks_x((w + mask) >> BrickBits),
+        m_bricks_y((h + mask) >> BrickBits),
+        m_bricks_z((d + mask) >> BrickBits),
+        m_stride_y(m_bricks_x * brick_size),
+        m_stride_z(m_bricks_x * m_bricks_y * brick_size){}
+
+    /**
+     * @brief ブリック内の座標からモートン符号を求める
+    */
+    static size_type morton(size_type const z, size_type const y, size_type const x){
+#if defined(__BMI2__)
+        return _pdep_u32(static_cast<unsigned>(x), 0x09249249u)
+            | _pdep_u32(static_cast<unsigned>(y), 0x12492492u)
+            | _pdep_u32(static_cast<unsigned>(z), 0x24924924u);
+#else
+        return table.spread[x] | (table.spread[y] << 1) | (table.spread[z] << 2);
+#endif
+    }
+
+    /**
+     * @brief (z, y, x)の要素の格納位置
+    */
+    size_type index(size_type const z, size_type const y, size_type const x) const {
+        return ((x >> BrickBits) << (3 * BrickBits)) + (y >> BrickBits) * m_stride_y + (z >> BrickBits) * m_stride_z
+            + morton(z & mask, y & mask, x & mask);
+    }
+
+    /**
+     * @brief 必要な格納領域の大きさ(余りの要素を含む)
+    */
+    size_type storage_size() const {
+        return m_bricks_x * m_bricks_y * m_bricks_z * brick_size;
+    }
+
+    /**
+     * @brief 並列化などで分割する単位(帯)の数 (z, y)方向のブリックの列ごと
+    */
+    size_type band_count() const {
+        return m_bricks_z * m_bricks_y;
+    }
+
+    /**
+     * @brief [b_first, b_last)番目の帯の要素をブリック順に走査する
+     * @param[in] func z,y,xを引数として受け取る関数
+     * @note ブリック内の要素は一つのブリックを処理し終えてから次のブリックへ進む
+    */
+    template <typename Function>
+    void foreach(size_type const b_first, size_type const b_last, const Function & func) const {
+        for(size_type b=b_first; b<b_last; ++b){
+            size_type const i_first = (b / m_bricks_y) << BrickBits;
+            size_type const j_first = (b % m_bricks_y) << BrickBits;
+            size_type const i_last = (i_first + brick_width < m_depth) ? i_first + brick_width : m_depth;
+            size_type const j_last = (j_first + brick_width < m_height) ? j_first + brick_width : m_height;
+            for(size_type k_first=0; k_first<m_width; k_first+=brick_width){
+                size_type const k_last = (k_first + brick_width < m_width) ? k_first + brick_width : m_width;
+                for(size_type i=i_first; i<i_last; ++i){
+                    for(size_type j=j_first; j<j_last; ++j){
+                        for(size_type k=k_first; k<k_last; ++k){
+                            func(i, j, k);
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief 各行が連続していない三次元のレイアウトでの[z][y][x]アクセスのうち、[x]の部分
+*/
+template <typename data_type, typename layout_type>
+class GridRowAccessor3D{
+private:
+    data_type * m_data;
+    layout_type const * m_layout;
+    size_t m_z;
+    size_t m_y;
+
+public:
+    GridRowAccessor3D(data_type * data, layout_type const * layout, size_t const z, size_t const y)
+        : m_data(data),
+        m_layout(layout),
+        m_z(z),
+        m_y(y){}
+
+    /**
+     * @brief [x]で要素アクセス
+    */
+    data_type & operator [] (int const x) const {
+        return m_data[m_layout->index(m_z, m_y, x)];
+    }
+};
+
+/**
+ * @brief 任意の間隔で要素を参照するレイアウト GridView2Dで使う
+ * @note 間隔は負でもよい 格納領域は所有しないため、storage_size()を持たない
+*/
+class StridedLayout2D{
+public:
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    static constexpr bool is_row_major = false;
+    static constexpr bool rows_contiguous = false;
+    static constexpr size_type row_block = 1;
+
+private:
+    size_type m_width = 0;
+    difference_type m_row_stride = 0;
+    difference_type m_col_stride = 1;
+
+public:
+    StridedLayout2D(size_type const w = 0, size_type const = 0, difference_type const row_stride = 0, difference_type const col_stride = 1)
+        : m_width(w),
+        m_row_stride(row_stride),
+        m_col_stride(col_stride){}
+
+    /**
+     * @brief (y, x)の要素の先頭からの位置
+    */
+    difference_type index(size_type const y, size_type const x) const {
+        return difference_type(y) * m_row_stride + difference_type(x) * m_col_stride;
+    }
+
+    /**
+     * @brief 隣の行までの距離
+    */
+    difference_type row_stride() const {
+        return m_row_stride;
+    }
+
+    /**
+     * @brief 隣の列までの距離
+    */
+    difference_type col_stride() const {
+        return m_col_stride;
+    }
+
+    /**
+     * @brief [y_first, y_last)行の要素を行ごとに走査する
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(size_type const y_first, size_type const y_last, const Function & func) const {
+        for(size_type i=y_first; i<y_last; ++i){
+            for(size_type j=0; j<m_width; ++j){
+                func(i, j);
+            }
+        }
+    }
+};
+
+/**
+ * @brief 任意の間隔で要素を参照する三次元のレイアウト GridView3Dで使う
+*/
+class StridedLayout3D{
+public:
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+
+    static constexpr bool is_row_major = false;
+    static constexpr bool rows_contiguous = false;
+
+private:
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_depth = 0;
+    difference_type m_slice_stride = 0;
+    difference_type m_row_stride = 0;
+    difference_type m_col_stride = 1;
+
+public:
+    StridedLayout3D(size_type const w = 0, size_type const h = 0, size_type const d = 0,
+        difference_type const slice_stride = 0, difference_type const row_stride = 0, difference_type const col_stride = 1)
+        : m_width(w),
+        m_height(h),
+        m_depth(d),
+        m_slice_stride(slice_stride),
+        m_row_stride(row_stride),
+        m_col_stride(col_stride){}
+
+    /**
+     * @brief (z, y, x)の要素の先頭からの位置
+    */
+    difference_type index(size_type const z, size_type const y, size_type const x) const {
+        return difference_type(z) * m_slice_stride + difference_type(y) * m_row_stride + difference_type(x) * m_col_stride;
+    }
+
+    /**
+     * @brief 隣の奥までの距離
+    */
+    difference_type slice_stride() const {
+        return m_slice_stride;
+    }
+
+    /**
+     * @brief 隣の行までの距離
+    */
+    difference_type row_stride() const {
+        return m_row_stride;
+    }
+
+    /**
+     * @brief 隣の列までの距離
+    */
+    difference_type col_stride() const {
+        return m_col_stride;
+    }
+
+    /**
+     * @brief 並列化などで分割する単位(帯)の数 (z, y)の行ごと
+    */
+    size_type band_count() const {
+        return m_depth * m_height;
+    }
+
+    /**
+     * @brief [b_first, b_last)番目の帯の要素を走査する
+     * @param[in] func z,y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(size_type const b_first, size_type const b_last, const Function & func) const {
+        for(size_type r=b_first; r<b_last; ++r){
+            size_type const i = r / m_height;
+            size_type const j = r % m_height;
+            for(size_type k=0; k<m_width; ++k){
+                func(i, j, k);
+            }
+        }
+    }
+};
+
+/**
+ * @brief 列の間隔が1とは限らない行の[x]アクセス用クラス
+*/
+template <typename data_type>
+class GridStridedRow{
+private:
+    data_type * m_data;
+    ptrdiff_t m_stride;
+
+public:
+    GridStridedRow(data_type * data, ptrdiff_t const stride)
+        : m_data(data),
+        m_stride(stride){}
+
+    /**
+     * @brief [x]で要素アクセス
+    */
+    data_type & operator [] (int const x) const {
+        return m_data[x * m_stride];
+    }
+};
+
+namespace detail{
+
+/**
+ * @brief 各方向の間隔が一定のレイアウトか
+*/
+template <typename layout_type>
+struct is_strided_layout : std::false_type{};
+template <>
+struct is_strided_layout<RowMajorLayout> : std::true_type{};
+template <>
+struct is_strided_layout<RowMajorLayout3D> : std::true_type{};
+template <size_t RowAlignment>
+struct is_strided_layout<PitchedLayout<RowAlignment>> : std::true_type{};
+template <>
+struct is_strided_layout<StridedLayout2D> : std::true_type{};
+template <>
+struct is_strided_layout<StridedLayout3D> : std::true_type{};
+
+inline std::array<ptrdiff_t, 3> layout_strides(RowMajorLayout const & layout){
+    return {1, ptrdiff_t(layout.row_stride()), 0};
+}
+inline std::array<ptrdiff_t, 3> layout_strides(RowMajorLayout3D const & layout){
+    return {1, ptrdiff_t(layout.row_stride()), ptrdiff_t(layout.slice_stride())};
+}
+template <size_t RowAlignment>
+std::array<ptrdiff_t, 3> layout_strides(PitchedLayout<RowAlignment> const & layout){
+    return {1, ptrdiff_t(layout.row_stride()), 0};
+}
+inline std::array<ptrdiff_t, 3> layout_strides(StridedLayout2D const & layout){
+    return {layout.col_stride(), layout.row_stride(), 0};
+}
+inline std::array<ptrdiff_t, 3> layout_strides(StridedLayout3D const & layout){
+    return {layout.col_stride(), layout.row_stride(), layout.slice_stride()};
+}
+
+} // namespace detail
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_LAYOUT_H
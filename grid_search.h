@@ -0,0 +1,432 @@
+/**
+ * @brief Grid2D, Grid3Dの塗りつぶしと幅優先探索による距離
+ * @note 訪問済みはビット列、探索の前線はリングバッファで持ち、GridSearchを使い回せば二回目以降の探索でメモリ確保を行わない
+*/
+
+#ifndef UTILITY_GRID_SEARCH_H
+#define UTILITY_GRID_SEARCH_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include "grid2d.h"
+#include "grid3d.h"
+
+namespace Utility{
+
+/**
+ * @brief 隣接の定義 Four, Eightは二次元、Six, TwentySixは三次元
+*/
+enum class GridConnectivity{
+    Four,
+    Eight,
+    Six,
+    TwentySix
+};
+
+namespace detail{
+
+/**
+ * @brief 1要素1ビットの訪問済みフラグ
+*/
+class GridVisitedMask{
+private:
+    std::vector<uint64_t> m_bits;
+
+public:
+    /**
+     * @brief n要素分を全て未訪問にする 容量が足りていれば確保しない
+    */
+    void reset(size_t const n){
+        m_bits.assign((n + 63) / 64, 0);
+    }
+
+    bool test(size_t const i) const {
+        return (m_bits[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void set(size_t const i){
+        m_bits[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+};
+
+/**
+ * @brief 容量が2のべき乗のリングバッファ 一杯になった時だけ倍に広げる
+*/
+template <typename T>
+class GridRingBuffer{
+private:
+    std::vector<T> m_items;
+    size_t m_head = 0;
+    size_t m_size = 0;
+
+public:
+    void clear(){
+        m_head = 0;
+        m_size = 0;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    void push(T const & item){
+        if(m_size == m_items.size()) grow();
+        m_items[(m_head + m_size) & (m_items.size() - 1)] = item;
+        ++m_size;
+    }
+
+    T pop(){
+        T const item = m_items[m_head];
+        m_head = (m_head + 1) & (m_items.size() - 1);
+        --m_size;
+        return item;
+    }
+
+private:
+    void grow(){
+        std::vector<T> items(m_items.empty() ? 64 : m_items.size() * 2);
+        for(size_t i=0; i<m_size; ++i){
+            items[i] = m_items[(m_head + i) & (m_items.size() - 1)];
+        }
+        m_items.swap(items);
+        m_head = 0;
+    }
+};
+
+/**
+ * @brief 三次元の大きさ 二次元は奥行1として扱う
+*/
+struct GridExtent{
+    size_t w, h, d;
+
+    size_t size() const {
+        return w * h * d;
+    }
+};
+
+/**
+ * @brief 隣接の定義から、x方向の広がり(0か1)と、隣接する(dz, dy)の組を返す
+*/
+inline int connectivity_offsets(GridConnectivity const connectivity, int (&offsets)[8][2], int & count){
+    count = 0;
+    bool const diagonal = (connectivity == GridConnectivity::Eight || connectivity == GridConnectivity::TwentySix);
+    bool const volume = (connectivity == GridConnectivity::Six || connectivity == GridConnectivity::TwentySix);
+    for(int dz=(volume ? -1 : 0); dz<=(volume ? 1 : 0); ++dz){
+        for(int dy=-1; dy<=1; ++dy){
+            if(dz == 0 && dy == 0) continue;
+            if(!diagonal && dz != 0 && dy != 0) continue;
+            offsets[count][0] = dz;
+            offsets[count][1] = dy;
+            ++count;
+        }
+    }
+    return diagonal ? 1 : 0;
+}
+
+} // namespace detail
+
+/**
+ * @brief 塗りつぶしと幅優先探索の作業領域
+ * @note 同じインスタンスを使い回すと、訪問済みフラグと前線の領域が再利用される スレッドごとに別のインスタンスを使うこと
+*/
+class GridSearch{
+public:
+    using size_type = size_t;
+
+private:
+    detail::GridVisitedMask m_visited;
+    detail::GridRingBuffer<size_type> m_frontier;
+    std::vector<size_type> m_stack;
+    std::vector<std::pair<size_type, size_type>> m_sources;
+
+public:
+    /**
+     * @brief (y, x)から、predを満たす要素がつながった領域を走査線単位で塗りつぶす
+     * @param[in] pred 要素の値を引数として受け取り、領域に含めるかを返す関数
+     * @param[in] visit y,xを引数として受け取る関数 領域内の各要素について一度だけ呼ばれる
+     * @param[in] connectivity GridConnectivity::FourかEight
+     * @return 領域の要素数 (y, x)がpredを満たさなければ0
+    */
+    template <typename grid_type, typename Predicate, typename Visit, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    size_type fill_region(grid_type const & grid, size_type const y, size_type const x,
+        Predicate const & pred, Visit const & visit, GridConnectivity const connectivity = GridConnectivity::Four){
+
+        check_connectivity2d(connectivity);
+        return scanline({grid.width(), grid.height(), 1}, 0, y, x, connectivity,
+            [&](size_type, size_type const i, size_type const j){ return pred(grid.data()[grid.layout().index(i, j)]); },
+            [&](size_type, size_type const i, size_type const j){ visit(i, j); });
+    }
+
+    /**
+     * @brief (y, x)と同じ値でつながった領域をvalueで塗りつぶす
+     * @return 塗りつぶした要素数
+    */
+    template <typename grid_type, typename value_type, std::enable_if_t<detail::is_grid2d<std::decay_t<grid_type>>::value, std::nullptr_t> = nullptr>
+    size_type flood_fill(grid_type && grid, size_type const y, size_type const x,
+        value_type const & value, GridConnectivity const connectivity = GridConnectivity::Four){
+
+        typename std::decay_t<grid_type>::value_type const target = grid.at(y, x);
+        return fill_region(grid, y, x, [&target](auto const & v){ return v == target; },
+            [&](size_type const i, size_type const j){ grid.data()[grid.layout().index(i, j)] = value; }, connectivity);
+    }
+
+    /**
+     * @brief 複数の始点からの、passableを満たす要素のみを通る最短距離(歩数)
+     * @param[in] sources 始点の(y, x)の列 passableを満たさない始点は無視する
+     * @param[in] passable 要素の値を引数として受け取り、通れるかを返す関数
+     * @param[out] distance 各要素の距離 到達できない要素は-1 大きさが異なる場合はgridに合わせる
+     * @param[in] connectivity GridConnectivity::FourかEight
+    */
+    template <typename grid_type, typename Predicate, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    void distance_map(grid_type const & grid, std::vector<std::pair<size_type, size_type>> const & sources,
+        Predicate const & passable, Grid2D<int> & distance, GridConnectivity const connectivity = GridConnectivity::Four){
+
+        check_connectivity2d(connectivity);
+        if(distance.width() != grid.width() || distance.height() != grid.height()){
+            distance.resize(grid.width(), grid.height());
+        }
+        detail::GridExtent const e{grid.width(), grid.height(), 1};
+        m_frontier.clear();
+        m_visited.reset(e.size());
+        std::fill(distance.data(), distance.data() + e.size(), -1);
+        for(auto const & s : sources){
+            if(s.first >= e.h || s.second >= e.w){
+                throw std::out_of_range("GridSearch: source out of range");
+            }
+            size_type const i = s.first * e.w + s.second;
+            if(m_visited.test(i) || !passable(grid.data()[grid.layout().index(s.first, s.second)])) continue;
+            m_visited.set(i);
+            distance.data()[i] = 0;
+            m_frontier.push(i);
+        }
+        bfs(e, connectivity,
+            [&](size_type, size_type const i, size_type const j){ return passable(grid.data()[grid.layout().index(i, j)]); },
+            distance.data());
+    }
+
+    /**
+     * @brief (z, y, x)から、predを満たす要素がつながった領域を走査線単位で塗りつぶす
+     * @param[in] visit z,y,xを引数として受け取る関数
+     * @param[in] connectivity GridConnectivity::SixかTwentySix
+    */
+    template <typename grid_type, typename Predicate, typename Visit, std::enable_if_t<detail::is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+    size_type fill_region(grid_type const & grid, size_type const z, size_type const y, size_type const x,
+        Predicate const & pred, Visit const & visit, GridConnectivity const connectivity = GridConnectivity::Six){
+
+        check_connectivity3d(connectivity);
+        return scanline({grid.width(), grid.height(), grid.depth()}, z, y, x, connectivity,
+            [&](size_type const k, size_type const i, size_type const j){ return pred(grid.data()[grid.layout().index(k, i, j)]); },
+            visit);
+    }
+
+    /**
+     * @brief (z, y, x)と同じ値でつながった領域をvalueで塗りつぶす
+    */
+    template <typename grid_type, typename value_type, std::enable_if_t<detail::is_grid3d<std::decay_t<grid_type>>::value, std::nullptr_t> = nullptr>
+    size_type flood_fill(grid_type && grid, size_type const z, size_type const y, size_type const x,
+        value_type const & value, GridConnectivity const connectivity = GridConnectivity::Six){
+
+        typename std::decay_t<grid_type>::value_type const target = grid.at(z, y, x);
+        return fill_region(grid, z, y, x, [&target](auto const & v){ return v == target; },
+            [&](size_type const k, size_type const i, size_type const j){ grid.data()[grid.layout().index(k, i, j)] = value; }, connectivity);
+    }
+
+    /**
+     * @brief 複数の始点からの、passableを満たす要素のみを通る最短距離(歩数)
+     * @param[in] sources 始点の(x, y, z)のタプルの列
+     * @param[in] connectivity GridConnectivity::SixかTwentySix
+    */
+    template <typename grid_type, typename Predicate, std::enable_if_t<detail::is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+    void distance_map(grid_type const & grid, std::vector<std::tuple<int, int, int>> const & sources,
+        Predicate const & passable, Grid3D<int> & distance, GridConnectivity const connectivity = GridConnectivity::Six){
+
+        check_connectivity3d(connectivity);
+        if(distance.width() != grid.width() || distance.height() != grid.height() || distance.depth() != grid.depth()){
+            distance.resize(grid.width(), grid.height(), grid.depth());
+        }
+        detail::GridExtent const e{grid.width(), grid.height(), grid.depth()};
+        m_frontier.clear();
+        m_visited.reset(e.size());
+        std::fill(distance.data(), distance.data() + e.size(), -1);
+        for(auto const & s : sources){
+            size_type const x = std::get<0>(s), y = std::get<1>(s), z = std::get<2>(s);
+            if(x >= e.w || y >= e.h || z >= e.d){
+                throw std::out_of_range("GridSearch: source out of range");
+            }
+            size_type const i = (z * e.h + y) * e.w + x;
+            if(m_visited.test(i) || !passable(grid.data()[grid.layout().index(z, y, x)])) continue;
+            m_visited.set(i);
+            distance.data()[i] = 0;
+            m_frontier.push(i);
+        }
+        bfs(e, connectivity,
+            [&](size_type const k, size_type const i, size_type const j){ return passable(grid.data()[grid.layout().index(k, i, j)]); },
+            distance.data());
+    }
+
+#ifdef UTILITY_POINT2I_H
+
+    // point2i.hがincludeされている場合
+
+    /**
+     * @brief (x, y)のPoint2iから、predを満たす要素がつながった領域を塗りつぶす
+     * @param[in] visit (x, y)のPoint2iを引数として受け取る関数
+    */
+    template <typename grid_type, typename Predicate, typename Visit, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    size_type fill_region(grid_type const & grid, Point2i const & seed,
+        Predicate const & pred, Visit const & visit, GridConnectivity const connectivity = GridConnectivity::Four){
+
+        check_point(grid, seed);
+        return fill_region(grid, seed.y, seed.x, pred,
+            [&visit](size_type const i, size_type const j){ visit(Point2i(j, i)); }, connectivity);
+    }
+
+    /**
+     * @brief (x, y)のPoint2iと同じ値でつながった領域をvalueで塗りつぶす
+    */
+    template <typename grid_type, typename value_type, std::enable_if_t<detail::is_grid2d<std::decay_t<grid_type>>::value, std::nullptr_t> = nullptr>
+    size_type flood_fill(grid_type && grid, Point2i const & seed,
+        value_type const & value, GridConnectivity const connectivity = GridConnectivity::Four){
+
+        check_point(grid, seed);
+        return flood_fill(grid, seed.y, seed.x, value, connectivity);
+    }
+
+    /**
+     * @brief (x, y)のPoint2iの始点からの最短距離
+    */
+    template <typename grid_type, typename Predicate, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    void distance_map(grid_type const & grid, std::vector<Point2i> const & sources,
+        Predicate const & passable, Grid2D<int> & distance, GridConnectivity const connectivity = GridConnectivity::Four){
+
+        m_sources.clear();
+        for(auto const & s : sources){
+            check_point(grid, s);
+            m_sources.emplace_back(s.y, s.x);
+        }
+        distance_map(grid, m_sources, passable, distance, connectivity);
+    }
+
+private:
+    template <typename grid_type>
+    static void check_point(grid_type const & grid, Point2i const & pos){
+        if(pos.x < 0 || pos.y < 0 || size_type(pos.x) >= grid.width() || size_type(pos.y) >= grid.height()){
+            throw std::out_of_range("GridSearch: position out of range");
+        }
+    }
+
+#endif // ifdef UTILITY_POINT2I_H
+
+private:
+    static void check_connectivity2d(GridConnectivity const connectivity){
+        if(connectivity != GridConnectivity::Four && connectivity != GridConnectivity::Eight){
+            throw std::invalid_argument("GridSearch: Grid2D requires GridConnectivity::Four or Eight");
+        }
+    }
+
+    static void check_connectivity3d(GridConnectivity const connectivity){
+        if(connectivity != GridConnectivity::Six && connectivity != GridConnectivity::TwentySix){
+            throw std::invalid_argument("GridSearch: Grid3D requires GridConnectivity::Six or TwentySix");
+        }
+    }
+
+    /**
+     * @brief 走査線による塗りつぶし x方向の連続した区間をまとめて塗り、隣接する行から次の区間の種を積む
+    */
+    template <typename Predicate, typename Visit>
+    size_type scanline(detail::GridExtent const & e, size_type const z, size_type const y, size_type const x,
+        GridConnectivity const connectivity, Predicate const & pred, Visit const & visit){
+
+        if(z >= e.d || y >= e.h || x >= e.w){
+            throw std::out_of_range("GridSearch: seed out of range");
+        }
+        int offsets[8][2];
+        int offset_count;
+        size_type const spread = detail::connectivity_offsets(connectivity, offsets, offset_count);
+
+        m_visited.reset(e.size());
+        m_stack.clear();
+        m_stack.push_back((z * e.h + y) * e.w + x);
+        size_type filled = 0;
+        while(!m_stack.empty()){
+            size_type const seed = m_stack.back();
+            m_stack.pop_back();
+            size_type const row = seed / e.w;
+            size_type const k = row / e.h, i = row % e.h;
+            size_type const base = row * e.w;
+            size_type const j = seed - base;
+            if(m_visited.test(seed) || !pred(k, i, j)) continue;
+
+            // 左右に区間を広げる
+            size_type left = j, right = j;
+            while(left > 0 && !m_visited.test(base + left - 1) && pred(k, i, left - 1)) --left;
+            while(right + 1 < e.w && !m_visited.test(base + right + 1) && pred(k, i, right + 1)) ++right;
+            for(size_type c=left; c<=right; ++c){
+                m_visited.set(base + c);
+                visit(k, i, c);
+            }
+            filled += right - left + 1;
+
+            // 隣接する行の、区間に接する部分から連続した塗れる区間ごとに一つ種を積む
+            size_type const first = (left >= spread) ? left - spread : 0;
+            size_type const last = std::min(right + spread, e.w - 1);
+            for(int n=0; n<offset_count; ++n){
+                long const nk = long(k) + offsets[n][0];
+                long const ni = long(i) + offsets[n][1];
+                if(nk < 0 || nk >= long(e.d) || ni < 0 || ni >= long(e.h)) continue;
+                size_type const nbase = (size_type(nk) * e.h + size_type(ni)) * e.w;
+                bool in_span = false;
+                for(size_type c=first; c<=last; ++c){
+                    bool const open = !m_visited.test(nbase + c) && pred(nk, ni, c);
+                    if(open && !in_span) m_stack.push_back(nbase + c);
+                    in_span = open;
+                }
+            }
+        }
+        return filled;
+    }
+
+    /**
+     * @brief 前線に積まれた始点からの幅優先探索 distanceは行優先の格納領域
+    */
+    template <typename Predicate>
+    void bfs(detail::GridExtent const & e, GridConnectivity const connectivity, Predicate const & passable, int * const distance){
+        int offsets[8][2];
+        int offset_count;
+        int const spread = detail::connectivity_offsets(connectivity, offsets, offset_count);
+
+        while(!m_frontier.empty()){
+            size_type const cur = m_frontier.pop();
+            size_type const row = cur / e.w;
+            long const k = row / e.h, i = row % e.h, j = cur - row * e.w;
+            int const next_distance = distance[cur] + 1;
+
+            auto const relax = [&](long const nk, long const ni, long const nj){
+                if(nk < 0 || nk >= long(e.d) || ni < 0 || ni >= long(e.h) || nj < 0 || nj >= long(e.w)) return;
+                size_type const next = (size_type(nk) * e.h + size_type(ni)) * e.w + size_type(nj);
+                if(m_visited.test(next)) return;
+                m_visited.set(next);
+                if(!passable(nk, ni, nj)) return;
+                distance[next] = next_distance;
+                m_frontier.push(next);
+            };
+            relax(k, i, j - 1);
+            relax(k, i, j + 1);
+            for(int n=0; n<offset_count; ++n){
+                for(int dx=-spread; dx<=spread; ++dx){
+                    relax(k + offsets[n][0], i + offsets[n][1], j + dx);
+                }
+            }
+        }
+    }
+};
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_SEARCH_H
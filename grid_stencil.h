@@ -0,0 +1,381 @@
+/**
+ * @brief Grid2D, Grid3Dに対する近傍演算(ステンシル・畳み込み)
+ * @note 境界の影響を受けない内部はチェックなしのポインタアクセスで処理し、境界の帯だけを境界条件付きで処理する
+ * @note 入出力には行優先のグリッドか、GridView2D, GridView3Dを使える
+*/
+
+#ifndef UTILITY_GRID_STENCIL_H
+#define UTILITY_GRID_STENCIL_H
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "grid2d.h"
+#include "grid3d.h"
+#include "thread_pool.h"
+
+namespace Utility{
+
+/**
+ * @brief 範囲外は最も近い端の要素で補う境界条件
+*/
+struct ClampBoundary{
+    static constexpr bool is_constant = false;
+
+    static long resolve(long const i, long const n){
+        return (i < 0) ? 0 : ((i >= n) ? n - 1 : i);
+    }
+};
+
+/**
+ * @brief 範囲外は反対側から折り返す境界条件
+*/
+struct WrapBoundary{
+    static constexpr bool is_constant = false;
+
+    static long resolve(long const i, long const n){
+        long const r = i % n;
+        return (r < 0) ? r + n : r;
+    }
+};
+
+/**
+ * @brief 範囲外は一定の値とみなす境界条件
+*/
+template <typename value_type>
+struct ConstantBoundary{
+    static constexpr bool is_constant = true;
+
+    value_type value{};
+};
+
+namespace detail{
+
+/**
+ * @brief 内部の要素用の近傍アクセス 範囲チェックを行わない
+ * @tparam UnitStride 列の間隔が1か 1ならdxをそのまま足し、自動ベクトル化されやすくする
+*/
+template <typename T, bool UnitStride>
+struct InteriorNeighborhood{
+    T const * center;
+    ptrdiff_t col_stride;
+    ptrdiff_t row_stride;
+    ptrdiff_t slice_stride;
+
+    T const & operator ()(int const dz, int const dy, int const dx) const {
+        return center[dz * slice_stride + dy * row_stride + (UnitStride ? dx : dx * col_stride)];
+    }
+};
+
+/**
+ * @brief 境界の帯の要素用の近傍アクセス 範囲外は境界条件に従う
+*/
+template <typename T, typename Boundary>
+struct BorderNeighborhood{
+    T const * data;
+    ptrdiff_t col_stride;
+    ptrdiff_t row_stride;
+    ptrdiff_t slice_stride;
+    long w, h, d;
+    long z, y, x;
+    Boundary const * boundary;
+
+    T operator ()(int const dz, int const dy, int const dx) const {
+        long zz = z + dz, yy = y + dy, xx = x + dx;
+        if constexpr(Boundary::is_constant){
+            if(zz < 0 || zz >= d || yy < 0 || yy >= h || xx < 0 || xx >= w){
+                return static_cast<T>(boundary->value);
+            }
+        }else{
+            zz = Boundary::resolve(zz, d);
+            yy = Boundary::resolve(yy, h);
+            xx = Boundary::resolve(xx, w);
+        }
+        return data[zz * slice_stride + yy * row_stride + xx * col_stride];
+    }
+};
+
+/**
+ * @brief 三次元の近傍アクセスを(dy, dx)の二次元として見せる
+*/
+template <typename Neighborhood>
+struct Neighborhood2D{
+    Neighborhood const & n;
+
+    decltype(auto) operator ()(int const dy, int const dx) const {
+        return n(0, dy, dx);
+    }
+};
+
+/**
+ * @brief 格納領域の先頭と各方向の間隔
+*/
+template <typename T>
+struct StencilBuffer{
+    T * data;
+    ptrdiff_t col_stride;
+    ptrdiff_t row_stride;
+    ptrdiff_t slice_stride;
+};
+
+/**
+ * @brief (z, y)を通し番号にした[r_first, r_last)行にステンシルを適用する
+ * @tparam UnitStride 入出力とも列の間隔が1か
+*/
+template <int RX, int RY, int RZ, bool UnitStride, typename T, typename U, typename Kernel, typename Boundary>
+void stencil_rows(StencilBuffer<T const> const & src, StencilBuffer<U> const & dst,
+    long const w, long const h, long const d,
+    size_t const r_first, size_t const r_last,
+    Kernel const & kernel, Boundary const & boundary){
+
+    ptrdiff_t const src_col = UnitStride ? 1 : src.col_stride;
+    ptrdiff_t const dst_col = UnitStride ? 1 : dst.col_stride;
+    for(size_t r=r_first; r<r_last; ++r){
+        long const z = static_cast<long>(r) / h;
+        long const y = static_cast<long>(r) % h;
+        T const * const src_row = src.data + z * src.slice_stride + y * src.row_stride;
+        U * const dst_row = dst.data + z * dst.slice_stride + y * dst.row_stride;
+
+        // 行全体が境界の帯に含まれるか
+        bool const border_row = (y < RY || y >= h - RY || z < RZ || z >= d - RZ);
+        long const x_first = border_row ? w : std::min<long>(RX, w);
+        long const x_last = border_row ? w : std::max<long>(x_first, w - RX);
+
+        BorderNeighborhood<T, Boundary> border{src.data, src.col_stride, src.row_stride, src.slice_stride, w, h, d, z, y, 0, &boundary};
+        for(long x=0; x<x_first; ++x){
+            border.x = x;
+            dst_row[x * dst_col] = kernel(border);
+        }
+        for(long x=x_first; x<x_last; ++x){
+            dst_row[x * dst_col] = kernel(InteriorNeighborhood<T, UnitStride>{src_row + x * src_col, src_col, src.row_stride, src.slice_stride});
+        }
+        for(long x=x_last; x<w; ++x){
+            border.x = x;
+            dst_row[x * dst_col] = kernel(border);
+        }
+    }
+}
+
+/**
+ * @brief 行単位の処理を逐次または並列に実行する
+*/
+template <typename Function>
+void run_rows(size_t const rows, GridExecution const execution, Function const & func){
+    if(execution == GridExecution::Parallel){
+        ThreadPool::global().parallel_for(0, rows, func);
+    }else{
+        func(0, rows);
+    }
+}
+
+/**
+ * @brief 入出力とも列の間隔が1なら、間隔を定数にした版を使う
+*/
+template <int RX, int RY, int RZ, typename T, typename U, typename Kernel, typename Boundary>
+void stencil_run(StencilBuffer<T const> const & src, StencilBuffer<U> const & dst, long const w, long const h, long const d,
+    Kernel const & kernel, Boundary const & boundary, GridExecution const execution){
+
+    bool const unit = (src.col_stride == 1 && dst.col_stride == 1);
+    run_rows(h * d, execution, [&](size_t const first, size_t const last){
+        if(unit){
+            stencil_rows<RX, RY, RZ, true>(src, dst, w, h, d, first, last, kernel, boundary);
+        }else{
+            stencil_rows<RX, RY, RZ, false>(src, dst, w, h, d, first, last, kernel, boundary);
+        }
+    });
+}
+
+/**
+ * @brief グリッドかビューの格納領域の情報
+*/
+template <typename grid_type>
+auto stencil_buffer(grid_type & grid){
+    using layout_type = std::decay_t<decltype(grid.layout())>;
+    static_assert(is_strided_layout<layout_type>::value, "stencil: grids must have a row-major layout (or be a view)");
+    auto const strides = layout_strides(grid.layout());
+    return StencilBuffer<std::remove_pointer_t<decltype(grid.data())>>{grid.data(), strides[0], strides[1], strides[2]};
+}
+
+/**
+ * @brief 入力側の格納領域の情報 書き込み可能なビューも読み込み専用として扱う
+*/
+template <typename grid_type>
+auto stencil_source(grid_type const & grid){
+    auto const buffer = stencil_buffer(grid);
+    using value_type = std::remove_const_t<std::remove_pointer_t<decltype(buffer.data)>>;
+    return StencilBuffer<value_type const>{buffer.data, buffer.col_stride, buffer.row_stride, buffer.slice_stride};
+}
+
+} // namespace detail
+
+/**
+ * @brief 二次元のステンシル演算 dst(y, x) = kernel(n) nは近傍をn(dy, dx)で返す
+ * @tparam RX, RY 近傍の半径(横, 縦) |dx| <= RX, |dy| <= RY の範囲にアクセスできる
+ * @param[in] src 入力 行優先のGrid2DかGridView2D
+ * @param[out] dst 出力 srcと格納領域を共有しないこと Grid2Dは大きさをsrcに合わせ、GridView2Dは同じ大きさであること
+ * @param[in] kernel 近傍アクセスを引数として受け取る関数 内部と境界で異なる型が渡されるのでジェネリックラムダなどを使う
+ * @param[in] boundary 境界条件 ClampBoundary, WrapBoundary, ConstantBoundary
+ * @param[in] execution 行単位で並列に実行するか
+*/
+template <int RX, int RY, typename Src, typename Dst, typename Kernel, typename Boundary = ClampBoundary,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void stencil(Src const & src, Dst && dst, Kernel const & kernel,
+    Boundary const & boundary = Boundary{}, GridExecution const execution = GridExecution::Sequential){
+
+    static_assert(RX >= 0 && RY >= 0, "stencil: radius must not be negative");
+    detail::check_distinct(src, dst);
+    detail::fit_destination(dst, src.width(), src.height(), 1);
+
+    auto const kernel3d = [&kernel](auto const & n){
+        return kernel(detail::Neighborhood2D<std::decay_t<decltype(n)>>{n});
+    };
+    detail::stencil_run<RX, RY, 0>(detail::stencil_source(src), detail::stencil_buffer(dst),
+        src.width(), src.height(), 1, kernel3d, boundary, execution);
+}
+
+/**
+ * @brief 三次元のステンシル演算 dst(z, y, x) = kernel(n) nは近傍をn(dz, dy, dx)で返す
+ * @tparam RX, RY, RZ 近傍の半径(横, 縦, 奥行)
+ * @param[in] src 入力 行優先のGrid3DかGridView3D
+ * @param[out] dst 出力 srcと格納領域を共有しないこと Grid3Dは大きさをsrcに合わせ、GridView3Dは同じ大きさであること
+ * @param[in] kernel 近傍アクセスを引数として受け取る関数
+ * @param[in] boundary 境界条件 ClampBoundary, WrapBoundary, ConstantBoundary
+ * @param[in] execution (z, y)の行単位で並列に実行するか
+*/
+template <int RX, int RY, int RZ, typename Src, typename Dst, typename Kernel, typename Boundary = ClampBoundary,
+    std::enable_if_t<detail::is_grid3d<Src>::value && detail::is_grid3d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void stencil(Src const & src, Dst && dst, Kernel const & kernel,
+    Boundary const & boundary = Boundary{}, GridExecution const execution = GridExecution::Sequential){
+
+    static_assert(RX >= 0 && RY >= 0 && RZ >= 0, "stencil: radius must not be negative");
+    detail::check_distinct(src, dst);
+    detail::fit_destination(dst, src.width(), src.height(), src.depth());
+
+    detail::stencil_run<RX, RY, RZ>(detail::stencil_source(src), detail::stencil_buffer(dst),
+        src.width(), src.height(), src.depth(), kernel, boundary, execution);
+}
+
+/**
+ * @brief 重み付きの二次元畳み込み
+ * @param[in] weights (2RY+1)x(2RX+1)の重み 行優先で、weights[0]が(dy, dx) = (-RY, -RX)
+*/
+template <int RX, int RY, typename Src, typename Dst, typename W, typename Boundary = ClampBoundary,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void convolve(Src const & src, Dst && dst, std::array<W, (2 * RX + 1) * (2 * RY + 1)> const & weights,
+    Boundary const & boundary = Boundary{}, GridExecution const execution = GridExecution::Sequential){
+
+    stencil<RX, RY>(src, std::forward<Dst>(dst), [&weights](auto const & n){
+        W sum{};
+        for(int dy=-RY; dy<=RY; ++dy){
+            for(int dx=-RX; dx<=RX; ++dx){
+                sum += weights[(dy + RY) * (2 * RX + 1) + (dx + RX)] * n(dy, dx);
+            }
+        }
+        return sum;
+    }, boundary, execution);
+}
+
+namespace detail{
+
+/**
+ * @brief 一軸分の畳み込み カーネルは軸方向(axis: 0=x, 1=y, 2=z)の1次元
+*/
+template <int R, int Axis, typename T, typename U, typename W, typename Boundary>
+void convolve_axis(StencilBuffer<T const> const & src, StencilBuffer<U> const & dst, long const w, long const h, long const d,
+    std::array<W, 2 * R + 1> const & k, Boundary const & boundary, GridExecution const execution){
+
+    auto const kernel = [&k](auto const & n){
+        W sum{};
+        for(int i=-R; i<=R; ++i){
+            if constexpr(Axis == 0){
+                sum += k[i + R] * n(0, 0, i);
+            }else if constexpr(Axis == 1){
+                sum += k[i + R] * n(0, i, 0);
+            }else{
+                sum += k[i + R] * n(i, 0, 0);
+            }
+        }
+        return sum;
+    };
+    stencil_run<(Axis == 0 ? R : 0), (Axis == 1 ? R : 0), (Axis == 2 ? R : 0)>(src, dst, w, h, d, kernel, boundary, execution);
+}
+
+/**
+ * @brief 分離可能な畳み込みの中間結果での境界条件
+ * @note 一定値の境界は、それまでの軸の重みの和を掛けた値になる
+*/
+template <typename Boundary, typename W>
+Boundary scaled_boundary(Boundary const & boundary, W const){
+    return boundary;
+}
+
+template <typename V, typename W>
+ConstantBoundary<W> scaled_boundary(ConstantBoundary<V> const & boundary, W const scale){
+    return ConstantBoundary<W>{static_cast<W>(boundary.value) * scale};
+}
+
+template <typename W, size_t N>
+W weight_sum(std::array<W, N> const & k){
+    W sum{};
+    for(auto const & v : k) sum += v;
+    return sum;
+}
+
+} // namespace detail
+
+/**
+ * @brief 分離可能な二次元畳み込み 横方向、縦方向の順に1次元の畳み込みを行う
+ * @param[in] kx 横方向の重み(2R+1個)
+ * @param[in] ky 縦方向の重み(2R+1個)
+ * @note (2R+1)^2回の積和が2(2R+1)回になる 中間結果はW型で保持する
+*/
+template <int R, typename Src, typename Dst, typename W, typename Boundary = ClampBoundary,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void convolve_separable(Src const & src, Dst && dst,
+    std::array<W, 2 * R + 1> const & kx, std::array<W, 2 * R + 1> const & ky,
+    Boundary const & boundary = Boundary{}, GridExecution const execution = GridExecution::Sequential){
+
+    detail::check_distinct(src, dst);
+    detail::fit_destination(dst, src.width(), src.height(), 1);
+
+    long const w = src.width(), h = src.height();
+    std::vector<W> tmp(w * h);
+    detail::convolve_axis<R, 0>(detail::stencil_source(src), detail::StencilBuffer<W>{tmp.data(), 1, w, 0}, w, h, 1, kx, boundary, execution);
+    detail::convolve_axis<R, 1>(detail::StencilBuffer<W const>{tmp.data(), 1, w, 0}, detail::stencil_buffer(dst), w, h, 1,
+        ky, detail::scaled_boundary(boundary, detail::weight_sum(kx)), execution);
+}
+
+/**
+ * @brief 分離可能な三次元畳み込み 横方向、縦方向、奥行方向の順に1次元の畳み込みを行う
+ * @param[in] kx 横方向の重み(2R+1個)
+ * @param[in] ky 縦方向の重み(2R+1個)
+ * @param[in] kz 奥行方向の重み(2R+1個)
+*/
+template <int R, typename Src, typename Dst, typename W, typename Boundary = ClampBoundary,
+    std::enable_if_t<detail::is_grid3d<Src>::value && detail::is_grid3d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void convolve_separable(Src const & src, Dst && dst,
+    std::array<W, 2 * R + 1> const & kx, std::array<W, 2 * R + 1> const & ky, std::array<W, 2 * R + 1> const & kz,
+    Boundary const & boundary = Boundary{}, GridExecution const execution = GridExecution::Sequential){
+
+    detail::check_distinct(src, dst);
+    detail::fit_destination(dst, src.width(), src.height(), src.depth());
+
+    long const w = src.width(), h = src.height(), d = src.depth();
+    std::vector<W> tmp0(w * h * d), tmp1(w * h * d);
+    W const sx = detail::weight_sum(kx);
+    W const sxy = sx * detail::weight_sum(ky);
+    detail::convolve_axis<R, 0>(detail::stencil_source(src), detail::StencilBuffer<W>{tmp0.data(), 1, w, w * h},
+        w, h, d, kx, boundary, execution);
+    detail::convolve_axis<R, 1>(detail::StencilBuffer<W const>{tmp0.data(), 1, w, w * h}, detail::StencilBuffer<W>{tmp1.data(), 1, w, w * h},
+        w, h, d, ky, detail::scaled_boundary(boundary, sx), execution);
+    detail::convolve_axis<R, 2>(detail::StencilBuffer<W const>{tmp1.data(), 1, w, w * h}, detail::stencil_buffer(dst),
+        w, h, d, kz, detail::scaled_boundary(boundary, sxy), execution);
+}
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_STENCIL_H
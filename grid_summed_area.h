@@ -0,0 +1,369 @@
+/**
+ * @brief Grid2D, Grid3Dの累積和テーブル(summed-area table)
+ * @note 構築は一度の走査で行い、任意の矩形・直方体の和と平均をO(1)で求める
+*/
+
+#ifndef UTILITY_GRID_SUMMED_AREA_H
+#define UTILITY_GRID_SUMMED_AREA_H
+
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "grid2d.h"
+#include "grid3d.h"
+
+namespace Utility{
+
+namespace detail{
+
+/**
+ * @brief 累積和に使う型 整数はlong long、浮動小数点数はdouble
+*/
+template <typename T, typename = void>
+struct default_sum_type{
+    using type = T;
+};
+template <typename T>
+struct default_sum_type<T, std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value>>{
+    using type = long long;
+};
+template <typename T>
+struct default_sum_type<T, std::enable_if_t<std::is_integral<T>::value && std::is_unsigned<T>::value>>{
+    using type = unsigned long long;
+};
+template <typename T>
+struct default_sum_type<T, std::enable_if_t<std::is_floating_point<T>::value>>{
+    using type = double;
+};
+
+template <typename T>
+using default_sum_type_t = typename default_sum_type<T>::type;
+
+} // namespace detail
+
+/**
+ * @brief 二次元の累積和テーブル
+ * @note 範囲は[first, last)の半開区間で指定する
+ * @note 先頭に0の行と列を持つため、問い合わせに分岐がない
+*/
+template <typename sum_type>
+class SummedAreaTable2D{
+public:
+    using size_type = size_t;
+
+private:
+    std::vector<sum_type> m_table; // [(y + 1) * m_stride + (x + 1)]が[0, y]x[0, x]の和
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_stride = 1;
+
+public:
+    SummedAreaTable2D() = default;
+
+    /**
+     * @brief グリッドから構築
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    explicit SummedAreaTable2D(grid_type const & grid){
+        build(grid);
+    }
+
+    /**
+     * @brief グリッドから作り直す
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    void build(grid_type const & grid){
+        m_width = grid.width();
+        m_height = grid.height();
+        m_stride = m_width + 1;
+        m_table.assign(m_stride * (m_height + 1), sum_type{});
+        rebuild(grid, 0, 0);
+    }
+
+    /**
+     * @brief (y, x)以降の要素が変わった後、影響を受ける部分だけを作り直す
+     * @param[in] grid 構築元と同じ大きさのグリッド
+     * @param[in] y, x 変更された要素のうち最も左上の位置 変更が複数ある場合は、それぞれのy, xの最小値
+     * @note [y, height)x[x, width)の範囲だけを計算し直す y == height, x == widthでは何もしない
+     * @note y > height, x > widthではstd::out_of_rangeを投げる
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    void rebuild(grid_type const & grid, size_type const y, size_type const x){
+        if(grid.width() != m_width || grid.height() != m_height){
+            throw std::invalid_argument("SummedAreaTable2D: grid size does not match the table");
+        }
+        if(y > m_height || x > m_width){
+            throw std::out_of_range("SummedAreaTable2D: position out of range");
+        }
+        auto const * const data = grid.data();
+        auto const & layout = grid.layout();
+        ptrdiff_t const left = static_cast<ptrdiff_t>(x) - 1;
+        for(size_type i=y; i<m_height; ++i){
+            sum_type * const row = m_table.data() + (i + 1) * m_stride + 1;
+            sum_type const * const above = row - m_stride;
+            // 左の列までの行内の和 x == 0では番兵の列を参照する
+            sum_type line = row[left] - above[left];
+            for(size_type j=x; j<m_width; ++j){
+                line += static_cast<sum_type>(data[layout.index(i, j)]);
+                row[j] = above[j] + line;
+            }
+        }
+    }
+
+    /**
+     * @brief 要素(y, x)にdeltaを加えたことを反映する
+     * @note 浮動小数点数では誤差が蓄積するため、多くの更新の後はrebuild()を使う
+    */
+    void add(size_type const y, size_type const x, sum_type const & delta){
+        if(y >= m_height || x >= m_width){
+            throw std::out_of_range("SummedAreaTable2D: position out of range");
+        }
+        for(size_type i=y+1; i<=m_height; ++i){
+            sum_type * const row = m_table.data() + i * m_stride;
+            for(size_type j=x+1; j<=m_width; ++j){
+                row[j] += delta;
+            }
+        }
+    }
+
+    /**
+     * @brief [y_first, y_last)x[x_first, x_last)の和
+    */
+    sum_type sum(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last) const {
+        check_range(y_first, x_first, y_last, x_last);
+        sum_type const * const t = m_table.data();
+        return t[y_last * m_stride + x_last] - t[y_first * m_stride + x_last]
+            - t[y_last * m_stride + x_first] + t[y_first * m_stride + x_first];
+    }
+
+    /**
+     * @brief [y_first, y_last)x[x_first, x_last)の平均 空の範囲ではstd::invalid_argumentを投げる
+    */
+    double mean(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last) const {
+        sum_type const s = sum(y_first, x_first, y_last, x_last);
+        size_type const n = (y_last - y_first) * (x_last - x_first);
+        if(n == 0) throw std::invalid_argument("SummedAreaTable2D: mean of an empty range");
+        return static_cast<double>(s) / static_cast<double>(n);
+    }
+
+    /**
+     * @brief 全体の和
+    */
+    sum_type total() const {
+        return m_table.back();
+    }
+
+    size_type width() const {
+        return m_width;
+    }
+
+    size_type height() const {
+        return m_height;
+    }
+
+#ifdef UTILITY_POINT2I_H
+
+    // point2i.hがincludeされている場合
+
+    /**
+     * @brief (x, y)のPoint2iで指定した[first, last)の和
+    */
+    sum_type sum(Point2i const & first, Point2i const & last) const {
+        check_point(first);
+        check_point(last);
+        return sum(first.y, first.x, last.y, last.x);
+    }
+
+    /**
+     * @brief (x, y)のPoint2iで指定した[first, last)の平均
+    */
+    double mean(Point2i const & first, Point2i const & last) const {
+        check_point(first);
+        check_point(last);
+        return mean(first.y, first.x, last.y, last.x);
+    }
+
+    /**
+     * @brief (x, y)のPoint2iの要素が変わった後、影響を受ける部分だけを作り直す
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    void rebuild(grid_type const & grid, Point2i const & pos){
+        check_point(pos);
+        rebuild(grid, pos.y, pos.x);
+    }
+
+#endif // ifdef UTILITY_POINT2I_H
+
+private:
+    void check_range(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last) const {
+        if(y_first > y_last || x_first > x_last || y_last > m_height || x_last > m_width){
+            throw std::out_of_range("SummedAreaTable2D: range out of range");
+        }
+    }
+
+#ifdef UTILITY_POINT2I_H
+    static void check_point(Point2i const & pos){
+        if(pos.x < 0 || pos.y < 0){
+            throw std::out_of_range("SummedAreaTable2D: range out of range");
+        }
+    }
+#endif // ifdef UTILITY_POINT2I_H
+};
+
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+SummedAreaTable2D(Grid2D<data_type, layout_type, allocator_type, bounds_policy> const &) -> SummedAreaTable2D<detail::default_sum_type_t<data_type>>;
+template <typename data_type>
+SummedAreaTable2D(GridView2D<data_type> const &) -> SummedAreaTable2D<detail::default_sum_type_t<std::remove_const_t<data_type>>>;
+
+/**
+ * @brief 三次元の累積和テーブル
+ * @note 範囲は[first, last)の半開区間で指定する
+*/
+template <typename sum_type>
+class SummedAreaTable3D{
+public:
+    using size_type = size_t;
+
+private:
+    std::vector<sum_type> m_table; // [(z + 1) * m_slice + (y + 1) * m_stride + (x + 1)]が[0, z]x[0, y]x[0, x]の和
+    size_type m_width = 0;
+    size_type m_height = 0;
+    size_type m_depth = 0;
+    size_type m_stride = 1;
+    size_type m_slice = 1;
+
+public:
+    SummedAreaTable3D() = default;
+
+    /**
+     * @brief グリッドから構築
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+    explicit SummedAreaTable3D(grid_type const & grid){
+        build(grid);
+    }
+
+    /**
+     * @brief グリッドから作り直す
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+    void build(grid_type const & grid){
+        m_width = grid.width();
+        m_height = grid.height();
+        m_depth = grid.depth();
+        m_stride = m_width + 1;
+        m_slice = m_stride * (m_height + 1);
+        m_table.assign(m_slice * (m_depth + 1), sum_type{});
+        rebuild(grid, 0, 0, 0);
+    }
+
+    /**
+     * @brief (z, y, x)以降の要素が変わった後、影響を受ける部分だけを作り直す
+     * @param[in] z, y, x 変更された要素のうち最も手前左上の位置 変更が複数ある場合は、それぞれの最小値
+     * @note [z, depth)x[y, height)x[x, width)の範囲だけを計算し直す z == depth, y == height, x == widthでは何もしない
+     * @note z > depth, y > height, x > widthではstd::out_of_rangeを投げる
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+    void rebuild(grid_type const & grid, size_type const z, size_type const y, size_type const x){
+        if(grid.width() != m_width || grid.height() != m_height || grid.depth() != m_depth){
+            throw std::invalid_argument("SummedAreaTable3D: grid size does not match the table");
+        }
+        if(z > m_depth || y > m_height || x > m_width){
+            throw std::out_of_range("SummedAreaTable3D: position out of range");
+        }
+        auto const * const data = grid.data();
+        auto const & layout = grid.layout();
+        ptrdiff_t const left = static_cast<ptrdiff_t>(x) - 1;
+        for(size_type k=z; k<m_depth; ++k){
+            for(size_type i=y; i<m_height; ++i){
+                sum_type * const row = m_table.data() + (k + 1) * m_slice + (i + 1) * m_stride + 1;
+                sum_type const * const above = row - m_stride;
+                sum_type const * const front = row - m_slice;
+                sum_type const * const front_above = front - m_stride;
+                // 同じスライス・同じ行の、左の列までの行内の和(行方向の一次元の累積和) 上の行と手前のスライスの値を足して三次元の累積和にする
+                sum_type plane = row[left] - front[left] - above[left] + front_above[left];
+                for(size_type j=x; j<m_width; ++j){
+                    plane += static_cast<sum_type>(data[layout.index(k, i, j)]);
+                    row[j] = above[j] + front[j] - front_above[j] + plane;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 要素(z, y, x)にdeltaを加えたことを反映する
+    */
+    void add(size_type const z, size_type const y, size_type const x, sum_type const & delta){
+        if(z >= m_depth || y >= m_height || x >= m_width){
+            throw std::out_of_range("SummedAreaTable3D: position out of range");
+        }
+        for(size_type k=z+1; k<=m_depth; ++k){
+            for(size_type i=y+1; i<=m_height; ++i){
+                sum_type * const row = m_table.data() + k * m_slice + i * m_stride;
+                for(size_type j=x+1; j<=m_width; ++j){
+                    row[j] += delta;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief [z_first, z_last)x[y_first, y_last)x[x_first, x_last)の和
+    */
+    sum_type sum(size_type const z_first, size_type const y_first, size_type const x_first,
+        size_type const z_last, size_type const y_last, size_type const x_last) const {
+
+        if(z_first > z_last || y_first > y_last || x_first > x_last || z_last > m_depth || y_last > m_height || x_last > m_width){
+            throw std::out_of_range("SummedAreaTable3D: range out of range");
+        }
+        auto const t = [this](size_type const z, size_type const y, size_type const x){
+            return m_table[z * m_slice + y * m_stride + x];
+        };
+        return t(z_last, y_last, x_last)
+            - t(z_first, y_last, x_last) - t(z_last, y_first, x_last) - t(z_last, y_last, x_first)
+            + t(z_first, y_first, x_last) + t(z_first, y_last, x_first) + t(z_last, y_first, x_first)
+            - t(z_first, y_first, x_first);
+    }
+
+    /**
+     * @brief [z_first, z_last)x[y_first, y_last)x[x_first, x_last)の平均 空の範囲ではstd::invalid_argumentを投げる
+    */
+    double mean(size_type const z_first, size_type const y_first, size_type const x_first,
+        size_type const z_last, size_type const y_last, size_type const x_last) const {
+
+        sum_type const s = sum(z_first, y_first, x_first, z_last, y_last, x_last);
+        size_type const n = (z_last - z_first) * (y_last - y_first) * (x_last - x_first);
+        if(n == 0) throw std::invalid_argument("SummedAreaTable3D: mean of an empty range");
+        return static_cast<double>(s) / static_cast<double>(n);
+    }
+
+    /**
+     * @brief 全体の和
+    */
+    sum_type total() const {
+        return m_table.back();
+    }
+
+    size_type width() const {
+        return m_width;
+    }
+
+    size_type height() const {
+        return m_height;
+    }
+
+    size_type depth() const {
+        return m_depth;
+    }
+};
+
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+SummedAreaTable3D(Grid3D<data_type, layout_type, allocator_type, bounds_policy> const &) -> SummedAreaTable3D<detail::default_sum_type_t<data_type>>;
+template <typename data_type>
+SummedAreaTable3D(GridView3D<data_type> const &) -> SummedAreaTable3D<detail::default_sum_type_t<std::remove_const_t<data_type>>>;
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_SUMMED_AREA_H
@@ -0,0 +1,428 @@
+/**
+ * @brief Grid2D, Grid3Dのテキスト形式での書き出しと読み込み
+ * @note 一つのバッファにstd::to_charsで書き込んでまとめて出力し、読み込みはstd::from_charsで解析する
+ * @note 形式は1行目に"width height"(三次元は"width height depth")、以降に各行の要素を空白区切りで並べる
+*/
+
+#ifndef UTILITY_GRID_TEXT_H
+#define UTILITY_GRID_TEXT_H
+
+#include <iostream>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include "grid2d.h"
+#include "grid3d.h"
+
+namespace Utility{
+
+namespace detail{
+
+/**
+ * @brief 一要素の書き込み 算術型はstd::to_chars、それ以外は実引数依存の名前探索で見つかるto_charsを使う
+*/
+template <typename T>
+std::to_chars_result grid_to_chars(char * first, char * last, T const & value){
+    if constexpr(std::is_same<T, bool>::value){
+        if(first == last) return {last, std::errc::value_too_large};
+        *first = value ? '1' : '0';
+        return {first + 1, std::errc()};
+    }else if constexpr(std::is_arithmetic<T>::value){
+        return std::to_chars(first, last, value);
+    }else{
+        return to_chars(first, last, value);
+    }
+}
+
+/**
+ * @brief 一要素の読み込み 算術型はstd::from_chars、それ以外は実引数依存の名前探索で見つかるfrom_charsを使う
+*/
+template <typename T>
+std::from_chars_result grid_from_chars(char const * first, char const * last, T & value){
+    if constexpr(std::is_same<T, bool>::value){
+        int v = 0;
+        auto const result = std::from_chars(first, last, v);
+        if(result.ec == std::errc()) value = (v != 0);
+        return result;
+    }else if constexpr(std::is_arithmetic<T>::value){
+        return std::from_chars(first, last, value);
+    }else{
+        return from_chars(first, last, value);
+    }
+}
+
+/**
+ * @brief 固定長のバッファに書き込み、一杯になったらsinkへ渡す
+ * @tparam Sink (char const *, size_t)を引数として受け取る関数
+*/
+template <typename Sink>
+class GridTextWriter{
+public:
+    static constexpr size_t buffer_size = 1 << 16;
+    static constexpr size_t max_token = 128; // 一要素の最大の文字数の目安
+
+private:
+    std::vector<char> m_buffer;
+    char * m_pos;
+    Sink & m_sink;
+
+public:
+    explicit GridTextWriter(Sink & sink)
+        : m_buffer(buffer_size),
+        m_pos(m_buffer.data()),
+        m_sink(sink){}
+
+    template <typename T>
+    void write(T const & value){
+        if(end() - m_pos < static_cast<ptrdiff_t>(max_token)) flush();
+        auto result = grid_to_chars(m_pos, end(), value);
+        if(result.ec != std::errc()){
+            // 長い要素はバッファを空にしてからもう一度
+            flush();
+            result = grid_to_chars(m_pos, end(), value);
+            if(result.ec != std::errc()){
+                throw std::runtime_error("grid text: value does not fit in the buffer");
+            }
+        }
+        m_pos = result.ptr;
+    }
+
+    void put(char const c){
+        if(m_pos == end()) flush();
+        *m_pos++ = c;
+    }
+
+    void flush(){
+        if(m_pos != m_buffer.data()) m_sink(m_buffer.data(), static_cast<size_t>(m_pos - m_buffer.data()));
+        m_pos = m_buffer.data();
+    }
+
+private:
+    char * end(){
+        return m_buffer.data() + m_buffer.size();
+    }
+};
+
+/**
+ * @brief sourceから固定長のバッファへ読み込みながら、空白で区切られた値を解析する
+ * @tparam Source (char *, size_t)を引数として受け取り、読み込んだバイト数を返す関数 終端では0を返す
+ * @note sourceは一度に読めるだけ(バッファ済みの分か1行)を返せばよい 行の途中で切れていれば続きを読み込む
+ * @note 読み込んだが解析していない部分はunread()で取り出し、読み込み元へ戻す
+*/
+template <typename Source>
+class GridTextReader{
+public:
+    static constexpr size_t buffer_size = 1 << 16;
+    static constexpr size_t max_token = 128;
+
+private:
+    std::vector<char> m_buffer;
+    char const * m_pos = nullptr;
+    char const * m_end = nullptr;
+    bool m_eof = false;
+    Source * m_source = nullptr;
+
+public:
+    /**
+     * @brief sourceから読み込む
+    */
+    explicit GridTextReader(Source & source)
+        : m_buffer(buffer_size),
+        m_pos(m_buffer.data()),
+        m_end(m_buffer.data()),
+        m_source(&source){}
+
+    /**
+     * @brief メモリ上の[first, last)を読み込む バッファは確保しない
+    */
+    GridTextReader(char const * first, char const * last)
+        : m_pos(first),
+        m_end(last),
+        m_eof(true){}
+
+    template <typename T>
+    void read(T & value){
+        skip_space();
+        if(static_cast<size_t>(m_end - m_pos) < max_token) fill_token();
+        if(m_pos == m_end){
+            throw std::runtime_error("grid text: unexpected end of input");
+        }
+        auto const result = grid_from_chars(m_pos, m_end, value);
+        if(result.ec != std::errc()){
+            throw std::runtime_error("grid text: parse error");
+        }
+        m_pos = result.ptr;
+    }
+
+    /**
+     * @brief 読み込んだが解析していない部分
+    */
+    std::string_view unread() const {
+        return std::string_view(m_pos, static_cast<size_t>(m_end - m_pos));
+    }
+
+private:
+    static bool is_space(char const c){
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+    }
+
+    void skip_space(){
+        for(;;){
+            while(m_pos != m_end && is_space(*m_pos)) ++m_pos;
+            if(m_pos != m_end || m_eof) return;
+            refill();
+        }
+    }
+
+    /**
+     * @brief 行末か、max_tokenバイトまで読み込む 値の途中で解析を始めないように
+     * @note 値は行をまたがない(Point2iのように空白を含む値もある)
+    */
+    void fill_token(){
+        while(!m_eof && static_cast<size_t>(m_end - m_pos) < max_token && std::find(m_pos, m_end, '\n') == m_end){
+            refill();
+        }
+    }
+
+    /**
+     * @brief 未解析の部分をバッファの先頭へ寄せて、sourceから一度だけ読み込む
+    */
+    void refill(){
+        if(m_eof) return;
+        size_t const rest = static_cast<size_t>(m_end - m_pos);
+        if(rest == m_buffer.size()) return; // 値がバッファより長い 解析で失敗させる
+        std::memmove(m_buffer.data(), m_pos, rest);
+        size_t const n = (*m_source)(m_buffer.data() + rest, m_buffer.size() - rest);
+        if(n == 0) m_eof = true;
+        m_pos = m_buffer.data();
+        m_end = m_buffer.data() + rest + n;
+    }
+};
+
+template <typename Writer, typename grid_type, std::enable_if_t<is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+void write_grid_text(Writer & writer, grid_type const & grid){
+    UTILITY_GRID_TRACE_SPAN("write_text", grid.width(), grid.height());
+    writer.write(grid.width());
+    writer.put(' ');
+    writer.write(grid.height());
+    writer.put('\n');
+    for(size_t i=0; i<grid.height(); ++i){
+        for(size_t j=0; j<grid.width(); ++j){
+            if(j != 0) writer.put(' ');
+            writer.write(grid.data()[grid.layout().index(i, j)]);
+        }
+        writer.put('\n');
+    }
+}
+
+template <typename Writer, typename grid_type, std::enable_if_t<is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+void write_grid_text(Writer & writer, grid_type const & grid){
+    UTILITY_GRID_TRACE_SPAN("write_text", grid.width(), grid.height(), grid.depth());
+    writer.write(grid.width());
+    writer.put(' ');
+    writer.write(grid.height());
+    writer.put(' ');
+    writer.write(grid.depth());
+    writer.put('\n');
+    for(size_t k=0; k<grid.depth(); ++k){
+        if(k != 0) writer.put('\n');
+        for(size_t i=0; i<grid.height(); ++i){
+            for(size_t j=0; j<grid.width(); ++j){
+                if(j != 0) writer.put(' ');
+                writer.write(grid.data()[grid.layout().index(k, i, j)]);
+            }
+            writer.put('\n');
+        }
+    }
+}
+
+/**
+ * @brief 読み込む大きさに合わせる 配列は作り直し、ビューは大きさが異なればstd::runtime_errorを投げる
+*/
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+void fit_text_size(Grid2D<data_type, layout_type, allocator_type, bounds_policy> & grid, size_t const w, size_t const h){
+    if(grid.width() != w || grid.height() != h){
+        grid = Grid2D<data_type, layout_type, allocator_type, bounds_policy>(w, h, grid.get_allocator());
+    }
+}
+
+template <typename data_type>
+void fit_text_size(GridView2D<data_type> const & grid, size_t const w, size_t const h){
+    if(grid.width() != w || grid.height() != h){
+        throw std::runtime_error("grid text: size mismatch for GridView2D");
+    }
+}
+
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+void fit_text_size(Grid3D<data_type, layout_type, allocator_type, bounds_policy> & grid, size_t const w, size_t const h, size_t const d){
+    if(grid.width() != w || grid.height() != h || grid.depth() != d){
+        grid = Grid3D<data_type, layout_type, allocator_type, bounds_policy>(w, h, d, grid.get_allocator());
+    }
+}
+
+template <typename data_type>
+void fit_text_size(GridView3D<data_type> const & grid, size_t const w, size_t const h, size_t const d){
+    if(grid.width() != w || grid.height() != h || grid.depth() != d){
+        throw std::runtime_error("grid text: size mismatch for GridView3D");
+    }
+}
+
+template <typename Reader, typename grid_type, std::enable_if_t<is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+void read_grid_text(Reader & reader, grid_type & grid){
+    size_t w = 0, h = 0;
+    reader.read(w);
+    reader.read(h);
+    UTILITY_GRID_TRACE_SPAN("read_text", w, h);
+    fit_text_size(grid, w, h);
+    for(size_t i=0; i<h; ++i){
+        for(size_t j=0; j<w; ++j){
+            reader.read(grid.data()[grid.layout().index(i, j)]);
+        }
+    }
+}
+
+template <typename Reader, typename grid_type, std::enable_if_t<is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+void read_grid_text(Reader & reader, grid_type & grid){
+    size_t w = 0, h = 0, d = 0;
+    reader.read(w);
+    reader.read(h);
+    reader.read(d);
+    UTILITY_GRID_TRACE_SPAN("read_text", w, h, d);
+    fit_text_size(grid, w, h, d);
+    for(size_t k=0; k<d; ++k){
+        for(size_t i=0; i<h; ++i){
+            for(size_t j=0; j<w; ++j){
+                reader.read(grid.data()[grid.layout().index(k, i, j)]);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief テキスト形式でストリームへ書き出す
+ * @note 要素はstd::to_charsで変換する 算術型以外の要素はto_chars(char *, char *, T const &)が定義されていること
+*/
+template <typename grid_type, std::enable_if_t<detail::is_grid_container<grid_type>::value, std::nullptr_t> = nullptr>
+void write_text(std::ostream & os, grid_type const & grid){
+    auto sink = [&os](char const * data, size_t const n){ os.write(data, n); };
+    detail::GridTextWriter<decltype(sink)> writer(sink);
+    detail::write_grid_text(writer, grid);
+    writer.flush();
+}
+
+/**
+ * @brief テキスト形式でFILEへ書き出す
+*/
+template <typename grid_type, std::enable_if_t<detail::is_grid_container<grid_type>::value, std::nullptr_t> = nullptr>
+void write_text(std::FILE * file, grid_type const & grid){
+    auto sink = [file](char const * data, size_t const n){
+        if(std::fwrite(data, 1, n, file) != n) throw std::runtime_error("grid text: failed to write");
+    };
+    detail::GridTextWriter<decltype(sink)> writer(sink);
+    detail::write_grid_text(writer, grid);
+    writer.flush();
+}
+
+/**
+ * @brief テキスト形式で文字列の末尾へ書き足す
+*/
+template <typename grid_type, std::enable_if_t<detail::is_grid_container<grid_type>::value, std::nullptr_t> = nullptr>
+void write_text(std::string & buffer, grid_type const & grid){
+    auto sink = [&buffer](char const * data, size_t const n){ buffer.append(data, n); };
+    detail::GridTextWriter<decltype(sink)> writer(sink);
+    detail::write_grid_text(writer, grid);
+    writer.flush();
+}
+
+/**
+ * @brief テキスト形式をストリームから読み込む 大きさが異なる場合はファイルに合わせる
+ * @note GridView2D, GridView3Dへ読み込む場合は大きさが一致している必要があり、異なればstd::runtime_errorを投げる
+ * @note 解析に失敗した場合はstd::runtime_errorを投げる その時点でgridは途中まで書き換えられている
+ * @note operator>>と同じく、最後の要素の直後までしか消費しない 続くデータ(次のグリッドなど)はそのまま読める
+ * @note ストリームのバッファにある分だけをまとめて読み、無ければ1行ずつ読む 対話的な入力でも行ごとに解析する
+*/
+template <typename grid_type, std::enable_if_t<detail::is_grid_container<std::decay_t<grid_type>>::value, std::nullptr_t> = nullptr>
+void read_text(std::istream & is, grid_type && grid){
+    std::istream::sentry const sentry(is, true);
+    if(!sentry){
+        throw std::runtime_error("grid text: unexpected end of input");
+    }
+    std::streambuf * const buf = is.rdbuf();
+    auto source = [&is, buf](char * data, size_t const n) -> size_t {
+        size_t count = 0;
+        while(count < n){
+            std::streamsize const avail = buf->in_avail();
+            if(avail > 0){
+                size_t const m = std::min(n - count, static_cast<size_t>(avail));
+                return count + static_cast<size_t>(buf->sgetn(data + count, static_cast<std::streamsize>(m)));
+            }
+            std::istream::int_type const c = buf->sbumpc();
+            if(std::istream::traits_type::eq_int_type(c, std::istream::traits_type::eof())){
+                is.setstate(std::ios::eofbit);
+                break;
+            }
+            data[count++] = std::istream::traits_type::to_char_type(c);
+            if(data[count - 1] == '\n') break;
+        }
+        return count;
+    };
+    detail::GridTextReader<decltype(source)> reader(source);
+    detail::read_grid_text(reader, grid);
+    // 読みすぎた部分を戻す バッファに残っていなければseekで戻す
+    std::string_view const rest = reader.unread();
+    for(size_t i=rest.size(); i>0; --i){
+        if(std::istream::traits_type::eq_int_type(buf->sputbackc(rest[i-1]), std::istream::traits_type::eof())){
+            if(buf->pubseekoff(-static_cast<std::streamoff>(i), std::ios::cur, std::ios::in) == std::streampos(-1)){
+                is.setstate(std::ios::failbit);
+            }
+            break;
+        }
+    }
+    if(!rest.empty()) is.clear(is.rdstate() & ~std::ios::eofbit);
+}
+
+/**
+ * @brief テキスト形式をFILEから読み込む
+ * @note 1行ずつ読み、最後の要素の直後までしか消費しない
+*/
+template <typename grid_type, std::enable_if_t<detail::is_grid_container<std::decay_t<grid_type>>::value, std::nullptr_t> = nullptr>
+void read_text(std::FILE * file, grid_type && grid){
+    auto source = [file](char * data, size_t const n) -> size_t {
+        if(n < 2 || std::fgets(data, static_cast<int>(std::min(n, size_t(1) << 30)), file) == nullptr) return 0;
+        return std::strlen(data);
+    };
+    detail::GridTextReader<decltype(source)> reader(source);
+    detail::read_grid_text(reader, grid);
+    // 読みすぎた部分を戻す seekできなければungetcで戻す
+    std::string_view const rest = reader.unread();
+    if(!rest.empty() && std::fseek(file, -static_cast<long>(rest.size()), SEEK_CUR) != 0){
+        for(size_t i=rest.size(); i>0; --i){
+            if(std::ungetc(static_cast<unsigned char>(rest[i-1]), file) == EOF) break;
+        }
+    }
+}
+
+/**
+ * @brief メモリ上のテキスト形式を読み込む
+*/
+template <typename grid_type, std::enable_if_t<detail::is_grid_container<std::decay_t<grid_type>>::value, std::nullptr_t> = nullptr>
+void read_text(std::string_view const text, grid_type && grid){
+    using source_type = size_t (*)(char *, size_t);
+    detail::GridTextReader<source_type> reader(text.data(), text.data() + text.size());
+    detail::read_grid_text(reader, grid);
+}
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_TEXT_H
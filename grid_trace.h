@@ -0,0 +1,259 @@
+/**
+ * @brief Grid2D, Grid3Dの重い操作の所要時間の記録と、Chrome trace形式(Perfettoで開ける)のJSONへの書き出し
+ * @note UTILITY_GRID_TRACEを定義した場合のみ記録する 未定義では記録の箇所が全て消える
+ * @note 記録はスレッドごとのリングバッファへロックせずに書き込む 溢れた場合は古いものから上書きする
+ * @note 対象はresize、各軸の挿入・削除、apply_edits、foreach、print、テキストとバイナリの入出力
+*/
+
+#ifndef UTILITY_GRID_TRACE_H
+#define UTILITY_GRID_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef UTILITY_GRID_TRACE_CAPACITY
+#define UTILITY_GRID_TRACE_CAPACITY 16384
+#endif
+
+namespace Utility{
+
+/**
+ * @brief 記録された一区間
+*/
+struct GridTraceEvent{
+    char const * name;      // 操作の名前 文字列リテラルであること
+    uint64_t start_ns;      // 開始時刻(steady_clock)
+    uint64_t duration_ns;   // 所要時間
+    uint64_t width;
+    uint64_t height;
+    uint64_t depth;
+    uint32_t thread;        // 記録したスレッドの通し番号
+};
+
+namespace detail{
+
+/**
+ * @brief 一つのスレッドが書き込むリングバッファ
+ * @note 書き込みは所有するスレッドだけが行う 各枠の通し番号(奇数は書き込み中)で、読み出し側は書き換え中の枠を読み飛ばす
+*/
+class GridTraceRing{
+private:
+    struct Slot{
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<char const *> name{nullptr};
+        std::atomic<uint64_t> start_ns{0};
+        std::atomic<uint64_t> duration_ns{0};
+        std::atomic<uint64_t> width{0};
+        std::atomic<uint64_t> height{0};
+        std::atomic<uint64_t> depth{0};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_capacity;
+    std::atomic<uint64_t> m_head{0};    // これまでに書き込んだ数
+    uint32_t m_thread;
+
+public:
+    GridTraceRing(size_t const capacity, uint32_t const thread)
+        : m_slots(new Slot[capacity]),
+        m_capacity(capacity),
+        m_thread(thread){}
+
+    void push(char const * const name, uint64_t const start_ns, uint64_t const duration_ns,
+        uint64_t const width, uint64_t const height, uint64_t const depth){
+
+        uint64_t const n = m_head.load(std::memory_order_relaxed);
+        Slot & slot = m_slots[n % m_capacity];
+        uint64_t const sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.start_ns.store(start_ns, std::memory_order_relaxed);
+        slot.duration_ns.store(duration_ns, std::memory_order_relaxed);
+        slot.width.store(width, std::memory_order_relaxed);
+        slot.height.store(height, std::memory_order_relaxed);
+        slot.depth.store(depth, std::memory_order_relaxed);
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        m_head.store(n + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 残っている記録を古い順にoutへ追加する 書き込み中の枠は飛ばす
+    */
+    void collect(std::vector<GridTraceEvent> & out) const {
+        uint64_t const head = m_head.load(std::memory_order_acquire);
+        uint64_t const first = (head > m_capacity) ? head - m_capacity : 0;
+        for(uint64_t n=first; n<head; ++n){
+            Slot const & slot = m_slots[n % m_capacity];
+            uint64_t const before = slot.sequence.load(std::memory_order_acquire);
+            if(before & 1) continue;
+            GridTraceEvent event{
+                slot.name.load(std::memory_order_relaxed),
+                slot.start_ns.load(std::memory_order_relaxed),
+                slot.duration_ns.load(std::memory_order_relaxed),
+                slot.width.load(std::memory_order_relaxed),
+                slot.height.load(std::memory_order_relaxed),
+                slot.depth.load(std::memory_order_relaxed),
+                m_thread};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.sequence.load(std::memory_order_relaxed) != before || event.name == nullptr) continue;
+            out.push_back(event);
+        }
+    }
+
+    /**
+     * @brief 全ての記録を捨てる 書き込み中のスレッドがないときに呼ぶこと
+    */
+    void clear(){
+        for(size_t i=0; i<m_capacity; ++i){
+            m_slots[i].name.store(nullptr, std::memory_order_relaxed);
+        }
+        m_head.store(0, std::memory_order_release);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief 記録の登録先 プロセス全体で一つ
+ * @note リングバッファはスレッドが終了した後も残り、書き出しの対象になる
+*/
+class GridTrace{
+private:
+    std::mutex m_mutex;
+    std::vector<std::shared_ptr<detail::GridTraceRing>> m_rings;
+
+    GridTrace() = default;
+
+public:
+    GridTrace(GridTrace const &) = delete;
+    GridTrace & operator =(GridTrace const &) = delete;
+
+    static GridTrace & global(){
+        static GridTrace instance;
+        return instance;
+    }
+
+    /**
+     * @brief 呼び出したスレッドのリングバッファ 初回のみ登録のためにロックを取る
+    */
+    detail::GridTraceRing & local_ring(){
+        thread_local std::shared_ptr<detail::GridTraceRing> ring = [this]{
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto created = std::make_shared<detail::GridTraceRing>(UTILITY_GRID_TRACE_CAPACITY, static_cast<uint32_t>(m_rings.size()));
+            m_rings.push_back(created);
+            return created;
+        }();
+        return *ring;
+    }
+
+    /**
+     * @brief 全スレッドの記録を開始時刻の順に返す
+    */
+    std::vector<GridTraceEvent> events(){
+        std::vector<GridTraceEvent> result;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(auto const & ring : m_rings){
+                ring->collect(result);
+            }
+        }
+        std::stable_sort(result.begin(), result.end(), [](GridTraceEvent const & a, GridTraceEvent const & b){
+            return a.start_ns < b.start_ns;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Chrome trace形式のJSONとしてpathへ書き出す 失敗した場合はstd::runtime_errorを投げる
+     * @note chrome://tracingかui.perfetto.devで開ける 時刻はマイクロ秒
+    */
+    void write_chrome_trace(std::string const & path){
+        std::vector<GridTraceEvent> const list = events();
+        std::FILE * const file = std::fopen(path.c_str(), "w");
+        if(file == nullptr){
+            throw std::runtime_error("grid trace: cannot open " + path);
+        }
+        uint64_t const origin = list.empty() ? 0 : list.front().start_ns;
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        for(size_t i=0; i<list.size(); ++i){
+            auto const & e = list[i];
+            std::fprintf(file,
+                "{\"name\":\"%s\",\"cat\":\"grid\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"width\":%llu,\"height\":%llu,\"depth\":%llu,\"elements\":%llu}}%s\n",
+                e.name, static_cast<unsigned>(e.thread),
+                static_cast<double>(e.start_ns - origin) * 1e-3, static_cast<double>(e.duration_ns) * 1e-3,
+                static_cast<unsigned long long>(e.width), static_cast<unsigned long long>(e.height),
+                static_cast<unsigned long long>(e.depth), static_cast<unsigned long long>(e.width * e.height * e.depth),
+                (i + 1 == list.size()) ? "" : ",");
+        }
+        std::fprintf(file, "]}\n");
+        bool const failed = std::ferror(file) != 0;
+        if(std::fclose(file) != 0 || failed){
+            throw std::runtime_error("grid trace: failed to write " + path);
+        }
+    }
+
+    /**
+     * @brief 全ての記録を捨てる 記録中のスレッドがないときに呼ぶこと
+    */
+    void clear(){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(auto const & ring : m_rings){
+            ring->clear();
+        }
+    }
+};
+
+/**
+ * @brief 構築から破棄までを一区間として記録する
+ * @param[in] name 操作の名前 文字列リテラルであること
+ * @param[in] width, height, depth 操作の対象の大きさ 二次元ではdepthを1とする
+*/
+class GridTraceSpan{
+private:
+    char const * m_name;
+    uint64_t m_width;
+    uint64_t m_height;
+    uint64_t m_depth;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    GridTraceSpan(char const * const name, size_t const width, size_t const height, size_t const depth = 1)
+        : m_name(name),
+        m_width(width),
+        m_height(height),
+        m_depth(depth),
+        m_start(std::chrono::steady_clock::now()){}
+
+    GridTraceSpan(GridTraceSpan const &) = delete;
+    GridTraceSpan & operator =(GridTraceSpan const &) = delete;
+
+    ~GridTraceSpan(){
+        auto const end = std::chrono::steady_clock::now();
+        auto const start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(m_start.time_since_epoch()).count();
+        auto const duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start).count();
+        GridTrace::global().local_ring().push(m_name, static_cast<uint64_t>(start_ns), static_cast<uint64_t>(duration_ns),
+            m_width, m_height, m_depth);
+    }
+};
+
+} // namespace Utility
+
+#ifdef UTILITY_GRID_TRACE
+#define UTILITY_GRID_TRACE_SPAN(...) ::Utility::GridTraceSpan const grid_trace_span(__VA_ARGS__)
+#else
+#define UTILITY_GRID_TRACE_SPAN(...) ((void)0)
+#endif
+
+
+#endif // ifndef UTILITY_GRID_TRACE_H
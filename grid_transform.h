@@ -0,0 +1,429 @@
+/**
+ * @brief Grid2Dの転置・回転・反転と、Grid3Dの軸の入れ替え
+ * @note 出力の各要素を入力の(先頭, 行方向の間隔, 列方向の間隔)で表し、再帰的にブロックへ分割してキャッシュに収まる大きさで写す
+ * @note 4バイトの要素で入力の行方向の間隔が1の場合は、SSE2の4x4転置で写す
+ * @note 入出力には行優先のグリッドか、GridView2D, GridView3Dを使える
+*/
+
+#ifndef UTILITY_GRID_TRANSFORM_H
+#define UTILITY_GRID_TRANSFORM_H
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "grid2d.h"
+#include "grid3d.h"
+#include "grid_edit_batch.h"
+#include "thread_pool.h"
+
+namespace Utility{
+
+namespace detail{
+
+/**
+ * @brief 再帰的な分割を止めるブロックの一辺
+*/
+constexpr size_t transform_block = 32;
+
+/**
+ * @brief 要素の位置を格納領域の先頭と各方向の間隔で表したもの
+*/
+template <typename T>
+struct TransformBuffer{
+    T * data;
+    ptrdiff_t col_stride;
+    ptrdiff_t row_stride;
+    ptrdiff_t slice_stride;
+
+    T & operator ()(size_t const i, size_t const j) const {
+        return data[ptrdiff_t(i) * row_stride + ptrdiff_t(j) * col_stride];
+    }
+};
+
+template <typename grid_type>
+auto transform_buffer(grid_type & grid){
+    using layout_type = std::decay_t<decltype(grid.layout())>;
+    static_assert(is_strided_layout<layout_type>::value, "grid transform: grids must have a row-major layout (or be a view)");
+    auto const strides = layout_strides(grid.layout());
+    return TransformBuffer<std::remove_pointer_t<decltype(grid.data())>>{grid.data(), strides[0], strides[1], strides[2]};
+}
+
+/**
+ * @brief ブロック内の写し dst(i, j) = src[i * src_i + j * src_j]
+*/
+template <typename T>
+void transform_kernel(T * const dst, ptrdiff_t const dst_row, ptrdiff_t const dst_col,
+    T const * const src, ptrdiff_t const src_i, ptrdiff_t const src_j, size_t const rows, size_t const cols){
+
+    size_t i_first = 0;
+#if defined(__SSE2__)
+    if constexpr(sizeof(T) == 4 && std::is_trivially_copyable<T>::value){
+        // 入力の4列(出力の4行)を読み、4x4で転置して出力の4行へ書き込む
+        if(src_i == 1 && dst_col == 1){
+            size_t const rows4 = rows & ~size_t(3);
+            size_t const cols4 = cols & ~size_t(3);
+            for(size_t i=0; i<rows4; i+=4){
+                for(size_t j=0; j<cols4; j+=4){
+                    T const * const s = src + ptrdiff_t(i) + ptrdiff_t(j) * src_j;
+                    __m128 r0 = _mm_loadu_ps(reinterpret_cast<float const *>(s));
+                    __m128 r1 = _mm_loadu_ps(reinterpret_cast<float const *>(s + src_j));
+                    __m128 r2 = _mm_loadu_ps(reinterpret_cast<float const *>(s + 2 * src_j));
+                    __m128 r3 = _mm_loadu_ps(reinterpret_cast<float const *>(s + 3 * src_j));
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    T * const d = dst + ptrdiff_t(i) * dst_row + ptrdiff_t(j);
+                    _mm_storeu_ps(reinterpret_cast<float *>(d), r0);
+                    _mm_storeu_ps(reinterpret_cast<float *>(d + dst_row), r1);
+                    _mm_storeu_ps(reinterpret_cast<float *>(d + 2 * dst_row), r2);
+                    _mm_storeu_ps(reinterpret_cast<float *>(d + 3 * dst_row), r3);
+                }
+                for(size_t k=i; k<i+4; ++k){
+                    for(size_t j=cols4; j<cols; ++j){
+                        dst[ptrdiff_t(k) * dst_row + ptrdiff_t(j)] = src[ptrdiff_t(k) + ptrdiff_t(j) * src_j];
+                    }
+                }
+            }
+            i_first = rows4;
+        }
+    }
+#endif
+    for(size_t i=i_first; i<rows; ++i){
+        T * const d = dst + ptrdiff_t(i) * dst_row;
+        T const * const s = src + ptrdiff_t(i) * src_i;
+        for(size_t j=0; j<cols; ++j){
+            d[ptrdiff_t(j) * dst_col] = s[ptrdiff_t(j) * src_j];
+        }
+    }
+}
+
+/**
+ * @brief rows x colsの写しを、長い方の辺を半分にする再帰でブロックに分割する
+*/
+template <typename T>
+void transform_recursive(T * const dst, ptrdiff_t const dst_row, ptrdiff_t const dst_col,
+    T const * const src, ptrdiff_t const src_i, ptrdiff_t const src_j, size_t const rows, size_t const cols){
+
+    if(rows <= transform_block && cols <= transform_block){
+        transform_kernel(dst, dst_row, dst_col, src, src_i, src_j, rows, cols);
+    }else if(rows >= cols){
+        size_t const half = rows / 2;
+        transform_recursive(dst, dst_row, dst_col, src, src_i, src_j, half, cols);
+        transform_recursive(dst + ptrdiff_t(half) * dst_row, dst_row, dst_col, src + ptrdiff_t(half) * src_i, src_i, src_j, rows - half, cols);
+    }else{
+        size_t const half = cols / 2;
+        transform_recursive(dst, dst_row, dst_col, src, src_i, src_j, rows, half);
+        transform_recursive(dst + ptrdiff_t(half) * dst_col, dst_row, dst_col, src + ptrdiff_t(half) * src_j, src_i, src_j, rows, cols - half);
+    }
+}
+
+/**
+ * @brief dstの(i, j)へsrc[i * src_i + j * src_j]を写す 出力の行単位で並列に実行できる
+*/
+template <typename T>
+void transform_copy(TransformBuffer<T> const & dst, T const * const src, ptrdiff_t const src_i, ptrdiff_t const src_j,
+    size_t const rows, size_t const cols, GridExecution const execution){
+
+    if(rows == 0 || cols == 0) return;
+    auto const run = [&](size_t const first, size_t const last){
+        // 入出力とも行内が連続している場合は、分割せずに行ごとに写す
+        if(dst.col_stride == 1 && (src_j == 1 || src_j == -1)){
+            for(size_t i=first; i<last; ++i){
+                T const * const s = src + ptrdiff_t(i) * src_i;
+                T * const d = dst.data + ptrdiff_t(i) * dst.row_stride;
+                if(src_j == 1) std::copy(s, s + cols, d);
+                else std::reverse_copy(s - ptrdiff_t(cols) + 1, s + 1, d);
+            }
+            return;
+        }
+        transform_recursive(dst.data + ptrdiff_t(first) * dst.row_stride, dst.row_stride, dst.col_stride,
+            src + ptrdiff_t(first) * src_i, src_i, src_j, last - first, cols);
+    };
+    if(execution == GridExecution::Parallel){
+        ThreadPool::global().parallel_for(0, rows, run, transform_block);
+    }else{
+        run(0, rows);
+    }
+}
+
+/**
+ * @brief 入力の(y0, x0)を先頭とし、出力の行・列方向にそれぞれ入力のどの向きへ進むかで表した写し
+ * @param[in] y0, x0 出力の(0, 0)に対応する入力の位置
+ * @param[in] di_y, di_x 出力の行が1進んだときの入力の(y, x)の増分
+ * @param[in] dj_y, dj_x 出力の列が1進んだときの入力の(y, x)の増分
+*/
+template <typename Src, typename Dst>
+void transform2d(Src const & src, Dst && dst, size_t const out_w, size_t const out_h,
+    size_t const y0, size_t const x0, int const di_y, int const di_x, int const dj_y, int const dj_x, GridExecution const execution){
+
+    check_distinct(src, dst);
+    fit_destination(dst, out_w, out_h, 1);
+    if(out_w == 0 || out_h == 0) return;
+    auto const s = transform_buffer(src);
+    auto const d = transform_buffer(dst);
+    using value_type = std::remove_const_t<std::remove_pointer_t<decltype(s.data)>>;
+    value_type const * const origin = &s(y0, x0);
+    transform_copy<value_type>(d, origin, di_y * s.row_stride + di_x * s.col_stride, dj_y * s.row_stride + dj_x * s.col_stride,
+        out_h, out_w, execution);
+}
+
+/**
+ * @brief n x nの対角ブロック内の転置 (r0, c0)から始まる部分とその対称な部分を入れ替える
+*/
+template <typename T>
+void transpose_swap_blocks(TransformBuffer<T> const & a, size_t const r0, size_t const c0, size_t const rows, size_t const cols){
+    if(rows <= transform_block && cols <= transform_block){
+        for(size_t i=r0; i<r0+rows; ++i){
+            for(size_t j=c0; j<c0+cols; ++j){
+                std::swap(a(i, j), a(j, i));
+            }
+        }
+    }else if(rows >= cols){
+        size_t const half = rows / 2;
+        transpose_swap_blocks(a, r0, c0, half, cols);
+        transpose_swap_blocks(a, r0 + half, c0, rows - half, cols);
+    }else{
+        size_t const half = cols / 2;
+        transpose_swap_blocks(a, r0, c0, rows, half);
+        transpose_swap_blocks(a, r0, c0 + half, rows, cols - half);
+    }
+}
+
+template <typename T>
+void transpose_diagonal(TransformBuffer<T> const & a, size_t const first, size_t const n){
+    if(n <= transform_block){
+        for(size_t i=first; i<first+n; ++i){
+            for(size_t j=first; j<i; ++j){
+                std::swap(a(i, j), a(j, i));
+            }
+        }
+        return;
+    }
+    size_t const half = n / 2;
+    transpose_diagonal(a, first, half);
+    transpose_diagonal(a, first + half, n - half);
+    transpose_swap_blocks(a, first + half, first, n - half, half);
+}
+
+template <typename grid_type>
+void check_square(grid_type const & grid){
+    if(grid.width() != grid.height()){
+        throw std::invalid_argument("grid transform: in-place transpose and rotation require a square grid");
+    }
+}
+
+/**
+ * @brief 三次元の写し dst(k, i, j) = src[k * s[2] + i * s[1] + j * s[0]] 最も長い辺を半分にする再帰で分割する
+*/
+template <typename T>
+void permute_recursive(T * const dst, std::array<ptrdiff_t, 3> const & ds, T const * const src, std::array<ptrdiff_t, 3> const & ss,
+    std::array<size_t, 3> const & n){
+
+    if(n[0] <= transform_block && n[1] <= transform_block && n[2] <= transform_block){
+        for(size_t k=0; k<n[2]; ++k){
+            for(size_t i=0; i<n[1]; ++i){
+                T * const d = dst + ptrdiff_t(k) * ds[2] + ptrdiff_t(i) * ds[1];
+                T const * const s = src + ptrdiff_t(k) * ss[2] + ptrdiff_t(i) * ss[1];
+                for(size_t j=0; j<n[0]; ++j){
+                    d[ptrdiff_t(j) * ds[0]] = s[ptrdiff_t(j) * ss[0]];
+                }
+            }
+        }
+        return;
+    }
+    int const axis = (n[0] >= n[1] && n[0] >= n[2]) ? 0 : ((n[1] >= n[2]) ? 1 : 2);
+    size_t const half = n[axis] / 2;
+    std::array<size_t, 3> first = n, second = n;
+    first[axis] = half;
+    second[axis] = n[axis] - half;
+    permute_recursive(dst, ds, src, ss, first);
+    permute_recursive(dst + ptrdiff_t(half) * ds[axis], ds, src + ptrdiff_t(half) * ss[axis], ss, second);
+}
+
+inline int axis_index(GridAxis const axis){
+    return (axis == GridAxis::Column) ? 0 : ((axis == GridAxis::Row) ? 1 : 2);
+}
+
+} // namespace detail
+
+/**
+ * @brief 転置 dst(x, y) = src(y, x) dstの幅はsrcの高さ、高さはsrcの幅になる
+ * @param[in] src 入力 行優先のGrid2DかGridView2D
+ * @param[out] dst 出力 srcと格納領域を共有しないこと Grid2Dは大きさを合わせ、GridView2Dは転置した大きさであること
+ * @param[in] execution 出力の行単位で並列に実行するか
+*/
+template <typename Src, typename Dst,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void transpose(Src const & src, Dst && dst, GridExecution const execution = GridExecution::Sequential){
+    detail::transform2d(src, dst, src.height(), src.width(), 0, 0, 0, 1, 1, 0, execution);
+}
+
+/**
+ * @brief 時計回り(yが下向きの表示で)に90度回転 dst(x, h - 1 - y) = src(y, x)
+*/
+template <typename Src, typename Dst,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void rotate90(Src const & src, Dst && dst, GridExecution const execution = GridExecution::Sequential){
+    detail::transform2d(src, dst, src.height(), src.width(), src.height() - 1, 0, 0, 1, -1, 0, execution);
+}
+
+/**
+ * @brief 180度回転 dst(h - 1 - y, w - 1 - x) = src(y, x)
+*/
+template <typename Src, typename Dst,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void rotate180(Src const & src, Dst && dst, GridExecution const execution = GridExecution::Sequential){
+    detail::transform2d(src, dst, src.width(), src.height(), src.height() - 1, src.width() - 1, -1, 0, 0, -1, execution);
+}
+
+/**
+ * @brief 反時計回りに90度回転(時計回りに270度) dst(w - 1 - x, y) = src(y, x)
+*/
+template <typename Src, typename Dst,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void rotate270(Src const & src, Dst && dst, GridExecution const execution = GridExecution::Sequential){
+    detail::transform2d(src, dst, src.height(), src.width(), 0, src.width() - 1, 0, -1, 1, 0, execution);
+}
+
+/**
+ * @brief 左右反転 dst(y, w - 1 - x) = src(y, x)
+*/
+template <typename Src, typename Dst,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void flip_horizontal(Src const & src, Dst && dst, GridExecution const execution = GridExecution::Sequential){
+    detail::transform2d(src, dst, src.width(), src.height(), 0, src.width() - 1, 1, 0, 0, -1, execution);
+}
+
+/**
+ * @brief 上下反転 dst(h - 1 - y, x) = src(y, x)
+*/
+template <typename Src, typename Dst,
+    std::enable_if_t<detail::is_grid2d<Src>::value && detail::is_grid2d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void flip_vertical(Src const & src, Dst && dst, GridExecution const execution = GridExecution::Sequential){
+    detail::transform2d(src, dst, src.width(), src.height(), src.height() - 1, 0, -1, 0, 0, 1, execution);
+}
+
+/**
+ * @brief その場での転置 正方形のグリッドのみ 正方形でなければstd::invalid_argumentを投げる
+*/
+template <typename Grid, std::enable_if_t<detail::is_grid2d<std::decay_t<Grid>>::value, std::nullptr_t> = nullptr>
+void transpose(Grid && grid){
+    detail::check_square(grid);
+    detail::transpose_diagonal(detail::transform_buffer(grid), 0, grid.width());
+}
+
+/**
+ * @brief その場での左右反転
+*/
+template <typename Grid, std::enable_if_t<detail::is_grid2d<std::decay_t<Grid>>::value, std::nullptr_t> = nullptr>
+void flip_horizontal(Grid && grid){
+    if(grid.width() == 0 || grid.height() == 0) return;
+    auto const a = detail::transform_buffer(grid);
+    size_t const w = grid.width();
+    for(size_t i=0; i<grid.height(); ++i){
+        if(a.col_stride == 1){
+            std::reverse(&a(i, 0), &a(i, 0) + w);
+            continue;
+        }
+        for(size_t j=0; j<w/2; ++j){
+            std::swap(a(i, j), a(i, w - 1 - j));
+        }
+    }
+}
+
+/**
+ * @brief その場での上下反転
+*/
+template <typename Grid, std::enable_if_t<detail::is_grid2d<std::decay_t<Grid>>::value, std::nullptr_t> = nullptr>
+void flip_vertical(Grid && grid){
+    if(grid.width() == 0 || grid.height() == 0) return;
+    auto const a = detail::transform_buffer(grid);
+    size_t const h = grid.height();
+    for(size_t i=0; i<h/2; ++i){
+        if(a.col_stride == 1){
+            std::swap_ranges(&a(i, 0), &a(i, 0) + grid.width(), &a(h - 1 - i, 0));
+            continue;
+        }
+        for(size_t j=0; j<grid.width(); ++j){
+            std::swap(a(i, j), a(h - 1 - i, j));
+        }
+    }
+}
+
+/**
+ * @brief その場での時計回りの90度回転 正方形のグリッドのみ
+*/
+template <typename Grid, std::enable_if_t<detail::is_grid2d<std::decay_t<Grid>>::value, std::nullptr_t> = nullptr>
+void rotate90(Grid && grid){
+    transpose(grid);
+    flip_horizontal(grid);
+}
+
+/**
+ * @brief その場での180度回転
+*/
+template <typename Grid, std::enable_if_t<detail::is_grid2d<std::decay_t<Grid>>::value, std::nullptr_t> = nullptr>
+void rotate180(Grid && grid){
+    flip_vertical(grid);
+    flip_horizontal(grid);
+}
+
+/**
+ * @brief その場での反時計回りの90度回転 正方形のグリッドのみ
+*/
+template <typename Grid, std::enable_if_t<detail::is_grid2d<std::decay_t<Grid>>::value, std::nullptr_t> = nullptr>
+void rotate270(Grid && grid){
+    transpose(grid);
+    flip_vertical(grid);
+}
+
+/**
+ * @brief 軸の入れ替え dstのx, y, z軸をそれぞれsrcのx_from, y_from, z_from軸にする
+ * @note 例えば(GridAxis::Depth, GridAxis::Row, GridAxis::Column)でxとzを入れ替える
+ * @param[out] dst 出力 srcと格納領域を共有しないこと Grid3Dは大きさを合わせ、GridView3Dは入れ替えた大きさであること
+ * @param[in] execution 出力のz単位で並列に実行するか
+ * @note x_from, y_from, z_fromが軸の並べ替えになっていなければstd::invalid_argumentを投げる
+*/
+template <typename Src, typename Dst,
+    std::enable_if_t<detail::is_grid3d<Src>::value && detail::is_grid3d<std::decay_t<Dst>>::value, std::nullptr_t> = nullptr>
+void permute_axes(Src const & src, Dst && dst, GridAxis const x_from, GridAxis const y_from, GridAxis const z_from,
+    GridExecution const execution = GridExecution::Sequential){
+
+    std::array<int, 3> const from{detail::axis_index(x_from), detail::axis_index(y_from), detail::axis_index(z_from)};
+    if(from[0] == from[1] || from[1] == from[2] || from[0] == from[2]){
+        throw std::invalid_argument("grid transform: axes must be a permutation of x, y and z");
+    }
+    detail::check_distinct(src, dst);
+    std::array<size_t, 3> const extent{src.width(), src.height(), src.depth()};
+    std::array<size_t, 3> const n{extent[from[0]], extent[from[1]], extent[from[2]]};
+    detail::fit_destination(dst, n[0], n[1], n[2]);
+    if(n[0] == 0 || n[1] == 0 || n[2] == 0) return;
+
+    auto const s = detail::transform_buffer(src);
+    auto const d = detail::transform_buffer(dst);
+    std::array<ptrdiff_t, 3> const src_strides{s.col_stride, s.row_stride, s.slice_stride};
+    std::array<ptrdiff_t, 3> const ss{src_strides[from[0]], src_strides[from[1]], src_strides[from[2]]};
+    std::array<ptrdiff_t, 3> const ds{d.col_stride, d.row_stride, d.slice_stride};
+    using value_type = std::remove_const_t<std::remove_pointer_t<decltype(s.data)>>;
+    value_type const * const src_data = s.data;
+
+    auto const run = [&](size_t const first, size_t const last){
+        detail::permute_recursive<value_type>(d.data + ptrdiff_t(first) * ds[2], ds, src_data + ptrdiff_t(first) * ss[2], ss,
+            std::array<size_t, 3>{n[0], n[1], last - first});
+    };
+    if(execution == GridExecution::Parallel){
+        ThreadPool::global().parallel_for(0, n[2], run);
+    }else{
+        run(0, n[2]);
+    }
+}
+
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_TRANSFORM_H
@@ -0,0 +1,608 @@
+/**
+ * @brief Grid2D, Grid3Dの一部の領域を参照する、所有権を持たないビュー
+ * @note 先頭の要素へのポインタ、大きさ、各方向の間隔だけを持ち、要素をコピーしない
+ * @note 参照先のグリッドの大きさを変えるとビューは無効になる
+*/
+
+#ifndef UTILITY_GRID_VIEW_H
+#define UTILITY_GRID_VIEW_H
+
+#include <iostream>
+#include <utility>
+#include <tuple>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include "grid_layout.h"
+#include "grid_expression.h"
+#include "thread_pool.h"
+
+namespace Utility{
+
+/**
+ * @brief 二次元のビュー at(y,x)でアクセス
+ * @tparam data_type 要素の型 読み込み専用のビューはconstを付ける
+ * @note ビュー自体のconstは参照先の要素に影響しない(std::spanと同じ)
+*/
+template <typename data_type>
+class GridView2D{
+public:
+    using size_type = size_t;
+    using value_type = std::remove_const_t<data_type>;
+    using layout_type = StridedLayout2D;
+
+private:
+    data_type * m_data = nullptr; // 先頭(0, 0)の要素
+    size_type m_width = 0;        // 横
+    size_type m_height = 0;       // 縦
+    layout_type m_layout;         // 各方向の間隔
+
+public:
+    GridView2D() = default;
+
+    /**
+     * @brief 先頭の要素へのポインタ、大きさ、間隔から構築
+     * @param[in] row_stride 隣の行までの要素数
+     * @param[in] col_stride 隣の列までの要素数
+    */
+    GridView2D(data_type * data, size_type const width, size_type const height, ptrdiff_t const row_stride, ptrdiff_t const col_stride = 1)
+        : m_data(data),
+        m_width(width),
+        m_height(height),
+        m_layout(width, height, row_stride, col_stride){}
+
+    /**
+     * @brief 書き込み可能なビューから読み込み専用のビューへの変換
+    */
+    template <typename other_type, std::enable_if_t<std::is_same<other_type const, data_type>::value && !std::is_same<other_type, data_type>::value, std::nullptr_t> = nullptr>
+    GridView2D(GridView2D<other_type> const & other)
+        : GridView2D(other.data(), other.width(), other.height(), other.layout().row_stride(), other.layout().col_stride()){}
+
+    /**
+     * @brief 要素ごとの演算式を評価して、参照先の要素へ書き込む
+     * @note 式の大きさがビューと異なる場合はstd::invalid_argumentを投げる
+     * @note 式が同じ要素を別の位置から参照している場合の結果は未定義
+    */
+    template <typename Expr, std::enable_if_t<detail::is_grid_expression<Expr>::value, std::nullptr_t> = nullptr>
+    GridView2D & operator =(Expr const & expr){
+        static_assert(!std::is_const<data_type>::value, "GridView2D: cannot assign through a read-only view");
+        GridShape shape;
+        detail::check_expression_shape(expr, shape);
+        if(shape.width != m_width || shape.height != m_height){
+            throw std::invalid_argument("grid expression: shape mismatch");
+        }
+        detail::evaluate_expression_at(m_data, m_layout, expr, GridShape{m_width, m_height, 1});
+        return *this;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView2D, Right>::value, std::nullptr_t> = nullptr>
+    GridView2D & operator +=(Right const & right){
+        return *this = *this + right;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView2D, Right>::value, std::nullptr_t> = nullptr>
+    GridView2D & operator -=(Right const & right){
+        return *this = *this - right;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView2D, Right>::value, std::nullptr_t> = nullptr>
+    GridView2D & operator *=(Right const & right){
+        return *this = *this * right;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView2D, Right>::value, std::nullptr_t> = nullptr>
+    GridView2D & operator /=(Right const & right){
+        return *this = *this / right;
+    }
+
+    /**
+     * @brief 同じ大きさのグリッドかビューの要素をコピーする
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid2d<grid_type>::value, std::nullptr_t> = nullptr>
+    void assign(grid_type const & src){
+        *this = detail::as_expression(src);
+    }
+
+    /**
+     * @brief 全要素をvalueにする
+    */
+    void fill(value_type const & value) const {
+        foreach([&](size_type const i, size_type const j){
+            m_data[m_layout.index(i, j)] = value;
+        });
+    }
+
+    /**
+     * @brief 要素アクセス 範囲外ではstd::out_of_rangeを投げる
+    */
+    data_type & at(int const y, int const x) const {
+        if(!in(y, x)){
+            throw std::out_of_range("GridView2D: index out of range");
+        }
+        return m_data[m_layout.index(y, x)];
+    }
+
+    /**
+     * @brief (x,y)のペアにより要素アクセス
+     * @param[in] pos (x,y)のペア
+    */
+    data_type & at(std::pair<int, int> const & pos) const {
+        return at(pos.second, pos.first);
+    }
+
+    /**
+     * @brief [y][x]で要素アクセス
+    */
+    GridStridedRow<data_type> operator [] (int const y) const {
+        return GridStridedRow<data_type>(m_data + m_layout.index(y, 0), m_layout.col_stride());
+    }
+
+    /**
+     * @brief y行目の先頭の要素へのポインタ
+     * @note 行内の要素はlayout().col_stride()ごとに並ぶ col_stride()が1なら連続した配列として扱える
+    */
+    data_type * row(size_type const y) const {
+        return m_data + m_layout.index(y, 0);
+    }
+
+    /**
+     * @brief (y, x)が範囲内に収まるかを調べる
+     * @return 収まっていたらtrue
+    */
+    bool in(int const y, int const x) const {
+        return y >= 0 && size_type(y) < m_height && x >= 0 && size_type(x) < m_width;
+    }
+
+    /**
+     * @brief (x, y)が範囲内に収まるかを調べる
+     * @param[in] pos (x, y)のペア
+    */
+    bool in(std::pair<int, int> const & pos) const {
+        return in(pos.second, pos.first);
+    }
+
+    size_t width() const {
+        return m_width;
+    }
+
+    size_t height() const {
+        return m_height;
+    }
+
+    /**
+     * @brief pairでサイズを返す
+     * @return width, heightのペア
+    */
+    std::pair<size_t, size_t> size() const {
+        return std::make_pair(m_width, m_height);
+    }
+
+    /**
+     * @brief 先頭(0, 0)の要素へのポインタ 要素の位置はlayout()に従う
+    */
+    data_type * data() const {
+        return m_data;
+    }
+
+    layout_type const & layout() const {
+        return m_layout;
+    }
+
+    /**
+     * @brief [y_first, y_last)x[x_first, x_last)の領域のビュー
+    */
+    GridView2D subgrid(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last) const {
+        if(y_first > y_last || x_first > x_last || y_last > m_height || x_last > m_width){
+            throw std::out_of_range("GridView2D: region out of range");
+        }
+        return GridView2D(m_data + m_layout.index(y_first, x_first), x_last - x_first, y_last - y_first,
+            m_layout.row_stride(), m_layout.col_stride());
+    }
+
+    /**
+     * @brief 出力
+    */
+    void print() const {
+        for(size_type i=0; i<m_height; ++i){
+            for(size_type j=0; j<m_width; ++j){
+                std::cout << m_data[m_layout.index(i, j)] << ' ';
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    /**
+     * @brief サイズの出力
+    */
+    void print_size() const {
+        std::cout << "(width:" << m_width << " height:" << m_height << ")" << std::endl;
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(const Function & func) const {
+        m_layout.foreach(0, m_height, func);
+    }
+
+    /**
+     * @brief 各要素への一律な操作を並列に行う
+     * @param[in] func y,xを引数として受け取る関数 異なる要素に対して同時に呼ばれる
+    */
+    template <typename Function>
+    void parallel_foreach(const Function & func) const {
+        parallel_foreach(ThreadPool::global(), func);
+    }
+
+    /**
+     * @brief 各要素への一律な操作を、指定したプールで並列に行う
+     * @param[in] pool 使用するスレッドプール
+     * @param[in] func y,xを引数として受け取る関数 異なる要素に対して同時に呼ばれる
+    */
+    template <typename Function>
+    void parallel_foreach(ThreadPool & pool, const Function & func) const {
+        pool.parallel_for(0, m_height, [&](size_type const first, size_type const last){
+            m_layout.foreach(first, last, func);
+        });
+    }
+
+#ifdef UTILITY_POINT2I_H
+
+    // point2i.hがincludeされている場合
+
+    /**
+     * @brief (x, y)で要素アクセス
+     * @param[in] pos (x,y)のPoint2i
+    */
+    data_type & at(Point2i const & pos) const {
+        return at(pos.y, pos.x);
+    }
+
+    /**
+     * @brief (x, y)で要素アクセス
+     * @param[in] pos (x,y)のPoint2i
+    */
+    data_type & operator [] (Point2i const & pos) const {
+        return operator[](pos.y)[pos.x];
+    }
+
+    /**
+     * @brief (x, y)が範囲内に収まるかを調べる
+     * @param[in] pos (x, y)のPoint2i
+    */
+    bool in(Point2i const & pos) const {
+        return in(pos.y, pos.x);
+    }
+
+    /**
+     * @brief (x, y)のPoint2iで指定した[first, last)の領域のビュー
+    */
+    GridView2D subgrid(Point2i const & first, Point2i const & last) const {
+        if(first.x < 0 || first.y < 0 || last.x < 0 || last.y < 0){
+            throw std::out_of_range("GridView2D: region out of range");
+        }
+        return subgrid(first.y, first.x, last.y, last.x);
+    }
+
+#endif // ifdef UTILITY_POINT2I_H
+
+};
+
+/**
+ * @brief 三次元のビュー at(z,y,x)でアクセス
+ * @tparam data_type 要素の型 読み込み専用のビューはconstを付ける
+*/
+template <typename data_type>
+class GridView3D{
+public:
+    using size_type = size_t;
+    using value_type = std::remove_const_t<data_type>;
+    using layout_type = StridedLayout3D;
+
+private:
+    data_type * m_data = nullptr; // 先頭(0, 0, 0)の要素
+    size_type m_width = 0;        // 横
+    size_type m_height = 0;       // 縦
+    size_type m_depth = 0;        // 奥行
+    layout_type m_layout;         // 各方向の間隔
+
+public:
+    GridView3D() = default;
+
+    /**
+     * @brief 先頭の要素へのポインタ、大きさ、間隔から構築
+     * @param[in] slice_stride 隣の奥までの要素数
+     * @param[in] row_stride 隣の行までの要素数
+     * @param[in] col_stride 隣の列までの要素数
+    */
+    GridView3D(data_type * data, size_type const width, size_type const height, size_type const depth,
+        ptrdiff_t const slice_stride, ptrdiff_t const row_stride, ptrdiff_t const col_stride = 1)
+        : m_data(data),
+        m_width(width),
+        m_height(height),
+        m_depth(depth),
+        m_layout(width, height, depth, slice_stride, row_stride, col_stride){}
+
+    /**
+     * @brief 書き込み可能なビューから読み込み専用のビューへの変換
+    */
+    template <typename other_type, std::enable_if_t<std::is_same<other_type const, data_type>::value && !std::is_same<other_type, data_type>::value, std::nullptr_t> = nullptr>
+    GridView3D(GridView3D<other_type> const & other)
+        : GridView3D(other.data(), other.width(), other.height(), other.depth(),
+            other.layout().slice_stride(), other.layout().row_stride(), other.layout().col_stride()){}
+
+    /**
+     * @brief 要素ごとの演算式を評価して、参照先の要素へ書き込む
+     * @note 式の大きさがビューと異なる場合はstd::invalid_argumentを投げる
+     * @note 式が同じ要素を別の位置から参照している場合の結果は未定義
+    */
+    template <typename Expr, std::enable_if_t<detail::is_grid_expression<Expr>::value, std::nullptr_t> = nullptr>
+    GridView3D & operator =(Expr const & expr){
+        static_assert(!std::is_const<data_type>::value, "GridView3D: cannot assign through a read-only view");
+        GridShape shape;
+        detail::check_expression_shape(expr, shape);
+        if(shape.width != m_width || shape.height != m_height || shape.depth != m_depth){
+            throw std::invalid_argument("grid expression: shape mismatch");
+        }
+        detail::evaluate_expression_at(m_data, m_layout, expr, shape);
+        return *this;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView3D, Right>::value, std::nullptr_t> = nullptr>
+    GridView3D & operator +=(Right const & right){
+        return *this = *this + right;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView3D, Right>::value, std::nullptr_t> = nullptr>
+    GridView3D & operator -=(Right const & right){
+        return *this = *this - right;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView3D, Right>::value, std::nullptr_t> = nullptr>
+    GridView3D & operator *=(Right const & right){
+        return *this = *this * right;
+    }
+
+    template <typename Right, std::enable_if_t<detail::is_grid_operator_pair<GridView3D, Right>::value, std::nullptr_t> = nullptr>
+    GridView3D & operator /=(Right const & right){
+        return *this = *this / right;
+    }
+
+    /**
+     * @brief 同じ大きさのグリッドかビューの要素をコピーする
+    */
+    template <typename grid_type, std::enable_if_t<detail::is_grid3d<grid_type>::value, std::nullptr_t> = nullptr>
+    void assign(grid_type const & src){
+        *this = detail::as_expression(src);
+    }
+
+    /**
+     * @brief 全要素をvalueにする
+    */
+    void fill(value_type const & value) const {
+        foreach([&](size_type const i, size_type const j, size_type const k){
+            m_data[m_layout.index(i, j, k)] = value;
+        });
+    }
+
+    /**
+     * @brief 要素アクセス 範囲外ではstd::out_of_rangeを投げる
+    */
+    data_type & at(int const z, int const y, int const x) const {
+        if(!in(z, y, x)){
+            throw std::out_of_range("GridView3D: index out of range");
+        }
+        return m_data[m_layout.index(z, y, x)];
+    }
+
+    /**
+     * @brief (x,y,z)のタプルにより要素アクセス
+     * @param[in] pos (x,y,z)のタプル
+    */
+    data_type & at(std::tuple<int, int, int> const pos) const {
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief [z][y][x]で要素アクセス [z]はz枚目の二次元のビューを返す
+    */
+    GridView2D<data_type> operator [] (int const z) const {
+        return GridView2D<data_type>(m_data + m_layout.index(z, 0, 0), m_width, m_height, m_layout.row_stride(), m_layout.col_stride());
+    }
+
+    /**
+     * @brief z枚目のxy平面のビュー (y, x)でアクセスする 範囲外ではstd::out_of_rangeを投げる
+    */
+    GridView2D<data_type> slice_z(size_type const z) const {
+        if(z >= m_depth){
+            throw std::out_of_range("GridView3D: slice out of range");
+        }
+        return GridView2D<data_type>(m_data + m_layout.index(z, 0, 0), m_width, m_height, m_layout.row_stride(), m_layout.col_stride());
+    }
+
+    /**
+     * @brief y行目のxz平面のビュー (z, x)でアクセスする 範囲外ではstd::out_of_rangeを投げる
+     * @note 幅はwidth()、高さはdepth()
+    */
+    GridView2D<data_type> slice_y(size_type const y) const {
+        if(y >= m_height){
+            throw std::out_of_range("GridView3D: slice out of range");
+        }
+        return GridView2D<data_type>(m_data + m_layout.index(0, y, 0), m_width, m_depth, m_layout.slice_stride(), m_layout.col_stride());
+    }
+
+    /**
+     * @brief x列目のyz平面のビュー (z, y)でアクセスする 範囲外ではstd::out_of_rangeを投げる
+     * @note 幅はheight()、高さはdepth() 行内の要素はrow_strideごとに並ぶ
+    */
+    GridView2D<data_type> slice_x(size_type const x) const {
+        if(x >= m_width){
+            throw std::out_of_range("GridView3D: slice out of range");
+        }
+        return GridView2D<data_type>(m_data + m_layout.index(0, 0, x), m_height, m_depth, m_layout.slice_stride(), m_layout.row_stride());
+    }
+
+    /**
+     * @brief (z, y)行目の先頭の要素へのポインタ
+     * @note 行内の要素はlayout().col_stride()ごとに並ぶ
+    */
+    data_type * row(size_type const z, size_type const y) const {
+        return m_data + m_layout.index(z, y, 0);
+    }
+
+    /**
+     * @brief (z, y, x)が範囲内に収まるかを調べる
+     * @return 収まっていたらtrue
+    */
+    bool in(int const z, int const y, int const x) const {
+        return z >= 0 && size_type(z) < m_depth && y >= 0 && size_type(y) < m_height && x >= 0 && size_type(x) < m_width;
+    }
+
+    /**
+     * @brief (x, y, z)が範囲内に収まるかを調べる
+     * @param[in] pos (x, y, z)のタプル
+    */
+    bool in(std::tuple<int, int, int> const & pos) const {
+        return in(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    size_t width() const {
+        return m_width;
+    }
+
+    size_t height() const {
+        return m_height;
+    }
+
+    size_t depth() const {
+        return m_depth;
+    }
+
+    /**
+     * @brief tupleでサイズを返す
+     * @return width, height, depthのタプル
+    */
+    std::tuple<size_t, size_t, size_t> size() const {
+        return std::make_tuple(m_width, m_height, m_depth);
+    }
+
+    /**
+     * @brief 先頭(0, 0, 0)の要素へのポインタ 要素の位置はlayout()に従う
+    */
+    data_type * data() const {
+        return m_data;
+    }
+
+    layout_type const & layout() const {
+        return m_layout;
+    }
+
+    /**
+     * @brief [z_first, z_last)x[y_first, y_last)x[x_first, x_last)の領域のビュー
+    */
+    GridView3D subgrid(size_type const z_first, size_type const y_first, size_type const x_first,
+        size_type const z_last, size_type const y_last, size_type const x_last) const {
+
+        if(z_first > z_last || y_first > y_last || x_first > x_last || z_last > m_depth || y_last > m_height || x_last > m_width){
+            throw std::out_of_range("GridView3D: region out of range");
+        }
+        return GridView3D(m_data + m_layout.index(z_first, y_first, x_first), x_last - x_first, y_last - y_first, z_last - z_first,
+            m_layout.slice_stride(), m_layout.row_stride(), m_layout.col_stride());
+    }
+
+    /**
+     * @brief 出力
+    */
+    void print() const {
+        for(size_type i=0; i<m_height; ++i){
+            for(size_type j=0; j<m_depth; ++j){
+                std::cout << '[';
+                for(size_type k=0; k<m_width; ++k){
+                    std::cout << m_data[m_layout.index(j, i, k)];
+                    std::cout << ((k == m_width - 1) ? "" : " ");
+                }
+                std::cout << "] ";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    /**
+     * @brief サイズの出力
+    */
+    void print_size() const {
+        std::cout << "(width:" << m_width << " height:" << m_height << " depth:" << m_depth << ")" << std::endl;
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func z,y,xを引数として受け取る関数
+    */
+    template <typename Function>
+    void foreach(const Function & func) const {
+        m_layout.foreach(0, m_layout.band_count(), func);
+    }
+
+    /**
+     * @brief 各要素への一律な操作を並列に行う
+     * @param[in] func z,y,xを引数として受け取る関数 異なる要素に対して同時に呼ばれる
+    */
+    template <typename Function>
+    void parallel_foreach(const Function & func) const {
+        parallel_foreach(ThreadPool::global(), func);
+    }
+
+    /**
+     * @brief 各要素への一律な操作を、指定したプールで並列に行う
+     * @param[in] pool 使用するスレッドプール
+     * @param[in] func z,y,xを引数として受け取る関数 異なる要素に対して同時に呼ばれる
+    */
+    template <typename Function>
+    void parallel_foreach(ThreadPool & pool, const Function & func) const {
+        pool.parallel_for(0, m_layout.band_count(), [&](size_type const first, size_type const last){
+            m_layout.foreach(first, last, func);
+        });
+    }
+};
+
+namespace detail{
+
+/**
+ * @brief ステンシルや変換の出力先の大きさを合わせる グリッドは大きさを変え、ビューは一致しなければ例外を投げる
+*/
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+void fit_destination(Grid2D<data_type, layout_type, allocator_type, bounds_policy> & dst, size_t const w, size_t const h, size_t){
+    if(dst.width() != w || dst.height() != h) dst.resize(w, h);
+}
+template <typename data_type, typename layout_type, typename allocator_type, typename bounds_policy>
+void fit_destination(Grid3D<data_type, layout_type, allocator_type, bounds_policy> & dst, size_t const w, size_t const h, size_t const d){
+    if(dst.width() != w || dst.height() != h || dst.depth() != d) dst.resize(w, h, d);
+}
+template <typename data_type>
+void fit_destination(GridView2D<data_type> const & dst, size_t const w, size_t const h, size_t){
+    if(dst.width() != w || dst.height() != h){
+        throw std::invalid_argument("grid: destination view size does not match the source");
+    }
+}
+template <typename data_type>
+void fit_destination(GridView3D<data_type> const & dst, size_t const w, size_t const h, size_t const d){
+    if(dst.width() != w || dst.height() != h || dst.depth() != d){
+        throw std::invalid_argument("grid: destination view size does not match the source");
+    }
+}
+
+template <typename Src, typename Dst>
+void check_distinct(Src const & src, Dst const & dst){
+    if(src.data() != nullptr && static_cast<void const *>(src.data()) == static_cast<void const *>(dst.data())){
+        throw std::invalid_argument("grid: src and dst must not share storage");
+    }
+}
+
+} // namespace detail
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_VIEW_H
@@ -0,0 +1,207 @@
+/**
+ * @brief 隣接要素への依存がある処理を、タイルの波面に沿って並列に実行するためのスケジューラ
+*/
+
+#ifndef UTILITY_GRID_WAVEFRONT_H
+#define UTILITY_GRID_WAVEFRONT_H
+
+#include <vector>
+#include <deque>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include "thread_pool.h"
+
+namespace Utility{
+
+namespace detail{
+
+/**
+ * @brief ワークスティーリング用のキュー
+ * @note 持ち主は後ろから取り出し(LIFO)、他のスレッドは前から盗む(FIFO)
+*/
+class WorkStealingQueue{
+private:
+    std::deque<size_t> m_items;
+    std::mutex m_mutex;
+
+public:
+    void push(size_t const item){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_items.push_back(item);
+    }
+
+    bool pop(size_t & item){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_items.empty()) return false;
+        item = m_items.back();
+        m_items.pop_back();
+        return true;
+    }
+
+    bool steal(size_t & item){
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_items.empty()) return false;
+        item = m_items.front();
+        m_items.pop_front();
+        return true;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief タイル間の依存関係を満たしながら、ワークスティーリングで各タイルを並列に処理する
+ * @note 先行するタイルが全て終わったタイルから順に実行されるため、反対角線上のタイル列が波面として進む
+*/
+class WavefrontScheduler{
+public:
+    using size_type = size_t;
+    using offset_type = std::array<int, 3>; // (dx, dy, dz)
+
+private:
+    struct State{
+        size_type count[3];                          // x, y, z方向のタイル数
+        size_type total = 0;
+        std::vector<offset_type> successors;         // 後続タイルへの相対位置
+        std::unique_ptr<std::atomic<int>[]> pending; // 未完了の先行タイル数
+        std::vector<detail::WorkStealingQueue> queues;
+        std::atomic<size_type> completed{0};
+        std::atomic<int> running{0};
+        std::atomic<bool> abort{false};
+        std::exception_ptr exception;
+        std::mutex exception_mutex;
+        std::function<void(size_type, size_type, size_type)> run_tile;
+
+        State(size_type const n) : queues(n){}
+
+        bool acquire(size_type const self, size_type & tile){
+            if(queues[self].pop(tile)) return true;
+            for(size_type i=1; i<queues.size(); ++i){
+                if(queues[(self + i) % queues.size()].steal(tile)) return true;
+            }
+            return false;
+        }
+
+        void work(size_type const self){
+            while(completed.load() < total && !abort.load()){
+                ++running;
+                size_type tile;
+                if(abort.load() || !acquire(self, tile)){
+                    --running;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                size_type const x = tile % count[0];
+                size_type const y = (tile / count[0]) % count[1];
+                size_type const z = tile / (count[0] * count[1]);
+                try{
+                    run_tile(z, y, x);
+                }catch(...){
+                    std::lock_guard<std::mutex> lock(exception_mutex);
+                    if(!exception) exception = std::current_exception();
+                    abort = true;
+                }
+
+                for(auto const & s : successors){
+                    size_type const sx = x + s[0], sy = y + s[1], sz = z + s[2];
+                    if(sx >= count[0] || sy >= count[1] || sz >= count[2]) continue;
+                    size_type const next = sx + sy * count[0] + sz * count[0] * count[1];
+                    if(--pending[next] == 0) queues[self].push(next);
+                }
+                ++completed;
+                --running;
+            }
+        }
+    };
+
+public:
+    /**
+     * @brief 要素単位の依存関係から、タイル単位の先行タイルへの相対位置を求める
+     * @param[in] dependencies 各要素が依存する要素の相対位置(dx, dy, dz) 各成分が0以下で、全て0ではないこと
+     * @param[in] tile_size x, y, z方向のタイルの大きさ
+    */
+    static std::vector<offset_type> tile_dependencies(std::vector<offset_type> const & dependencies, offset_type const & tile_size){
+        std::vector<offset_type> result;
+        for(auto const & d : dependencies){
+            if(d[0] > 0 || d[1] > 0 || d[2] > 0 || (d[0] == 0 && d[1] == 0 && d[2] == 0)){
+                throw std::invalid_argument("WavefrontScheduler: dependencies must point to preceding cells (every component <= 0)");
+            }
+            if(-d[0] > tile_size[0] || -d[1] > tile_size[1] || -d[2] > tile_size[2]){
+                throw std::invalid_argument("WavefrontScheduler: dependency reaches beyond the adjacent tile");
+            }
+            // 負の成分の軸は、同じタイルと一つ前のタイルのどちらにもまたがりうる
+            for(int dz=(d[2] < 0 ? -1 : 0); dz<=0; ++dz){
+                for(int dy=(d[1] < 0 ? -1 : 0); dy<=0; ++dy){
+                    for(int dx=(d[0] < 0 ? -1 : 0); dx<=0; ++dx){
+                        if(dx == 0 && dy == 0 && dz == 0) continue;
+                        offset_type const t{dx, dy, dz};
+                        if(std::find(result.begin(), result.end(), t) == result.end()) result.push_back(t);
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief 全てのタイルを依存関係を満たす順序で並列に処理する
+     * @param[in] pool 使用するスレッドプール
+     * @param[in] count x, y, z方向のタイル数
+     * @param[in] predecessors 先行タイルへの相対位置 tile_dependencies()の戻り値
+     * @param[in] run_tile z,y,x(タイルのインデックス)を引数として受け取る関数
+     * @note 全てのタイルが終わるまで戻らない 例外は最初の一つを呼び出し元へ再送出する
+    */
+    template <typename Function>
+    static void run(ThreadPool & pool, offset_type const & count, std::vector<offset_type> const & predecessors, Function const & run_tile){
+        size_type const total = size_type(count[0]) * count[1] * count[2];
+        if(total == 0) return;
+
+        size_type const runners = std::min(pool.size() + 1, total);
+        auto state = std::make_shared<State>(runners);
+        for(int i=0; i<3; ++i) state->count[i] = count[i];
+        state->total = total;
+        state->run_tile = [&run_tile](size_type const z, size_type const y, size_type const x){ run_tile(z, y, x); };
+        for(auto const & p : predecessors){
+            state->successors.push_back(offset_type{-p[0], -p[1], -p[2]});
+        }
+
+        // 範囲内の先行タイルの数を数え、先行タイルのないものを最初に積む
+        state->pending.reset(new std::atomic<int>[total]);
+        size_type seeded = 0;
+        for(size_type i=0; i<total; ++i){
+            long const x = i % count[0];
+            long const y = (i / count[0]) % count[1];
+            long const z = i / (size_type(count[0]) * count[1]);
+            int n = 0;
+            for(auto const & p : predecessors){
+                if(x + p[0] >= 0 && y + p[1] >= 0 && z + p[2] >= 0) ++n;
+            }
+            state->pending[i] = n;
+            if(n == 0) state->queues[(seeded++) % runners].push(i);
+        }
+
+        for(size_type i=1; i<runners; ++i){
+            pool.submit([state, i]{ state->work(i); });
+        }
+        state->work(0);
+
+        // 中断した場合は実行中のタイルが終わるのを待つ
+        while(state->running.load() != 0){
+            std::this_thread::yield();
+        }
+        if(state->exception) std::rethrow_exception(state->exception);
+    }
+};
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_GRID_WAVEFRONT_H
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <utility>
 #include <cassert>
+#include <charconv>
+#include <system_error>
 
 #ifndef UTILITY_POINT2I_H
 #define UTILITY_POINT2I_H
@@ -292,6 +294,31 @@ public:
         left >> right.x >> right.y;
         return left;
     }
+
+    /**
+     * @brief operator<<と同じ"x y"の形式で[first, last)へ書き込む
+     * @note std::to_charsと同じく、ロケールを使わず確保も行わない
+    */
+    friend std::to_chars_result to_chars(char * first, char * last, Point2i const & value){
+        auto result = std::to_chars(first, last, value.x);
+        if(result.ec != std::errc() || result.ptr == last) return {last, std::errc::value_too_large};
+        *result.ptr++ = ' ';
+        return std::to_chars(result.ptr, last, value.y);
+    }
+
+    /**
+     * @brief operator>>と同じく空白で区切られた"x y"を[first, last)から読み込む
+    */
+    friend std::from_chars_result from_chars(char const * first, char const * last, Point2i & value){
+        Point2i v;
+        auto result = std::from_chars(first, last, v.x);
+        if(result.ec != std::errc()) return result;
+        char const * p = result.ptr;
+        while(p != last && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++p;
+        result = std::from_chars(p, last, v.y);
+        if(result.ec == std::errc()) value = v;
+        return result;
+    }
 };
 
 
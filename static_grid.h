@@ -0,0 +1,713 @@
+/**
+ * @brief 大きさがコンパイル時に決まる二次元・三次元配列
+ * @note 要素はstd::arrayとしてオブジェクトの中に持ち、ヒープから確保しない 並びは行優先で、格納位置の計算は定数の乗算と加算になる
+ * @note 要素アクセスとforeachはconstexpr 走査の回数が定数のため、コンパイラがループを展開・ベクトル化できる
+ * @note 大きさを変える操作(insert_*, remove_*, resize など)はない 計数・時間の記録(UTILITY_GRID_INSTRUMENT, UTILITY_GRID_TRACE)の対象外
+*/
+
+#ifndef UTILITY_STATIC_GRID_H
+#define UTILITY_STATIC_GRID_H
+
+#include <array>
+#include <iostream>
+#include <utility>
+#include <tuple>
+#include <cstddef>
+#include <type_traits>
+#include "grid_bounds.h"
+#include "grid_view.h"
+
+namespace Utility{
+
+/**
+ * @brief 二次元配列クラス at(y,x)でアクセス 大きさはW×Hで固定
+ * @tparam bounds_policy at(), operator[]での範囲検査 BoundsChecked(例外), BoundsAssert(assert), BoundsUnchecked(検査なし)
+*/
+template <typename data_type, size_t W, size_t H, typename bounds_policy = DefaultBoundsPolicy>
+class StaticGrid2D{
+    static_assert(W > 0 && H > 0, "StaticGrid2D: width and height must be positive");
+
+public:
+    using value_type = data_type;
+    using bounds_policy_type = bounds_policy;
+    using size_type = size_t;
+    using container_type = std::array<data_type, W * H>;
+
+    static constexpr size_type static_width = W;
+    static constexpr size_type static_height = H;
+    static constexpr size_type row_stride = W;  // 行の間隔(要素数)
+
+private:
+    container_type m_data{};   // [y * row_stride + x]でデータへアクセス
+
+    static constexpr size_type index(size_type const y, size_type const x){
+        return y * row_stride + x;
+    }
+
+public:
+    /**
+     * @brief 要素を値初期化して構築
+    */
+    constexpr StaticGrid2D() = default;
+
+    /**
+     * @brief 全ての要素をinitで構築
+    */
+    explicit constexpr StaticGrid2D(data_type const & init){
+        fill(init);
+    }
+
+    /**
+     * @brief 全ての要素にvalueを代入する
+    */
+    constexpr void fill(data_type const & value){
+        for(size_type i=0; i<W*H; ++i){
+            m_data[i] = value;
+        }
+    }
+
+    /**
+     * @brief 一番最初の要素のlvalue参照
+    */
+    constexpr data_type & front(){
+        return m_data[0];
+    }
+    constexpr data_type const & front() const {
+        return m_data[0];
+    }
+
+    /**
+     * @brief 一番最後の要素のlvalue参照
+    */
+    constexpr data_type & back(){
+        return m_data[W * H - 1];
+    }
+    constexpr data_type const & back() const {
+        return m_data[W * H - 1];
+    }
+
+    /**
+     * @brief 要素アクセス 範囲の検査はbounds_policyに従う
+    */
+    constexpr data_type & at(int const y, int const x){
+        bounds_policy::check(y, H);
+        bounds_policy::check(x, W);
+        return m_data[index(y, x)];
+    }
+
+    /**
+     * @brief (x,y)のペアにより要素アクセス
+     * @param[in] pos (x,y)のペア
+    */
+    constexpr data_type & at(std::pair<int, int> const pos){
+        return at(pos.second, pos.first);
+    }
+
+    /**
+     * @brief 要素アクセス const
+    */
+    constexpr data_type const & at(int const y, int const x) const {
+        bounds_policy::check(y, H);
+        bounds_policy::check(x, W);
+        return m_data[index(y, x)];
+    }
+
+    /**
+     * @brief (x,y)のペアにより要素アクセス const
+     * @param[in] pos (x,y)のペア
+    */
+    constexpr data_type const & at(std::pair<int, int> const pos) const {
+        return at(pos.second, pos.first);
+    }
+
+    /**
+     * @brief 範囲を検査しない要素アクセス foreachのコールバックなど、添字が範囲内と分かっている場所で使う
+    */
+    constexpr data_type & at_unchecked(size_type const y, size_type const x){
+        return m_data[index(y, x)];
+    }
+    constexpr data_type const & at_unchecked(size_type const y, size_type const x) const {
+        return m_data[index(y, x)];
+    }
+
+    /**
+     * @brief [y][x]で要素アクセス
+     * @return 行の先頭のポインタ
+     * @note yはbounds_policyに従って検査する xは検査しない
+    */
+    constexpr data_type * operator [] (int const y){
+        bounds_policy::check(y, H);
+        return m_data.data() + index(y, 0);
+    }
+    constexpr data_type const * operator [] (int const y) const {
+        bounds_policy::check(y, H);
+        return m_data.data() + index(y, 0);
+    }
+
+    /**
+     * @brief 横方向のサイズを返す
+    */
+    static constexpr size_t width(){
+        return W;
+    }
+
+    /**
+     * @brief 縦方向のサイズを返す
+    */
+    static constexpr size_t height(){
+        return H;
+    }
+
+    /**
+     * @brief pairでサイズを返す
+     * @return width, heightのペア
+    */
+    static constexpr std::pair<size_t, size_t> size(){
+        return std::make_pair(W, H);
+    }
+
+    /**
+     * @brief 配列の先頭要素のポインタを返す
+     * @note 要素は行優先で並んでいる
+    */
+    constexpr data_type * data(){
+        return m_data.data();
+    }
+    constexpr data_type const * data() const {
+        return m_data.data();
+    }
+
+    /**
+     * @brief 範囲内に収まるかを調べる
+     * @return 収まっていたらtrue
+    */
+    static constexpr bool in(int const y, int const x){
+        return y >= 0 && static_cast<size_type>(y) < H && x >= 0 && static_cast<size_type>(x) < W;
+    }
+
+    /**
+     * @brief (x, y)が範囲内に収まるかを調べる
+     * @param[in] pos (x, y)のペア
+     * @return 収まっていたらtrue
+    */
+    static constexpr bool in(std::pair<int, int> const & pos){
+        return in(pos.second, pos.first);
+    }
+
+    /**
+     * @brief 全体のビュー
+    */
+    GridView2D<data_type> view(){
+        return GridView2D<data_type>(m_data.data(), W, H, row_stride);
+    }
+    GridView2D<data_type const> view() const {
+        return GridView2D<data_type const>(m_data.data(), W, H, row_stride);
+    }
+
+    /**
+     * @brief [y_first, y_last)x[x_first, x_last)の領域のビュー 範囲外ではstd::out_of_rangeを投げる
+     * @note 要素はコピーしない
+    */
+    GridView2D<data_type> subgrid(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last){
+        return view().subgrid(y_first, x_first, y_last, x_last);
+    }
+    GridView2D<data_type const> subgrid(size_type const y_first, size_type const x_first, size_type const y_last, size_type const x_last) const {
+        return view().subgrid(y_first, x_first, y_last, x_last);
+    }
+
+    /**
+     * @brief 出力
+    */
+    void print() const {
+        for(size_type i=0; i<H; ++i){
+            for(size_type j=0; j<W; ++j){
+                std::cout << at_unchecked(i, j) << ' ';
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    /**
+     * @brief サイズの出力
+    */
+    void print_size() const {
+        std::cout << "(width:" << W << " height:" << H << ")" << std::endl;
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func y,xか、y,xと要素の参照を引数として受け取る関数
+     * @note 行優先で走査する 要素の参照はbounds_policyによらず検査せずに渡す(添字は常に範囲内)
+    */
+    template <typename Function>
+    constexpr void foreach(const Function & func){
+        for(size_type i=0; i<H; ++i){
+            for(size_type j=0; j<W; ++j){
+                if constexpr(std::is_invocable<Function const &, size_type, size_type, data_type &>::value){
+                    func(i, j, m_data[index(i, j)]);
+                }else{
+                    func(i, j);
+                }
+            }
+        }
+    }
+
+
+#ifdef UTILITY_POINT2I_H
+
+    // point2i.hがincludeされている場合
+
+    /**
+     * @brief (x, y)で要素アクセス
+     * @param[in] pos (x,y)のPoint2i
+    */
+    data_type & at(Point2i const & pos){
+        return at(pos.y, pos.x);
+    }
+
+    /**
+     * @brief (x, y)で要素アクセス const
+     * @param[in] pos (x,y)のPoint2i
+    */
+    data_type const & at(Point2i const & pos) const {
+        return at(pos.y, pos.x);
+    }
+
+    /**
+     * @brief (x, y)で要素アクセス
+     * @param[in] pos (x,y)のPoint2i
+    */
+    data_type & operator [] (Point2i const & pos){
+        bounds_policy::check(pos.y, H);
+        bounds_policy::check(pos.x, W);
+        return m_data[index(pos.y, pos.x)];
+    }
+
+    /**
+     * @brief (x, y)で要素アクセス const
+     * @param[in] pos (x,y)のPoint2i
+    */
+    data_type const & operator [] (Point2i const & pos) const {
+        bounds_policy::check(pos.y, H);
+        bounds_policy::check(pos.x, W);
+        return m_data[index(pos.y, pos.x)];
+    }
+
+    /**
+     * @brief (x, y)のPoint2iで指定した[first, last)の領域のビュー
+    */
+    GridView2D<data_type> subgrid(Point2i const & first, Point2i const & last){
+        return view().subgrid(first, last);
+    }
+    GridView2D<data_type const> subgrid(Point2i const & first, Point2i const & last) const {
+        return view().subgrid(first, last);
+    }
+
+    /**
+     * @brief (x, y)が範囲内に収まるかを調べる
+     * @param[in] pos (x, y)のPoint2i
+     * @return 収まっていたらtrue
+    */
+    static bool in(Point2i const & pos){
+        return in(pos.y, pos.x);
+    }
+
+
+#endif // ifdef UTILITY_POINT2I_H
+
+
+};
+
+/**
+ * @brief StaticGrid3Dの[z]で返すxy平面 [y][x]でアクセス
+*/
+template <typename data_type, size_t W, size_t H, typename bounds_policy>
+class StaticGridSlice{
+private:
+    data_type * slice;  // 奥行zの先頭
+
+public:
+    explicit constexpr StaticGridSlice(data_type * const slice)
+        : slice(slice){}
+
+    /**
+     * @brief [y][x]で要素アクセス yはbounds_policyに従って検査する
+     * @return 行の先頭のポインタ
+    */
+    constexpr data_type * operator [] (int const y) const {
+        bounds_policy::check(y, H);
+        return slice + y * W;
+    }
+};
+
+/**
+ * @brief 三次元配列クラス at(z,y,x)でアクセス 大きさはW×H×Dで固定
+ * @tparam bounds_policy at(), operator[]での範囲検査 BoundsChecked(例外), BoundsAssert(assert), BoundsUnchecked(検査なし)
+*/
+template <typename data_type, size_t W, size_t H, size_t D, typename bounds_policy = DefaultBoundsPolicy>
+class StaticGrid3D{
+    static_assert(W > 0 && H > 0 && D > 0, "StaticGrid3D: width, height and depth must be positive");
+
+public:
+    using value_type = data_type;
+    using bounds_policy_type = bounds_policy;
+    using size_type = size_t;
+    using container_type = std::array<data_type, W * H * D>;
+
+    static constexpr size_type static_width = W;
+    static constexpr size_type static_height = H;
+    static constexpr size_type static_depth = D;
+    static constexpr size_type row_stride = W;          // 行の間隔(要素数)
+    static constexpr size_type slice_stride = W * H;    // xy平面の間隔(要素数)
+
+private:
+    container_type m_data{};   // [z * slice_stride + y * row_stride + x]でデータへアクセス
+
+    static constexpr size_type index(size_type const z, size_type const y, size_type const x){
+        return z * slice_stride + y * row_stride + x;
+    }
+
+public:
+    /**
+     * @brief 要素を値初期化して構築
+    */
+    constexpr StaticGrid3D() = default;
+
+    /**
+     * @brief 全ての要素をinitで構築
+    */
+    explicit constexpr StaticGrid3D(data_type const & init){
+        fill(init);
+    }
+
+    /**
+     * @brief 全ての要素にvalueを代入する
+    */
+    constexpr void fill(data_type const & value){
+        for(size_type i=0; i<W*H*D; ++i){
+            m_data[i] = value;
+        }
+    }
+
+    /**
+     * @brief 一番最初の要素のlvalue参照
+    */
+    constexpr data_type & front(){
+        return m_data[0];
+    }
+    constexpr data_type const & front() const {
+        return m_data[0];
+    }
+
+    /**
+     * @brief 一番最後の要素のlvalue参照
+    */
+    constexpr data_type & back(){
+        return m_data[W * H * D - 1];
+    }
+    constexpr data_type const & back() const {
+        return m_data[W * H * D - 1];
+    }
+
+    /**
+     * @brief 要素アクセス 範囲の検査はbounds_policyに従う
+    */
+    constexpr data_type & at(int const z, int const y, int const x){
+        bounds_policy::check(z, D);
+        bounds_policy::check(y, H);
+        bounds_policy::check(x, W);
+        return m_data[index(z, y, x)];
+    }
+
+    /**
+     * @brief (x,y,z)のタプルにより要素アクセス
+     * @param[in] pos (x,y,z)のタプル
+    */
+    constexpr data_type & at(std::tuple<int, int, int> const pos){
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief 要素アクセス const
+    */
+    constexpr data_type const & at(int const z, int const y, int const x) const {
+        bounds_policy::check(z, D);
+        bounds_policy::check(y, H);
+        bounds_policy::check(x, W);
+        return m_data[index(z, y, x)];
+    }
+
+    /**
+     * @brief (x,y,z)のタプルにより要素アクセス const
+     * @param[in] pos (x,y,z)のタプル
+    */
+    constexpr data_type const & at(std::tuple<int, int, int> const pos) const {
+        return at(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief 範囲を検査しない要素アクセス foreachのコールバックなど、添字が範囲内と分かっている場所で使う
+    */
+    constexpr data_type & at_unchecked(size_type const z, size_type const y, size_type const x){
+        return m_data[index(z, y, x)];
+    }
+    constexpr data_type const & at_unchecked(size_type const z, size_type const y, size_type const x) const {
+        return m_data[index(z, y, x)];
+    }
+
+    /**
+     * @brief [z][y][x]で要素アクセス
+     * @note z, yはbounds_policyに従って検査する xは検査しない
+    */
+    constexpr StaticGridSlice<data_type, W, H, bounds_policy> operator [] (int const z){
+        bounds_policy::check(z, D);
+        return StaticGridSlice<data_type, W, H, bounds_policy>(m_data.data() + index(z, 0, 0));
+    }
+    constexpr StaticGridSlice<data_type const, W, H, bounds_policy> operator [] (int const z) const {
+        bounds_policy::check(z, D);
+        return StaticGridSlice<data_type const, W, H, bounds_policy>(m_data.data() + index(z, 0, 0));
+    }
+
+    /**
+     * @brief (x, y, z)で要素アクセス
+     * @param[in] pos (x,y,z)のタプル
+    */
+    constexpr data_type & operator [] (std::tuple<int, int, int> const & pos){
+        bounds_policy::check(std::get<2>(pos), D);
+        bounds_policy::check(std::get<1>(pos), H);
+        bounds_policy::check(std::get<0>(pos), W);
+        return m_data[index(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos))];
+    }
+
+    /**
+     * @brief (x, y, z)で要素アクセス const
+     * @param[in] pos (x,y,z)のタプル
+    */
+    constexpr data_type const & operator [] (std::tuple<int, int, int> const & pos) const {
+        bounds_policy::check(std::get<2>(pos), D);
+        bounds_policy::check(std::get<1>(pos), H);
+        bounds_policy::check(std::get<0>(pos), W);
+        return m_data[index(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos))];
+    }
+
+    /**
+     * @brief 横方向のサイズを返す
+    */
+    static constexpr size_t width(){
+        return W;
+    }
+
+    /**
+     * @brief 縦方向のサイズを返す
+    */
+    static constexpr size_t height(){
+        return H;
+    }
+
+    /**
+     * @brief 奥行方向のサイズを返す
+    */
+    static constexpr size_t depth(){
+        return D;
+    }
+
+    /**
+     * @brief tupleでサイズを返す
+     * @return width, height, depthのタプル
+    */
+    static constexpr std::tuple<size_t, size_t, size_t> size(){
+        return std::make_tuple(W, H, D);
+    }
+
+    /**
+     * @brief 配列の先頭要素のポインタを返す
+     * @note 要素は行優先で並んでいる
+    */
+    constexpr data_type * data(){
+        return m_data.data();
+    }
+    constexpr data_type const * data() const {
+        return m_data.data();
+    }
+
+    /**
+     * @brief 範囲内に収まるかを調べる
+     * @return 収まっていたらtrue
+    */
+    static constexpr bool in(int const z, int const y, int const x){
+        return z >= 0 && static_cast<size_type>(z) < D && y >= 0 && static_cast<size_type>(y) < H
+            && x >= 0 && static_cast<size_type>(x) < W;
+    }
+
+    /**
+     * @brief (x, y, z)が範囲内に収まるかを調べる
+     * @param[in] pos (x, y, z)のタプル
+     * @return 収まっていたらtrue
+    */
+    static constexpr bool in(std::tuple<int, int, int> const & pos){
+        return in(std::get<2>(pos), std::get<1>(pos), std::get<0>(pos));
+    }
+
+    /**
+     * @brief 全体のビュー
+    */
+    GridView3D<data_type> view(){
+        return GridView3D<data_type>(m_data.data(), W, H, D, slice_stride, row_stride);
+    }
+    GridView3D<data_type const> view() const {
+        return GridView3D<data_type const>(m_data.data(), W, H, D, slice_stride, row_stride);
+    }
+
+    /**
+     * @brief [z_first, z_last)x[y_first, y_last)x[x_first, x_last)の領域のビュー 範囲外ではstd::out_of_rangeを投げる
+     * @note 要素はコピーしない
+    */
+    GridView3D<data_type> subgrid(size_type const z_first, size_type const y_first, size_type const x_first,
+        size_type const z_last, size_type const y_last, size_type const x_last){
+        return view().subgrid(z_first, y_first, x_first, z_last, y_last, x_last);
+    }
+    GridView3D<data_type const> subgrid(size_type const z_first, size_type const y_first, size_type const x_first,
+        size_type const z_last, size_type const y_last, size_type const x_last) const {
+        return view().subgrid(z_first, y_first, x_first, z_last, y_last, x_last);
+    }
+
+    /**
+     * @brief z枚目のxy平面を二次元のビューとして返す (y, x)でアクセスする
+     * @note 要素はコピーしない 範囲外ではstd::out_of_rangeを投げる
+    */
+    GridView2D<data_type> slice_z(size_type const z){
+        return view().slice_z(z);
+    }
+    GridView2D<data_type const> slice_z(size_type const z) const {
+        return view().slice_z(z);
+    }
+
+    /**
+     * @brief y行目のxz平面を二次元のビューとして返す (z, x)でアクセスする
+     * @note 幅はwidth()、高さはdepth()
+    */
+    GridView2D<data_type> slice_y(size_type const y){
+        return view().slice_y(y);
+    }
+    GridView2D<data_type const> slice_y(size_type const y) const {
+        return view().slice_y(y);
+    }
+
+    /**
+     * @brief x列目のyz平面を二次元のビューとして返す (z, y)でアクセスする
+     * @note 幅はheight()、高さはdepth() 要素は連続していないため、間隔を置いてアクセスする
+    */
+    GridView2D<data_type> slice_x(size_type const x){
+        return view().slice_x(x);
+    }
+    GridView2D<data_type const> slice_x(size_type const x) const {
+        return view().slice_x(x);
+    }
+
+    /**
+     * @brief 出力
+    */
+    void print() const {
+        for(size_type i=0; i<H; ++i){
+            for(size_type j=0; j<D; ++j){
+                std::cout << '[';
+                for(size_type k=0; k<W; ++k){
+                    std::cout << at_unchecked(j, i, k);
+                    std::cout << ((k == W - 1) ? "" : " ");
+                }
+                std::cout << "] ";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    /**
+     * @brief サイズの出力
+    */
+    void print_size() const {
+        std::cout << "(width:" << W << " height:" << H << " depth:" << D << ")" << std::endl;
+    }
+
+    /**
+     * @brief 各要素への一律な操作
+     * @param[in] func z,y,xか、z,y,xと要素の参照を引数として受け取る関数
+     * @note 行優先で走査する 要素の参照はbounds_policyによらず検査せずに渡す(添字は常に範囲内)
+    */
+    template <typename Function>
+    constexpr void foreach(const Function & func){
+        for(size_type i=0; i<D; ++i){
+            for(size_type j=0; j<H; ++j){
+                for(size_type k=0; k<W; ++k){
+                    if constexpr(std::is_invocable<Function const &, size_type, size_type, size_type, data_type &>::value){
+                        func(i, j, k, m_data[index(i, j, k)]);
+                    }else{
+                        func(i, j, k);
+                    }
+                }
+            }
+        }
+    }
+
+
+#ifdef EIGEN_CORE_H
+
+    // Eigen/Coreがincludeされている場合
+
+    /**
+     * @brief (x, y, z)で要素アクセス
+     * @param[in] pos (x,y,z)の整数ベクトル
+    */
+    data_type & at(Eigen::Vector3i const & pos){
+        return at(pos.z(), pos.y(), pos.x());
+    }
+
+    /**
+     * @brief (x, y, z)で要素アクセス const
+     * @param[in] pos (x,y,z)の整数ベクトル
+    */
+    data_type const & at(Eigen::Vector3i const & pos) const {
+        return at(pos.z(), pos.y(), pos.x());
+    }
+
+    /**
+     * @brief (x, y, z)で要素アクセス
+     * @param[in] pos (x,y,z)の整数ベクトル
+    */
+    data_type & operator [] (Eigen::Vector3i const & pos){
+        bounds_policy::check(pos.z(), D);
+        bounds_policy::check(pos.y(), H);
+        bounds_policy::check(pos.x(), W);
+        return m_data[index(pos.z(), pos.y(), pos.x())];
+    }
+
+    /**
+     * @brief (x, y, z)で要素アクセス const
+     * @param[in] pos (x,y,z)の整数ベクトル
+    */
+    data_type const & operator [] (Eigen::Vector3i const & pos) const {
+        bounds_policy::check(pos.z(), D);
+        bounds_policy::check(pos.y(), H);
+        bounds_policy::check(pos.x(), W);
+        return m_data[index(pos.z(), pos.y(), pos.x())];
+    }
+
+    /**
+     * @brief (x, y, z)が範囲内に収まるかを調べる
+     * @param[in] pos (x,y,z)の整数ベクトル
+     * @return 収まっていたらtrue
+    */
+    static bool in(Eigen::Vector3i const & pos){
+        return in(pos.z(), pos.y(), pos.x());
+    }
+
+
+#endif // ifdef EIGEN_CORE_H
+
+
+};
+
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_STATIC_GRID_H
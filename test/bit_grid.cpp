@@ -0,0 +1,40 @@
+#include "../point2i.h"
+#include "../bit_grid.h"
+
+using namespace Utility;
+
+int main(){
+    BitGrid2D a(70, 3);
+    a.at(0, 1) = true;
+    a[1][64] = true;
+    a.set(2, 69);
+    a.at(Point2i(5, 2)) = true;
+    std::cout << a.count() << " " << a.count_row(2) << std::endl;
+    std::cout << a.find_first(2) << " " << a.find_first(2, 6) << " " << a.find_first(1, 65) << std::endl;
+
+    // 語単位の論理演算とシフト
+    BitGrid2D b = a;
+    b.shift_columns(1);
+    b.shift_rows(-1);
+    BitGrid2D c = (a | b) & ~a;
+    c.foreach_set([](size_t y, size_t x){
+        std::cout << '(' << x << ", " << y << ") ";
+    });
+    std::cout << std::endl;
+    std::cout << "---" << std::endl;
+
+    BitGrid2D small(5, 3, true);
+    small[1][2] = false;
+    small.resize(6, 2);
+    small.print();
+    small.print_size();
+    std::cout << "---" << std::endl;
+
+    BitGrid3D v(4, 2, 2);
+    v[0][1][3] = true;
+    v.shift_slices(1);
+    v.print();
+    std::cout << v.count() << " " << v.at(1, 1, 3) << std::endl;
+
+    return 0;
+}
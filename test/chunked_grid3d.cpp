@@ -0,0 +1,26 @@
+#include "../chunked_grid3d.h"
+
+using namespace Utility;
+
+int main(){
+    // 16384x16384x256の空間でも、書き込んだチャンクの分しか確保しない
+    ChunkedGrid3D<int> world(16384, 16384, 256, 0);
+    world.print_size();
+    world.at(10, 200, 300) = 1;
+    world.at(10, 200, 301) = 2;
+    world.set(255, 16383, 16383, 3);
+    std::cout << world.chunk_count() << std::endl;
+
+    ChunkedGrid3D<int> const & view = world;
+    std::cout << view.at(10, 200, 301) << " " << view.at(100, 100, 100) << std::endl;
+    std::cout << world.chunk_count() << std::endl;
+    std::cout << world.in(256, 0, 0) << std::endl;
+    std::cout << "---" << std::endl;
+
+    // 確保されているチャンクだけを走査する
+    ChunkedGrid3D<int, 1> small(4, 4, 4, 0);
+    small.at(3, 2, 1) = 5;
+    small.print();
+
+    return 0;
+}
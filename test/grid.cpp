@@ -21,5 +21,50 @@ int main(){
     grid.at(2, 1) = 9;
     grid.print();
 
+    grid.parallel_foreach([&](size_t y, size_t x){
+        grid.at(y, x) *= 2;
+    });
+    grid.print();
+
+    // 左と上に依存する累積和
+    Grid2D<int> dp(6, 4, 1);
+    dp.wavefront_foreach([&](size_t y, size_t x){
+        if(y > 0) dp.at(y, x) += dp.at(y - 1, x);
+        if(x > 0) dp.at(y, x) += dp.at(y, x - 1);
+    }, {{-1, 0}, {0, -1}}, 2);
+    dp.print();
+
+    // 2x2のタイル単位で格納
+    Grid2D<int, TiledLayout<2, 2>> tiled(5, 3, 0);
+    int count = 0;
+    tiled.foreach([&](size_t y, size_t x){
+        tiled.at(y, x) = count++;
+    });
+    tiled.print();
+    tiled.insert_column(1, -1);
+    tiled.resize(4, 4, 9);
+    tiled.print();
+
+    // 行の間隔を8要素に揃え、余りの列へ後方から列を追加する
+    Grid2D<int, PitchedLayout<8>> pitched(3, 2, 1);
+    std::cout << pitched.layout().pitch() << std::endl;
+    for(int i=0; i<6; ++i){
+        pitched.push_back_column(i);
+    }
+    pitched.print();
+    std::cout << pitched.layout().pitch() << std::endl;
+
+    // 範囲検査の方針 既定(BoundsChecked)は各座標を検査して例外を投げる
+    try{
+        grid.at(0, 5);
+    }catch(std::out_of_range const & e){
+        std::cout << e.what() << std::endl;
+    }
+    Grid2D<int, RowMajorLayout, std::allocator<int>, BoundsUnchecked> fast(3, 2, 1);
+    fast.foreach([](size_t y, size_t x, int & value){
+        value += static_cast<int>(y * 3 + x);
+    });
+    fast.print();
+
     return 0;
 }
@@ -48,6 +48,31 @@ int main(){
 
     grid[1][2][5] = 3;
     grid.print();
+    // 奥行を一つ取り出して[y][x]でアクセス
+    Grid3DAccessController<int> slice(&grid, 1);
+    std::cout << slice[2][5] << std::endl;
+    std::cout << "---" << std::endl;
+
+    // 2x2x2のブリック内をモートン順に格納
+    Grid3D<int, MortonLayout3D<1>> morton(3, 2, 2, 0);
+    morton.foreach([&](int const z, int const y, int const x){
+        morton.at(z, y, x) = x + y * 10 + z * 100;
+    });
+    morton.insert_row(1, 7);
+    morton.print();
+    std::cout << "---" << std::endl;
+
+    // 各軸に垂直な断面 x断面は連続していないが、二次元の配列と同様に扱える
+    Grid3D<int> volume(3, 2, 2, 0);
+    volume.foreach([&](int const z, int const y, int const x){
+        volume.at(z, y, x) = x + y * 10 + z * 100;
+    });
+    volume.slice_z(1).print();
+    volume.slice_y(0).print();
+    auto side = volume.slice_x(2);
+    side.fill(-1);
+    side.print_size();
+    volume.print();
     std::cout << "---" << std::endl;
 
     return 0;
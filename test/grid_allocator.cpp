@@ -0,0 +1,31 @@
+#include "../grid_allocator.h"
+#include "../grid2d.h"
+#include "../grid3d.h"
+
+using namespace Utility;
+
+int main(){
+    // 先頭を64バイト境界に揃える
+    Grid2D<float, RowMajorLayout, CacheAlignedAllocator<float>> a(5, 3, 1.5f);
+    std::cout << (reinterpret_cast<uintptr_t>(a.data()) % 64) << std::endl;
+    a.resize(9, 4, 0.0f);
+    a.print_size();
+    std::cout << (reinterpret_cast<uintptr_t>(a.data()) % 64) << std::endl;
+    std::cout << "---" << std::endl;
+
+    // フレームごとの一時的なグリッドはアリーナから確保し、まとめて解放する
+    MonotonicArena arena(1 << 12);
+    using ScratchGrid = Grid3D<int, RowMajorLayout3D, ArenaAllocator<int>>;
+    for(int frame=0; frame<3; ++frame){
+        {
+            ScratchGrid scratch(4, 4, 4, frame, arena);
+            ScratchGrid doubled(scratch * 2, arena);
+            std::cout << doubled.at(1, 2, 3) << " " << (arena.used() > 0) << std::endl;
+        }
+        // グリッドを破棄した後に巻き戻す
+        arena.reset();
+    }
+    std::cout << arena.used() << " " << arena.capacity() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <cstdio>
+#include "../grid_binary.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<float> a(4, 3, 0.0f);
+    a.foreach([&](size_t y, size_t x){
+        a.at(y, x) = x + y * 0.5f;
+    });
+    save_grid("grid2d.bin", a);
+
+    // ファイルをマップして、コピーせずに参照する
+    MappedGrid2D<float> mapped("grid2d.bin");
+    std::cout << mapped.width() << " " << mapped.height() << std::endl;
+    std::cout << mapped.at(2, 3) << " " << mapped[1][2] << std::endl;
+
+    Grid2D<float> b = load_grid2d<float>("grid2d.bin");
+    b.print();
+    std::cout << "---" << std::endl;
+
+    Grid3D<int, MortonLayout3D<1>> c(3, 3, 2, 0);
+    c.foreach([&](size_t z, size_t y, size_t x){
+        c.at(z, y, x) = x + y * 10 + z * 100;
+    });
+    save_grid("grid3d.bin", c);
+    MappedGrid3D<int, MortonLayout3D<1>> mapped3d("grid3d.bin");
+    std::cout << mapped3d.at(1, 2, 0) << " " << mapped3d[1][1][1] << std::endl;
+    mapped3d.to_grid().print();
+    std::cout << "---" << std::endl;
+
+    // 列の追加・削除でpitchが広がったグリッドは、既定のpitchに詰めて保存する
+    Grid2D<int, PitchedLayout<4>> pitched(3, 2, 1);
+    pitched.push_back_columns(3, 2);
+    pitched.pop_back_columns(3);
+    save_grid("pitched.bin", pitched);
+    Grid2D<int, PitchedLayout<4>> loaded = load_grid2d<int, PitchedLayout<4>>("pitched.bin");
+    std::cout << pitched.layout().pitch() << " " << loaded.layout().pitch() << std::endl;
+    loaded.print();
+    MappedGrid2D<int, PitchedLayout<4>> mapped_pitched("pitched.bin");
+    std::cout << mapped_pitched.at(1, 2) << std::endl;
+    std::cout << "---" << std::endl;
+
+    // 型やレイアウトが異なる場合は例外
+    try{
+        MappedGrid3D<int> wrong("grid3d.bin");
+    }catch(std::runtime_error const & e){
+        std::cout << e.what() << std::endl;
+    }
+
+    // 大きさが壊れたヘッダは、グリッドを構築する前に例外
+    // 幅・高さ2^32は積が溢れて0になる 2^20はstorage_sizeと一致しない
+    for(uint64_t const extent : {uint64_t(1) << 32, uint64_t(1) << 20}){
+        std::fstream file("grid2d.bin", std::ios::binary | std::ios::in | std::ios::out);
+        GridFileHeader header;
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        header.width = extent;
+        header.height = extent;
+        header.storage_size = (extent == (uint64_t(1) << 32)) ? 0 : header.storage_size;
+        file.seekp(0);
+        file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        file.close();
+        try{
+            Grid2D<float> corrupted = load_grid2d<float>("grid2d.bin");
+            std::cout << "loaded " << corrupted.width() << std::endl;
+        }catch(std::runtime_error const & e){
+            std::cout << e.what() << std::endl;
+        }
+        try{
+            MappedGrid2D<float> corrupted("grid2d.bin");
+            std::cout << "mapped " << corrupted.width() << std::endl;
+        }catch(std::runtime_error const & e){
+            std::cout << e.what() << std::endl;
+        }
+    }
+
+    std::remove("grid2d.bin");
+    std::remove("grid3d.bin");
+    std::remove("pitched.bin");
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include "../grid2d.h"
+#include "../grid3d.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<int> grid(5, 4);
+    grid.foreach([&](size_t y, size_t x){
+        grid.at(y, x) = x + y * 10;
+    });
+    grid.print();
+    std::cout << "---" << std::endl;
+
+    // 削除位置は適用前、挿入位置は適用後のインデックス
+    GridEditBatch<int> batch;
+    batch.remove_column(1);
+    batch.remove_column(3);
+    batch.insert_column(0, -1);
+    batch.remove_row(2);
+    batch.insert_row(3, -2);
+    grid.apply_edits(batch);
+    grid.print();
+    grid.print_size();
+    std::cout << "---" << std::endl;
+
+    Grid3D<int> grid3(3, 2, 3, 0);
+    grid3.foreach([&](int const z, int const y, int const x){
+        grid3.at(z, y, x) = x + y * 10 + z * 100;
+    });
+
+    GridEditBatch<int> batch3;
+    batch3.remove_depth(0);
+    batch3.insert_depth(2, 7);
+    batch3.insert_row(0, 8);
+    batch3.remove_column(2);
+    grid3.apply_edits(batch3);
+    grid3.print();
+    grid3.print_size();
+
+    return 0;
+}
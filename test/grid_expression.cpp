@@ -0,0 +1,38 @@
+#include "../grid2d.h"
+#include "../grid3d.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<float> b(4, 3, 2.0f);
+    Grid2D<float> c(4, 3, 1.0f);
+    Grid2D<float> d(4, 3, 0.5f);
+    b.foreach([&](size_t y, size_t x){
+        b.at(y, x) = x + y;
+    });
+
+    // 一時的なグリッドを作らずに一度の走査で評価
+    Grid2D<float> a = b * 0.5f + c - d;
+    a.print();
+    std::cout << "---" << std::endl;
+
+    a += b;
+    a *= 2;
+    a.print();
+    std::cout << "---" << std::endl;
+
+    Grid3D<int> x(2, 2, 2, 3);
+    Grid3D<int> y(2, 2, 2, 4);
+    Grid3D<int> z = -(x * y) + 1;
+    z.print();
+    std::cout << "---" << std::endl;
+
+    // 大きさが違う場合は例外
+    try{
+        a = b + Grid2D<float>(3, 3);
+    }catch(std::invalid_argument const & e){
+        std::cout << e.what() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+#define UTILITY_GRID_INSTRUMENT
+#include "../grid2d.h"
+#include "../grid3d.h"
+
+using namespace Utility;
+
+int main(){
+    // 終了時に呼び出し元ごとの計数をstd::cerrへ出力する
+    GridInstrumentation::global().report_at_exit();
+
+    Grid2D<int> grid(8, 8, 0);
+    for(int i=0; i<8; ++i){
+        grid.at(i, i) = 1;
+        grid[i][7 - i] = 2;
+    }
+    std::cout << grid.in(8, 0) << std::endl;
+    grid.push_back_column(0);
+    grid.insert_row(3, 0);
+    grid.resize(4, 4);
+    grid.counters().report(std::cout);
+    std::cout << "---" << std::endl;
+
+    Grid3D<int> volume(4, 4, 4, 0);
+    volume.remove_depth(1);
+    volume.push_back_depths(2, 1);
+    volume.counters().report(std::cout);
+
+    return 0;
+}
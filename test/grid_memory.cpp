@@ -0,0 +1,44 @@
+#define UTILITY_GRID_INSTRUMENT
+#include "../grid2d.h"
+#include "../grid3d.h"
+
+using namespace Utility;
+
+int main(){
+    // 行の挿入を繰り返すと容量が倍々に増え、使っていない領域が残る
+    Grid2D<int> grid(64, 64, 0);
+    for(int i=0; i<100; ++i){
+        grid.insert_row(0, i);
+    }
+    GridMemoryStats stats = grid.memory_stats();
+    std::cout << stats.size_bytes << " " << stats.capacity_bytes << " " << stats.slack_bytes() << " " << stats.reallocations << std::endl;
+
+    // 使っていない領域を解放する
+    grid.shrink_to_fit();
+    stats = grid.memory_stats();
+    std::cout << stats.size_bytes << " " << stats.capacity_bytes << " " << stats.peak_bytes << " " << stats.reallocations << std::endl;
+    std::cout << "---" << std::endl;
+
+    // PitchedLayoutでは列の追加でpitchが広がり、削除しても余りの列が残る shrink_to_fitで既定のpitchに詰め直す
+    Grid2D<int, PitchedLayout<4>> pitched(6, 10, 1);
+    pitched.push_back_columns(4, 2);
+    pitched.pop_back_columns(4);
+    stats = pitched.memory_stats();
+    std::cout << pitched.layout().pitch() << " " << stats.size_bytes << " " << stats.slack_bytes() << std::endl;
+    pitched.shrink_to_fit();
+    stats = pitched.memory_stats();
+    std::cout << pitched.layout().pitch() << " " << stats.size_bytes << " " << stats.slack_bytes() << " " << pitched.at(9, 5) << std::endl;
+    std::cout << "---" << std::endl;
+
+    // 生存中の全てのグリッドを、最後に確保し直した呼び出し元ごとに集計する
+    std::vector<Grid3D<float>> volumes;
+    for(int i=0; i<4; ++i){
+        volumes.emplace_back(16, 16, 16, 0.0f);
+        volumes.back().push_back_depth(1.0f);
+    }
+    Grid2D<double> cleared(128, 128, 0.0);
+    cleared.clear();
+    GridMemoryRegistry::global().report(std::cout, 3);
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "../point2i.h"
+#include "../grid_search.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<int> a(6, 5, 0);
+    for(int y=0; y<4; ++y) a.at(y, 2) = 1;
+    for(int x=3; x<6; ++x) a.at(2, x) = 1;
+
+    // 同じ作業領域を使い回す
+    GridSearch search;
+    std::cout << search.flood_fill(a, Point2i(0, 0), 2) << std::endl;
+    a.print();
+    std::cout << "---" << std::endl;
+
+    // 複数の始点からの距離 1は壁
+    Grid2D<int> distance;
+    search.distance_map(a, std::vector<Point2i>{Point2i(5, 0), Point2i(5, 4)},
+        [](int const v){ return v != 1; }, distance);
+    distance.print();
+    std::cout << "---" << std::endl;
+
+    search.distance_map(a, std::vector<Point2i>{Point2i(5, 0)},
+        [](int const v){ return v != 1; }, distance, GridConnectivity::Eight);
+    distance.print();
+    std::cout << "---" << std::endl;
+
+    Grid3D<int> v(3, 3, 3, 0);
+    Grid3D<int> d;
+    search.distance_map(v, {{0, 0, 0}}, [](int const c){ return c == 0; }, d, GridConnectivity::TwentySix);
+    d.print();
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "../grid_stencil.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<float> a(5, 4, 0.0f);
+    a.foreach([&](size_t y, size_t x){
+        a.at(y, x) = x + y * 5;
+    });
+
+    // 5点ラプラシアン 範囲外は端の値で補う
+    Grid2D<float> b;
+    stencil<1, 1>(a, b, [](auto const & n){
+        return n(-1, 0) + n(1, 0) + n(0, -1) + n(0, 1) - 4 * n(0, 0);
+    });
+    b.print();
+    std::cout << "---" << std::endl;
+
+    // 3x3の平均 範囲外は0とみなし、並列に実行
+    std::array<float, 9> box;
+    box.fill(1.0f / 9);
+    convolve<1, 1>(a, b, box, ConstantBoundary<float>{0.0f}, GridExecution::Parallel);
+    b.print();
+    std::cout << "---" << std::endl;
+
+    // 分離可能なカーネル 範囲外は反対側から折り返す
+    std::array<float, 3> k{0.25f, 0.5f, 0.25f};
+    convolve_separable<1>(a, b, k, k, WrapBoundary{});
+    b.print();
+    std::cout << "---" << std::endl;
+
+    // 26近傍の和
+    Grid3D<int> v(3, 3, 3, 1);
+    Grid3D<int> s;
+    stencil<1, 1, 1>(v, s, [](auto const & n){
+        int sum = 0;
+        for(int dz=-1; dz<=1; ++dz){
+            for(int dy=-1; dy<=1; ++dy){
+                for(int dx=-1; dx<=1; ++dx){
+                    if(dz != 0 || dy != 0 || dx != 0) sum += n(dz, dy, dx);
+                }
+            }
+        }
+        return sum;
+    }, ConstantBoundary<int>{0});
+    s.print();
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include "../point2i.h"
+#include "../grid_summed_area.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<int> a(5, 4, 0);
+    a.foreach([&](size_t y, size_t x){
+        a.at(y, x) = x + y * 5;
+    });
+
+    SummedAreaTable2D table(a);
+    std::cout << table.total() << std::endl;
+    // [(1, 1), (4, 3))の矩形
+    std::cout << table.sum(Point2i(1, 1), Point2i(4, 3)) << std::endl;
+    std::cout << table.mean(Point2i(1, 1), Point2i(4, 3)) << std::endl;
+
+    // 変更した要素より右下の部分だけを作り直す
+    a.at(Point2i(2, 2)) = 100;
+    table.rebuild(a, Point2i(2, 2));
+    std::cout << table.sum(Point2i(1, 1), Point2i(4, 3)) << std::endl;
+    // 範囲外の位置からは作り直さない
+    try{
+        table.rebuild(a, 0, 6);
+    }catch(std::out_of_range const & e){
+        std::cout << e.what() << std::endl;
+    }
+    std::cout << "---" << std::endl;
+
+    Grid3D<float> v(4, 4, 4, 0.5f);
+    SummedAreaTable3D box(v);
+    std::cout << box.sum(1, 1, 1, 3, 3, 3) << std::endl;
+    v.at(2, 2, 2) = 4.5f;
+    box.add(2, 2, 2, 4.0);
+    std::cout << box.mean(1, 1, 1, 3, 3, 3) << std::endl;
+    box.rebuild(v, 4, 4, 4);
+    std::cout << box.total() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "../point2i.h"
+#include "../grid_text.h"
+#include <sstream>
+
+using namespace Utility;
+
+int main(){
+    Grid2D<float> a(4, 3, 0.0f);
+    a.foreach([&](size_t y, size_t x){
+        a.at(y, x) = x * 0.25f + y;
+    });
+
+    // 一つのバッファにまとめて書き出す
+    write_text(std::cout, a);
+    std::cout << "---" << std::endl;
+
+    std::string text;
+    write_text(text, a);
+    Grid2D<float> b;
+    read_text(text, b);
+    b.print();
+    std::cout << "---" << std::endl;
+
+    // Point2iの要素も同じ形式で読み書きできる
+    Grid2D<Point2i> points;
+    read_text("2 2\n1 2 3 4\n-5 6 7 -8\n", points);
+    write_text(stdout, points);
+    std::fflush(stdout);
+    std::cout << "---" << std::endl;
+
+    Grid3D<int> c(2, 2, 2, 7);
+    write_text(std::cout, c);
+
+    // 一つのストリームから続けて読み込む 二つ目のグリッドと後に続くデータは消費しない
+    std::istringstream stream("1 2\n3\n4\n2 1\n5 6\nend\n");
+    Grid2D<int> first, second;
+    std::string trailer;
+    read_text(stream, first);
+    read_text(stream, second);
+    stream >> trailer;
+    std::cout << first.height() << " " << second.width() << " " << second.at(0, 1) << " " << trailer << std::endl;
+
+    std::FILE * file = std::tmpfile();
+    std::fputs("1 1\n8\n1 1\n9\n", file);
+    std::rewind(file);
+    read_text(file, first);
+    read_text(file, second);
+    std::cout << first.at(0, 0) << " " << second.at(0, 0) << std::endl;
+    std::fclose(file);
+
+    // 解析に失敗した場合は例外
+    try{
+        read_text("2 2\n1 2 x 4\n", b);
+    }catch(std::runtime_error const & e){
+        std::cout << e.what() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+#define UTILITY_GRID_TRACE
+#include "../grid2d.h"
+#include "../grid3d.h"
+#include "../grid_text.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<int> grid(256, 256, 0);
+    grid.push_back_columns(16, 1);
+    grid.insert_row(10, 2);
+    grid.remove_column(0);
+    grid.parallel_foreach([](int, int, int & value){ value += 1; });
+    std::string text;
+    write_text(text, grid);
+
+    Grid3D<float> volume(32, 32, 32, 0.0f);
+    volume.push_back_depth(1.0f);
+    volume.foreach([](int, int, int, float & value){ value *= 2.0f; });
+    volume.resize(16, 16, 16);
+
+    // 開始時刻の順に並ぶ 所要時間は実行ごとに異なる
+    for(auto const & event : GridTrace::global().events()){
+        std::cout << event.name << ' ' << event.width << 'x' << event.height << 'x' << event.depth << std::endl;
+    }
+
+    // chrome://tracingかui.perfetto.devで開ける
+    GridTrace::global().write_chrome_trace("grid_trace.json");
+
+    return 0;
+}
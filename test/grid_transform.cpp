@@ -0,0 +1,62 @@
+#include "../grid_transform.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<int> a(4, 3);
+    for(size_t y=0; y<a.height(); ++y){
+        for(size_t x=0; x<a.width(); ++x){
+            a[y][x] = static_cast<int>(y * 10 + x);
+        }
+    }
+    a.print();
+    std::cout << "---" << std::endl;
+
+    // 出力先の大きさは合わせられる
+    Grid2D<int> b;
+    transpose(a, b);
+    b.print();
+    std::cout << "---" << std::endl;
+    rotate90(a, b);
+    b.print();
+    std::cout << "---" << std::endl;
+    flip_horizontal(a, b, GridExecution::Parallel);
+    b.print();
+    std::cout << "---" << std::endl;
+
+    // ビューへの書き込み
+    Grid2D<int> c(5, 6, 0);
+    rotate270(a.subgrid(0, 1, 3, 4), c.subgrid(1, 1, 4, 4));
+    c.print();
+    std::cout << "---" << std::endl;
+
+    // その場での操作は正方形のみ(反転と180度回転は任意の大きさ)
+    Grid2D<float> s(3, 3);
+    for(size_t i=0; i<9; ++i) s.data()[i] = static_cast<float>(i);
+    rotate90(s);
+    s.print();
+    std::cout << "---" << std::endl;
+    rotate180(a);
+    a.print();
+    try{
+        transpose(a);
+    }catch(std::invalid_argument const & e){
+        std::cout << e.what() << std::endl;
+    }
+    std::cout << "---" << std::endl;
+
+    // 三次元の軸の入れ替え xとzを入れ替える
+    Grid3D<int> v(3, 2, 2);
+    for(size_t z=0; z<v.depth(); ++z){
+        for(size_t y=0; y<v.height(); ++y){
+            for(size_t x=0; x<v.width(); ++x){
+                v[z][y][x] = static_cast<int>(z * 100 + y * 10 + x);
+            }
+        }
+    }
+    Grid3D<int> w;
+    permute_axes(v, w, GridAxis::Depth, GridAxis::Row, GridAxis::Column);
+    w.print();
+
+    return 0;
+}
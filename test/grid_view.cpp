@@ -0,0 +1,50 @@
+#include "../point2i.h"
+#include "../grid_stencil.h"
+#include "../grid_summed_area.h"
+
+using namespace Utility;
+
+int main(){
+    Grid2D<int> a(6, 5, 0);
+    a.foreach([&](size_t y, size_t x){
+        a.at(y, x) = x + y * 6;
+    });
+
+    // [(1, 1), (4, 3))の領域 要素はコピーしない
+    auto v = a.subgrid(Point2i(1, 1), Point2i(4, 3));
+    v.print_size();
+    v.print();
+    std::cout << "---" << std::endl;
+
+    // ビューへの書き込みは元の配列に反映される
+    v += 100;
+    v[0][0] = -1;
+    a.print();
+    std::cout << "---" << std::endl;
+
+    // 一列おきのビュー
+    GridView2D<int> even(a.data(), 3, 5, 6, 2);
+    Grid2D<int> b = even * 2;
+    b.print();
+    std::cout << "---" << std::endl;
+
+    // アルゴリズムはビューをそのまま受け取る
+    Grid2D<int> c;
+    stencil<1, 1>(a.subgrid(1, 1, 4, 5), c, [](auto const & n){
+        return n(0, -1) + n(0, 1);
+    });
+    c.print();
+    SummedAreaTable2D table(v);
+    std::cout << table.total() << std::endl;
+    std::cout << "---" << std::endl;
+
+    // 三次元の部分領域と、そのz=0の断面
+    Grid3D<int> d(4, 4, 4, 1);
+    auto box = d.subgrid(1, 1, 1, 3, 3, 3);
+    box.fill(7);
+    box[0].print();
+    box.print_size();
+    std::cout << d.at(1, 1, 1) << " " << d.at(0, 0, 0) << std::endl;
+
+    return 0;
+}
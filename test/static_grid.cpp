@@ -0,0 +1,57 @@
+#include "../point2i.h"
+#include "../static_grid.h"
+
+using namespace Utility;
+
+// 定数式の中で構築し、走査する
+constexpr StaticGrid2D<int, 8, 8> make_board(){
+    StaticGrid2D<int, 8, 8> board;
+    board.foreach([](size_t y, size_t x, int & value){
+        value = static_cast<int>((y + x) % 2);
+    });
+    board[0][0] = 5;
+    return board;
+}
+
+constexpr int sum(StaticGrid2D<int, 8, 8> const & board){
+    int total = 0;
+    for(int y=0; y<8; ++y){
+        for(int x=0; x<8; ++x){
+            total += board.at(y, x);
+        }
+    }
+    return total;
+}
+
+static_assert(sum(make_board()) == 37, "");
+static_assert(StaticGrid2D<int, 8, 8>::in(7, 7) && !StaticGrid2D<int, 8, 8>::in(8, 0), "");
+static_assert(sizeof(StaticGrid3D<unsigned char, 16, 16, 16>) == 16 * 16 * 16, "");
+
+int main(){
+    constexpr auto board = make_board();
+    std::cout << board.at(0, 0) << " " << board[1][2] << " " << sum(board) << std::endl;
+
+    StaticGrid2D<int, 4, 3> grid(1);
+    grid.at(Point2i(3, 2)) = 7;
+    grid[Point2i(0, 1)] = 2;
+    grid.subgrid(1, 1, 3, 3).fill(0);
+    grid.print();
+    grid.print_size();
+    try{
+        grid.at(3, 0);
+    }catch(std::out_of_range const & e){
+        std::cout << e.what() << std::endl;
+    }
+    std::cout << "---" << std::endl;
+
+    // 小さなチャンク 要素はオブジェクトの中に持つ
+    StaticGrid3D<int, 3, 2, 2> chunk;
+    chunk.foreach([](size_t z, size_t y, size_t x, int & value){
+        value = static_cast<int>(z * 100 + y * 10 + x);
+    });
+    chunk[1][1][2] += 1000;
+    chunk.print();
+    std::cout << chunk.at(std::make_tuple(2, 1, 1)) << " " << chunk.slice_z(1).at(0, 1) << std::endl;
+
+    return 0;
+}
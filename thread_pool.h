@@ -0,0 +1,202 @@
+/**
+ * @brief 使い回し可能なスレッドプール
+*/
+
+#ifndef UTILITY_THREAD_POOL_H
+#define UTILITY_THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
+namespace Utility{
+
+/**
+ * @brief アルゴリズムを逐次に実行するか、ThreadPool::global()で並列に実行するか
+*/
+enum class GridExecution{
+    Sequential,
+    Parallel
+};
+
+/**
+ * @brief 固定数のワーカースレッドを持つスレッドプール
+ * @note parallel_for()では呼び出し元のスレッドも処理に参加する
+*/
+class ThreadPool{
+public:
+    using size_type = size_t;
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+
+    /**
+     * @brief parallel_for()一回分の共有状態
+     * @note 処理が終わった後に起動したワーカーからも参照されるため、shared_ptrで持つ
+    */
+    struct ParallelForState{
+        std::function<void(size_type, size_type)> body;
+        size_type begin = 0;
+        size_type end = 0;
+        size_type chunk_size = 1;
+        size_type chunk_count = 0;
+        std::atomic<size_type> next_chunk{0};
+        std::atomic<size_type> done_chunks{0};
+        std::exception_ptr exception;
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        /**
+         * @brief チャンクがなくなるまで取り出して処理する
+        */
+        void run(){
+            for(;;){
+                size_type const chunk = next_chunk.fetch_add(1);
+                if(chunk >= chunk_count) return;
+
+                size_type const first = begin + chunk * chunk_size;
+                size_type const last = std::min(end, first + chunk_size);
+                try{
+                    body(first, last);
+                }catch(...){
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if(!exception) exception = std::current_exception();
+                }
+                if(done_chunks.fetch_add(1) + 1 == chunk_count){
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished.notify_all();
+                }
+            }
+        }
+    };
+
+public:
+    /**
+     * @brief ワーカー数を指定して構築
+     * @param[in] n ワーカースレッドの数 0なら呼び出し元のスレッドだけで処理する
+    */
+    explicit ThreadPool(size_type const n = default_worker_count()){
+        m_workers.reserve(n);
+        for(size_type i=0; i<n; ++i){
+            m_workers.emplace_back([this]{ worker_loop(); });
+        }
+    }
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator =(ThreadPool const &) = delete;
+
+    ~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_all();
+        for(auto & worker : m_workers){
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief プロセス全体で共有するプール
+    */
+    static ThreadPool & global(){
+        static ThreadPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief ハードウェアスレッド数から呼び出し元の分を引いたワーカー数
+    */
+    static size_type default_worker_count(){
+        size_type const n = std::thread::hardware_concurrency();
+        return (n > 1) ? n - 1 : 0;
+    }
+
+    /**
+     * @brief ワーカースレッドの数
+    */
+    size_type size() const {
+        return m_workers.size();
+    }
+
+    /**
+     * @brief タスクの追加
+    */
+    void submit(std::function<void()> task){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_condition.notify_one();
+    }
+
+    /**
+     * @brief [begin, end)を連続したチャンクに分けて並列に処理する
+     * @param[in] func [first, last)を引数として受け取る関数
+     * @param[in] grain 一つのチャンクの最小の大きさ
+     * @note 全てのチャンクが終わるまで戻らない 例外は最初の一つを呼び出し元へ再送出する
+    */
+    template <typename Function>
+    void parallel_for(size_type const begin, size_type const end, Function const & func, size_type const grain = 1){
+        if(begin >= end) return;
+
+        size_type const count = end - begin;
+        // 負荷の偏りを吸収できるよう、スレッド数の4倍程度に分ける
+        size_type const max_chunks = (size() + 1) * 4;
+        size_type const chunk_size = std::max(std::max<size_type>(grain, 1), (count + max_chunks - 1) / max_chunks);
+        size_type const chunk_count = (count + chunk_size - 1) / chunk_size;
+
+        if(chunk_count == 1 || size() == 0){
+            func(begin, end);
+            return;
+        }
+
+        auto state = std::make_shared<ParallelForState>();
+        state->body = [&func](size_type const first, size_type const last){ func(first, last); };
+        state->begin = begin;
+        state->end = end;
+        state->chunk_size = chunk_size;
+        state->chunk_count = chunk_count;
+
+        size_type const helpers = std::min(size(), chunk_count - 1);
+        for(size_type i=0; i<helpers; ++i){
+            submit([state]{ state->run(); });
+        }
+        state->run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&]{ return state->done_chunks.load() == state->chunk_count; });
+        if(state->exception) std::rethrow_exception(state->exception);
+    }
+
+private:
+    void worker_loop(){
+        for(;;){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]{ return m_stop || !m_tasks.empty(); });
+                if(m_stop && m_tasks.empty()) return;
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+} // namespace Utility
+
+
+#endif // ifndef UTILITY_THREAD_POOL_H